@@ -1,4 +1,5 @@
 #include "Node.h"
+#include "context.h"
 #include <string.h>
 #include <assert.h>
 
@@ -23,9 +24,9 @@ static const char* TypeName[] =  {
     "Dec",        "Exp",        "Args"
 };
 
-Node* createNode(NodeType type, int lineno) {
+Node* createNode(CompilerContext *ctx, NodeType type, int lineno) {
 /* Node* createNode(const char* type, int lineno) { */
-    Node* newNode = (Node*)malloc(sizeof(Node));
+    Node* newNode = (Node*)AR_alloc(ctx->nodeArena, sizeof(Node));
     memset(newNode, 0, sizeof(Node));
     newNode->type = type;
     /* strncpy(newNode->type, type, strlen(type) + 1); */ 
@@ -38,6 +39,11 @@ Node* createNode(NodeType type, int lineno) {
     return newNode;
 }
 
+// token text (id, type and relop) is interned, equal names share one atom
+void setNodeName(CompilerContext *ctx, Node *node, const char *text, int len) {
+    node->val.name = AT_intern(ctx->atoms, text, len);
+}
+
 void addChild(Node* pr, int cnt, ...) {
     if(pr == NULL || cnt < 1) return;
     /* printf("cnt = %d\n", cnt); */
@@ -98,20 +104,11 @@ void traverseTree(Node *node, int depth) {
    }
 }
 
-void freeTree(Node *node) {
-    if(node == NULL) return;
-    Node* p = node->child;
-    while(p != NULL) {
-        freeTree(p);
-        p = p->sib;
-    }
-    /* if(node->field != NULL) { */
-    /*     if(node->field->string != NULL) { */
-    /*         free(node->field->string); */
-    /*     } */
-    /*     free(node->field); */
-    /* } */
-    free(node);
+// nodes are never freed one by one, drop the whole arena instead.
+// the arena itself stays with the context for the next tree
+void freeTree(CompilerContext *ctx) {
+    AR_clear(ctx->nodeArena);
+    ctx->root = NULL;
 }
 
 Node* getNthChild(Node *node, int n) {
@@ -4,10 +4,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include "common.h"
+#include "atom.h"
 #define SIZE 32
-#define MAX_TOKEN_SIZE 256
-
-extern int yylineno;
 
 typedef enum NodeType {
     NODE_INT = 0,    NODE_FLOAT,      NODE_SEMI,
@@ -30,25 +29,30 @@ typedef enum NodeType {
 } NodeType;
 
 // REFACTOR NODE STRUCTURE
+// nodes are bump allocated from one arena and must stay within 32 bytes,
+// so token text is interned and the node only keeps the atom
 typedef struct Node {
-    int childno;
-    int lineno;
     struct Node* child;
     struct Node* sib;
-    NodeType type;
     union {
-        int intVal;
+        int intVal;     // tokens
         float floatVal;
-        char name[MAX_TOKEN_SIZE];
+        Atom name;
+        struct Type* type;  // Exp: type cached by the semantic pass
+        struct Symbol* sym; // Exp of ID (variable or call), VarDec and FunDec: resolved symbol
     } val;
+    int lineno;
+    short childno;
+    short type; // NodeType
 } Node;
 
 void addChild(Node *pr, int cnt, ...);
 /* Node* createNode(const char* type, int lineno); */
-Node* createNode(NodeType type, int lineno);
+Node* createNode(CompilerContext *ctx, NodeType type, int lineno);
+void setNodeName(CompilerContext *ctx, Node *node, const char *text, int len);
 /* Node* getNthChild(Node *node, int n); */
 /* void traverseTree(Node *node, int level); */
 void traverseTree(Node *node, int blanks);
-void freeTree(Node* node);
+void freeTree(CompilerContext *ctx);    // release all nodes at once
 
 #endif
@@ -0,0 +1,57 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static void newBlock(Arena *self, size_t size);
+
+Arena* newArena() {
+    Arena *arena = (Arena*)malloc(sizeof(Arena));
+    memset(arena, 0, sizeof(Arena));
+    return arena;
+}
+
+// large requests get a block of their own, so ARENA_BLOCK_SIZE is not a limit
+static void newBlock(Arena *self, size_t size) {
+    if(size < ARENA_BLOCK_SIZE) {
+        size = ARENA_BLOCK_SIZE;
+    }
+    ArenaBlock *block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+    assert(block);
+    block->next = self->head;
+    self->head = block;
+    self->cur = block->data;
+    self->end = block->data + size;
+}
+
+void* AR_alloc(Arena *self, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if((size_t)(self->end - self->cur) < size) {
+        newBlock(self, size);
+    }
+    void *p = self->cur;
+    self->cur += size;
+    self->used += size;
+    return p;
+}
+
+// copy len bytes of str and terminate it with '\0'
+char* AR_strndup(Arena *self, const char *str, size_t len) {
+    char *p = (char*)AR_alloc(self, len + 1);
+    memcpy(p, str, len);
+    p[len] = '\0';
+    return p;
+}
+
+// release every object of the arena, the arena itself is reusable
+void AR_clear(Arena *self) {
+    ArenaBlock *block = self->head;
+    while(block) {
+        ArenaBlock *p = block;
+        block = block->next;
+        free(p);
+    }
+    self->head = NULL;
+    self->cur = self->end = NULL;
+    self->used = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#define ARENA_BLOCK_SIZE 0x10000    // 64KB per block
+#define ARENA_ALIGN 8
+
+typedef struct ArenaBlock ArenaBlock;
+typedef struct Arena Arena;
+
+// bump-pointer allocator: objects are never freed one by one,
+// the whole arena is released at once by AR_clear
+struct ArenaBlock {
+    ArenaBlock *next;
+    char data[];
+};
+
+struct Arena {
+    ArenaBlock *head;   // most recent block
+    char *cur;  // next free byte in head
+    char *end;  // end of head
+    size_t used;    // bytes handed out, for statistics
+};
+
+Arena* newArena();
+void* AR_alloc(Arena *self, size_t size);
+char* AR_strndup(Arena *self, const char *str, size_t len);
+void AR_clear(Arena *self);
+
+#endif
@@ -0,0 +1,75 @@
+#include "atom.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+static unsigned hash(const char *str, int len);
+static void grow(AtomTable *self);
+
+AtomTable* newAtomTable() {
+    AtomTable *self = (AtomTable*)malloc(sizeof(AtomTable));
+    memset(self, 0, sizeof(AtomTable));
+    self->arena = newArena();
+    return self;
+}
+
+static unsigned hash(const char *str, int len) {
+    unsigned val = 2166136261u;    // FNV-1a
+    for(int i = 0; i < len; i++) {
+        val = (val ^ (unsigned char)str[i]) * 16777619u;
+    }
+    return val;
+}
+
+static void grow(AtomTable *self) {
+    AtomSlot *old = self->slots;
+    unsigned oldCapacity = self->capacity;
+    unsigned capacity = oldCapacity ? oldCapacity * 2 : ATOM_INIT_SIZE;
+    AtomSlot *slots = (AtomSlot*)calloc(capacity, sizeof(AtomSlot));
+    for(unsigned i = 0; i < oldCapacity; i++) {
+        if(!old[i].atom) continue;
+        unsigned j = old[i].hash & (capacity - 1);
+        while(slots[j].atom) {
+            j = (j + 1) & (capacity - 1);
+        }
+        slots[j] = old[i];
+    }
+    free(old);
+    self->slots = slots;
+    self->capacity = capacity;
+}
+
+// linear probing, the table is kept at most half full
+Atom AT_intern(AtomTable *self, const char *str, int len) {
+    if(2 * (self->count + 1) > self->capacity) {
+        grow(self);
+    }
+    unsigned mask = self->capacity - 1;
+    unsigned h = hash(str, len);
+    unsigned i = h & mask;
+    AtomSlot *slots = self->slots;
+    while(slots[i].atom) {
+        if(slots[i].hash == h && slots[i].len == len
+                && memcmp(slots[i].atom, str, len) == 0) {
+            return slots[i].atom;
+        }
+        i = (i + 1) & mask;
+    }
+    slots[i].atom = AR_strndup(self->arena, str, len);
+    slots[i].hash = h;
+    slots[i].len = len;
+    self->count++;
+    return slots[i].atom;
+}
+
+Atom AT_internStr(AtomTable *self, const char *str) {
+    return AT_intern(self, str, strlen(str));
+}
+
+// free the table, every atom handed out becomes invalid
+void AT_clear(AtomTable *self) {
+    free(self->slots);
+    AR_clear(self->arena);
+    free(self->arena);
+    free(self);
+}
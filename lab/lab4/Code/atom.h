@@ -0,0 +1,33 @@
+#ifndef __ATOM_H__
+#define __ATOM_H__
+
+#include "arena.h"
+#define ATOM_INIT_SIZE 0x400    // 1024 slots, power of two
+
+// interned string: each distinct name is stored once, so two atoms
+// are the same name iff they are the same pointer
+typedef const char* Atom;
+
+typedef struct AtomSlot AtomSlot;
+typedef struct AtomTable AtomTable;
+
+struct AtomSlot {
+    Atom atom;  // NULL for an empty slot
+    unsigned hash;
+    int len;
+};
+
+// atoms of one compilation, compare atoms of the same table only
+struct AtomTable {
+    AtomSlot *slots;
+    unsigned capacity;
+    unsigned count;
+    Arena *arena;   // text of all atoms
+};
+
+AtomTable* newAtomTable();
+Atom AT_intern(AtomTable *self, const char *str, int len);
+Atom AT_internStr(AtomTable *self, const char *str);
+void AT_clear(AtomTable *self);
+
+#endif
@@ -0,0 +1,261 @@
+#define _DEFAULT_SOURCE
+#include "batch.h"
+#include "context.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+
+typedef struct Worker Worker;
+typedef struct Pool Pool;
+
+// a deque of job indices, largest job first. the owner takes from the
+// front, a thief takes the back half, so big files are never left behind
+// a long run of small ones on a busy worker.
+struct Worker {
+    pthread_t thread;
+    pthread_mutex_t lock;   // guards head and tail
+    int *queue;
+    int head;   // next job of the owner
+    int tail;   // one past the last job
+    int id;
+    int steals;
+    Pool *pool;
+};
+
+struct Pool {
+    BatchJob *jobs;
+    Worker *workers;
+    int cnt;
+    pthread_mutex_t report;     // one status line at a time
+};
+
+static double now();
+static char* outputPath(const char *src, const char *outdir);
+static void addJob(BatchJob **jobs, int *cnt, int *cap, const char *src, const char *dst, const char *outdir);
+static int cmpSize(const void *p1, const void *p2);
+static bool takeJob(Worker *self, int *job);
+static bool stealJobs(Worker *self);
+static void* workerMain(void *arg);
+static void reportJob(Pool *pool, BatchJob *job);
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// src with .s in place of .cmm, moved into outdir if any
+static char* outputPath(const char *src, const char *outdir) {
+    const char *base = src;
+    if(outdir) {
+        const char *slash = strrchr(src, '/');
+        base = slash ? slash + 1 : src;
+    }
+    size_t len = strlen(base);
+    if(len > 4 && strcmp(base + len - 4, ".cmm") == 0) {
+        len -= 4;
+    }
+    size_t dirLen = outdir ? strlen(outdir) + 1 : 0;
+    char *dst = (char*)malloc(dirLen + len + 3);
+    if(outdir) {
+        sprintf(dst, "%s/", outdir);
+    }
+    memcpy(dst + dirLen, base, len);
+    strcpy(dst + dirLen + len, ".s");
+    return dst;
+}
+
+static void addJob(BatchJob **jobs, int *cnt, int *cap, const char *src, const char *dst, const char *outdir) {
+    if(*cnt == *cap) {
+        *cap = *cap ? *cap * 2 : 64;
+        *jobs = (BatchJob*)realloc(*jobs, sizeof(BatchJob) * *cap);
+    }
+    BatchJob *job = *jobs + (*cnt)++;
+    struct stat st;
+    memset(job, 0, sizeof(BatchJob));
+    job->src = strdup(src);
+    job->dst = dst ? strdup(dst) : outputPath(src, outdir);
+    job->size = stat(src, &st) == 0 ? (long)st.st_size : 0;
+}
+
+BatchJob* loadBatch(const char *list, const char *outdir, int *cnt) {
+    BatchJob *jobs = NULL;
+    int cap = 0;
+    struct stat st;
+    *cnt = 0;
+    if(stat(list, &st) < 0) {
+        perror(list);
+        *cnt = -1;
+        return NULL;
+    }
+    if(S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(list);
+        if(!dir) {
+            perror(list);
+            *cnt = -1;
+            return NULL;
+        }
+        struct dirent *ent;
+        char path[4096];
+        while((ent = readdir(dir))) {
+            size_t len = strlen(ent->d_name);
+            if(len <= 4 || strcmp(ent->d_name + len - 4, ".cmm") != 0) continue;
+            snprintf(path, sizeof(path), "%s/%s", list, ent->d_name);
+            addJob(&jobs, cnt, &cap, path, NULL, outdir);
+        }
+        closedir(dir);
+    } else {
+        FILE *fp = fopen(list, "r");
+        if(!fp) {
+            perror(list);
+            *cnt = -1;
+            return NULL;
+        }
+        char line[8192], src[4096], dst[4096];
+        while(fgets(line, sizeof(line), fp)) {
+            int n = sscanf(line, "%4095s %4095s", src, dst);
+            if(n < 1 || src[0] == '#') continue;    // blank line or comment
+            addJob(&jobs, cnt, &cap, src, n == 2 ? dst : NULL, outdir);
+        }
+        fclose(fp);
+    }
+    return jobs;
+}
+
+void freeBatch(BatchJob *jobs, int cnt) {
+    for(int i = 0; i < cnt; i++) {
+        free(jobs[i].src);
+        free(jobs[i].dst);
+    }
+    free(jobs);
+}
+
+static int cmpSize(const void *p1, const void *p2) {
+    const BatchJob *j1 = (const BatchJob*)p1, *j2 = (const BatchJob*)p2;
+    return (j1->size < j2->size) - (j1->size > j2->size);
+}
+
+static bool takeJob(Worker *self, int *job) {
+    bool found = false;
+    pthread_mutex_lock(&self->lock);
+    if(self->head < self->tail) {
+        *job = self->queue[self->head++];
+        found = true;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return found;
+}
+
+// only called with an empty queue: nobody steals from it, so the stolen
+// jobs are copied in without our lock and published by setting head/tail
+static bool stealJobs(Worker *self) {
+    Pool *pool = self->pool;
+    for(int k = 1; k < pool->cnt; k++) {
+        Worker *victim = pool->workers + (self->id + k) % pool->cnt;
+        pthread_mutex_lock(&victim->lock);
+        int take = (victim->tail - victim->head + 1) / 2;
+        if(take > 0) {
+            victim->tail -= take;
+            memcpy(self->queue, victim->queue + victim->tail, sizeof(int) * take);
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if(take > 0) {
+            pthread_mutex_lock(&self->lock);
+            self->head = 0;
+            self->tail = take;
+            pthread_mutex_unlock(&self->lock);
+            self->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// no job is ever added, a worker is done once every queue is empty
+static void* workerMain(void *arg) {
+    Worker *self = (Worker*)arg;
+    Pool *pool = self->pool;
+    CompilerContext *ctx = newContext();
+    int job;
+    while(true) {
+        if(!takeJob(self, &job)) {
+            if(!stealJobs(self)) break;
+            continue;
+        }
+        BatchJob *p = pool->jobs + job;
+        double start = now();
+        p->errors = compileFile(ctx, p->src, p->dst);
+        p->ms = (now() - start) * 1000;
+        reportJob(pool, p);
+    }
+    freeContext(ctx);
+    return NULL;
+}
+
+static void reportJob(Pool *pool, BatchJob *job) {
+    pthread_mutex_lock(&pool->report);
+    if(job->errors == 0) {
+        printf("[ok]    %s -> %s (%.2f ms)\n", job->src, job->dst, job->ms);
+    } else if(job->errors > 0) {
+        printf("[error] %s: %d error(s) (%.2f ms)\n", job->src, job->errors, job->ms);
+    } else {
+        printf("[fail]  %s: cannot read\n", job->src);
+    }
+    pthread_mutex_unlock(&pool->report);
+}
+
+// jobs are reordered, largest file first
+int runBatch(BatchJob *jobs, int cnt, int threads) {
+    Pool pool;
+    if(threads > cnt) threads = cnt;
+    if(threads < 1) threads = 1;
+    qsort(jobs, cnt, sizeof(BatchJob), cmpSize);
+    pool.jobs = jobs;
+    pool.cnt = threads;
+    pool.workers = (Worker*)calloc(threads, sizeof(Worker));
+    pthread_mutex_init(&pool.report, NULL);
+    for(int i = 0; i < threads; i++) {
+        Worker *w = pool.workers + i;
+        pthread_mutex_init(&w->lock, NULL);
+        w->queue = (int*)malloc(sizeof(int) * (cnt > 0 ? cnt : 1));
+        w->id = i;
+        w->pool = &pool;
+    }
+    // deal the jobs round robin, every queue starts with big and small files
+    for(int i = 0; i < cnt; i++) {
+        Worker *w = pool.workers + i % threads;
+        w->queue[w->tail++] = i;
+    }
+    double start = now();
+    for(int i = 0; i < threads; i++) {
+        pthread_create(&pool.workers[i].thread, NULL, workerMain, pool.workers + i);
+    }
+    int steals = 0;
+    for(int i = 0; i < threads; i++) {
+        pthread_join(pool.workers[i].thread, NULL);
+        steals += pool.workers[i].steals;
+    }
+    double wall = now() - start;
+
+    int failed = 0;
+    double bytes = 0;
+    for(int i = 0; i < cnt; i++) {
+        failed += jobs[i].errors != 0;
+        bytes += jobs[i].size;
+    }
+    double mb = bytes / (1024 * 1024);
+    printf("%d files, %d failed, %.2f MB in %.3f s on %d threads (%.0f files/s, %.2f MB/s, %d steals)\n",
+            cnt, failed, mb, wall, threads, wall > 0 ? cnt / wall : 0, wall > 0 ? mb / wall : 0, steals);
+
+    for(int i = 0; i < threads; i++) {
+        pthread_mutex_destroy(&pool.workers[i].lock);
+        free(pool.workers[i].queue);
+    }
+    pthread_mutex_destroy(&pool.report);
+    free(pool.workers);
+    return failed;
+}
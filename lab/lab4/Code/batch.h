@@ -0,0 +1,24 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "common.h"
+
+typedef struct BatchJob BatchJob;
+
+struct BatchJob {
+    char *src;
+    char *dst;
+    long size;      // bytes of src, large files are started first
+    int errors;     // result of compileFile, -1 if src can't be read
+    double ms;      // time spent compiling src
+};
+
+// list is a directory (every .cmm file in it) or a manifest with one
+// "src [dst]" per line. dst defaults to src with .s in place of .cmm,
+// inside outdir when it is not NULL. cnt is -1 if list can't be read.
+BatchJob* loadBatch(const char *list, const char *outdir, int *cnt);
+// compile all jobs on threads workers, returns the number of failed jobs
+int runBatch(BatchJob *jobs, int cnt, int threads);
+void freeBatch(BatchJob *jobs, int cnt);
+
+#endif
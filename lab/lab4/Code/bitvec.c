@@ -0,0 +1,101 @@
+#include "bitvec.h"
+#include <stdlib.h>
+#include <string.h>
+
+BitVec* newBitVecs(int n, int bits) {
+    int cnt = (bits + BV_BITS - 1) / BV_BITS;
+    size_t head = sizeof(BitVec) * (n > 0 ? n : 1);
+    BitVec *vecs = (BitVec*)malloc(head + sizeof(BVWord) * n * cnt);
+    BVWord *words = (BVWord*)((char*)vecs + head);
+    memset(words, 0, sizeof(BVWord) * n * cnt);
+    for(int i = 0; i < n; i++) {
+        vecs[i].words = words + i * cnt;
+        vecs[i].cnt = cnt;
+    }
+    return vecs;
+}
+
+void freeBitVecs(BitVec *vecs) {
+    free(vecs);
+}
+
+bool BV_test(BitVec *self, int i) {
+    return (self->words[i / BV_BITS] >> (i % BV_BITS)) & 1;
+}
+
+// skips empty words whole, then shifts through the first one with an element
+int BV_next(BitVec *self, int i) {
+    int w = i / BV_BITS;
+    if(w >= self->cnt) return -1;
+    BVWord word = self->words[w] >> (i % BV_BITS) << (i % BV_BITS);
+    while(word == 0) {
+        if(++w == self->cnt) return -1;
+        word = self->words[w];
+    }
+    i = w * BV_BITS;
+    while(!(word & 1)) {
+        word >>= 1;
+        i++;
+    }
+    return i;
+}
+
+void BV_set(BitVec *self, int i) {
+    self->words[i / BV_BITS] |= (BVWord)1 << (i % BV_BITS);
+}
+
+void BV_reset(BitVec *self, int i) {
+    self->words[i / BV_BITS] &= ~((BVWord)1 << (i % BV_BITS));
+}
+
+void BV_clear(BitVec *self) {
+    memset(self->words, 0, sizeof(BVWord) * self->cnt);
+}
+
+void BV_fill(BitVec *self) {
+    memset(self->words, 0xff, sizeof(BVWord) * self->cnt);
+}
+
+void BV_copy(BitVec *self, BitVec *src) {
+    memcpy(self->words, src->words, sizeof(BVWord) * self->cnt);
+}
+
+bool BV_equal(BitVec *self, BitVec *other) {
+    return memcmp(self->words, other->words, sizeof(BVWord) * self->cnt) == 0;
+}
+
+bool BV_union(BitVec *self, BitVec *src) {
+    BVWord diff = 0;
+    for(int i = 0; i < self->cnt; i++) {
+        BVWord w = self->words[i] | src->words[i];
+        diff |= w ^ self->words[i];
+        self->words[i] = w;
+    }
+    return diff != 0;
+}
+
+bool BV_intersect(BitVec *self, BitVec *src) {
+    BVWord diff = 0;
+    for(int i = 0; i < self->cnt; i++) {
+        BVWord w = self->words[i] & src->words[i];
+        diff |= w ^ self->words[i];
+        self->words[i] = w;
+    }
+    return diff != 0;
+}
+
+void BV_diff(BitVec *self, BitVec *src) {
+    for(int i = 0; i < self->cnt; i++) {
+        self->words[i] &= ~src->words[i];
+    }
+}
+
+bool BV_transfer(BitVec *self, BitVec *gen, BitVec *src, BitVec *kill) {
+    BVWord diff = 0;
+    for(int i = 0; i < self->cnt; i++) {
+        BVWord w = gen->words[i] | (src->words[i] & ~kill->words[i]);
+        diff |= w ^ self->words[i];
+        self->words[i] = w;
+    }
+    return diff != 0;
+}
@@ -0,0 +1,34 @@
+#ifndef __BITVEC_H__
+#define __BITVEC_H__
+
+#include "common.h"
+
+typedef unsigned long long BVWord;
+typedef struct BitVec BitVec;
+
+#define BV_BITS 64  // bits of a word
+
+// dense set of small integers. vectors are made in groups of one size,
+// a group is a single allocation. operations go a word at a time in plain
+// loops over the words, which compilers vectorize
+struct BitVec {
+    BVWord *words;
+    int cnt;    // number of words
+};
+
+BitVec* newBitVecs(int n, int bits);    // n empty vectors of bits bits
+void freeBitVecs(BitVec *vecs);
+bool BV_test(BitVec *self, int i);
+int BV_next(BitVec *self, int i);   // the first element from i on, -1 if none
+void BV_set(BitVec *self, int i);
+void BV_reset(BitVec *self, int i);
+void BV_clear(BitVec *self);
+void BV_fill(BitVec *self);     // every bit, the unused ones of the last word too
+void BV_copy(BitVec *self, BitVec *src);
+bool BV_equal(BitVec *self, BitVec *other);
+bool BV_union(BitVec *self, BitVec *src);   // true if self changed
+bool BV_intersect(BitVec *self, BitVec *src);
+void BV_diff(BitVec *self, BitVec *src);    // self minus src
+bool BV_transfer(BitVec *self, BitVec *gen, BitVec *src, BitVec *kill);    // self = gen + (src - kill)
+
+#endif
@@ -0,0 +1,420 @@
+#include "cfg.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void buildCFG(CFG *cfg, IRFunc *func);
+static void clearCFG(CFG *cfg);
+static IR* lastCode(IRFunc *func, BasicBlock *block);
+static void findBlocks(CFG *cfg, IRFunc *func);
+static void findEdges(CFG *cfg, IRFunc *func);
+static void findOrder(CFG *cfg);
+static void findDominators(CFG *cfg);
+static int intersect(CFG *cfg, int b1, int b2);
+static void numberDomTree(CFG *cfg);
+static void findLoops(CFG *cfg);
+static int cmpLoopSize(const void *p1, const void *p2);
+
+bool isControlCode(IR *code) {
+    switch(code->kind) {
+        case IR_LABEL:
+        case IR_FUNC:
+        case IR_GOTO:
+        case IR_RELOP:
+        case IR_RET:
+            return true;
+        default:
+            return false;
+    }
+}
+
+CFG* getCFG(IRFunc *func) {
+    if(!func->cfg) {
+        func->cfg = (CFG*)malloc(sizeof(CFG));
+        memset(func->cfg, 0, sizeof(CFG));
+    }
+    if(!func->cfg->valid) {
+        clearCFG(func->cfg);
+        buildCFG(func->cfg, func);
+    }
+    return func->cfg;
+}
+
+// the graph is kept until the next getCFG, a pass may finish reading it
+void invalidateCFG(IRFunc *func) {
+    if(func->cfg) {
+        func->cfg->valid = false;
+    }
+}
+
+// newIndex[i] is the number of codes kept before code i, i <= func->cnt
+void remapCFG(IRFunc *func, const int *newIndex) {
+    CFG *cfg = func->cfg;
+    if(!cfg || !cfg->valid) return;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        block->first = newIndex[block->first];
+        block->last = newIndex[block->last];
+        for(int i = block->first; i < block->last; i++) {
+            cfg->codeBlock[i] = b;
+        }
+    }
+    cfg->codeCnt = newIndex[cfg->codeCnt];
+}
+
+void freeCFG(CFG *cfg) {
+    if(!cfg) return;
+    clearCFG(cfg);
+    free(cfg);
+}
+
+static void clearCFG(CFG *cfg) {
+    free(cfg->blocks);
+    free(cfg->order);
+    free(cfg->domOrder);
+    free(cfg->codeBlock);
+    free(cfg->labelBlock);
+    free(cfg->loops);
+    free(cfg->predPool);
+    free(cfg->loopPool);
+    memset(cfg, 0, sizeof(CFG));
+}
+
+int CFG_labelBlock(CFG *cfg, int labelId) {
+    int i = labelId - cfg->labelBase;
+    if(i < 0 || i >= cfg->labelCnt) return -1;
+    return cfg->labelBlock[i];
+}
+
+// every block dominates itself, an unreachable block dominates nothing
+bool CFG_dominates(CFG *cfg, int b1, int b2) {
+    BasicBlock *d = cfg->blocks + b1, *block = cfg->blocks + b2;
+    if(d->rpo < 0 || block->rpo < 0) return false;
+    return d->domPre <= block->domPre && block->domPost <= d->domPost;
+}
+
+int CFG_loopDepth(CFG *cfg, int block) {
+    Loop *loop = cfg->blocks[block].loop;
+    return loop ? loop->depth : 0;
+}
+
+bool CFG_inLoop(CFG *cfg, int block, Loop *loop) {
+    for(Loop *p = cfg->blocks[block].loop; p; p = p->parent) {
+        if(p == loop) return true;
+    }
+    return false;
+}
+
+static void buildCFG(CFG *cfg, IRFunc *func) {
+    findBlocks(cfg, func);
+    findEdges(cfg, func);
+    findOrder(cfg);
+    findDominators(cfg);
+    numberDomTree(cfg);
+    findLoops(cfg);
+    cfg->valid = true;
+}
+
+// last code of block which is not removed, NULL if the block is empty
+static IR* lastCode(IRFunc *func, BasicBlock *block) {
+    for(int i = block->last - 1; i >= block->first; i--) {
+        if(func->codes[i].kind != IR_DEAD) return func->codes + i;
+    }
+    return NULL;
+}
+
+static void findBlocks(CFG *cfg, IRFunc *func) {
+    int cap = 16;
+    int minLabel = 0, maxLabel = -1;
+    bool ended = true;  // last code ended a block
+    cfg->blocks = (BasicBlock*)malloc(sizeof(BasicBlock) * cap);
+    cfg->codeBlock = (int*)malloc(sizeof(int) * (func->cnt > 0 ? func->cnt : 1));
+    cfg->codeCnt = func->cnt;
+    for(int i = 0; i < func->cnt; i++) {
+        IR *p = func->codes + i;
+        if(p->kind != IR_DEAD && (ended || p->kind == IR_LABEL)) {
+            if(cfg->blockCnt == cap) {
+                cap *= 2;
+                cfg->blocks = (BasicBlock*)realloc(cfg->blocks, sizeof(BasicBlock) * cap);
+            }
+            BasicBlock *block = cfg->blocks + cfg->blockCnt++;
+            memset(block, 0, sizeof(BasicBlock));
+            block->first = i;
+            if(cfg->blockCnt > 1) {
+                block[-1].last = i;
+            }
+        }
+        cfg->codeBlock[i] = cfg->blockCnt - 1;
+        if(p->kind == IR_DEAD) continue;
+        ended = p->kind == IR_GOTO || p->kind == IR_RELOP || p->kind == IR_RET;
+        if(p->kind == IR_LABEL) {
+            int id = p->arg1.id;
+            if(maxLabel < minLabel) {
+                minLabel = maxLabel = id;
+            } else if(id < minLabel) {
+                minLabel = id;
+            } else if(id > maxLabel) {
+                maxLabel = id;
+            }
+        }
+    }
+    assert(cfg->blockCnt > 0 && func->codes[0].kind == IR_FUNC);
+    cfg->blocks[cfg->blockCnt - 1].last = func->cnt;
+
+    cfg->labelBase = minLabel;
+    cfg->labelCnt = maxLabel - minLabel + 1;
+    cfg->labelBlock = (int*)malloc(sizeof(int) * (cfg->labelCnt > 0 ? cfg->labelCnt : 1));
+    memset(cfg->labelBlock, -1, sizeof(int) * cfg->labelCnt);
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        IR *p = func->codes + cfg->blocks[b].first;
+        if(p->kind == IR_LABEL) {
+            cfg->labelBlock[p->arg1.id - minLabel] = b;
+        }
+    }
+}
+
+static void findEdges(CFG *cfg, IRFunc *func) {
+    int edgeCnt = 0;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        IR *p = lastCode(func, block);
+        bool fall = b + 1 < cfg->blockCnt;
+        int target = -1;
+        if(p && p->kind == IR_GOTO) {
+            fall = false;
+            target = CFG_labelBlock(cfg, p->arg1.id);
+        } else if(p && p->kind == IR_RELOP) {
+            target = CFG_labelBlock(cfg, p->result.id);
+        } else if(p && p->kind == IR_RET) {
+            fall = false;
+        }
+        if(fall) {
+            block->succ[block->succCnt++] = b + 1;
+        }
+        if(target >= 0 && !(fall && target == b + 1)) {
+            block->succ[block->succCnt++] = target;
+        }
+        edgeCnt += block->succCnt;
+    }
+    cfg->predPool = (int*)malloc(sizeof(int) * (edgeCnt > 0 ? edgeCnt : 1));
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        for(int k = 0; k < block->succCnt; k++) {
+            cfg->blocks[block->succ[k]].predCnt++;
+        }
+    }
+    int off = 0;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        cfg->blocks[b].preds = cfg->predPool + off;
+        off += cfg->blocks[b].predCnt;
+        cfg->blocks[b].predCnt = 0;
+    }
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        for(int k = 0; k < block->succCnt; k++) {
+            BasicBlock *succ = cfg->blocks + block->succ[k];
+            succ->preds[succ->predCnt++] = b;
+        }
+    }
+}
+
+// iterative depth first search from the entry
+static void findOrder(CFG *cfg) {
+    int n = cfg->blockCnt;
+    int *stack = (int*)malloc(sizeof(int) * n);
+    int *next = (int*)calloc(n, sizeof(int));   // next successor to visit
+    int *post = (int*)malloc(sizeof(int) * n);
+    int top = 0, postCnt = 0;
+    for(int b = 0; b < n; b++) {
+        cfg->blocks[b].rpo = -1;
+        cfg->blocks[b].idom = -1;
+    }
+    stack[top++] = 0;
+    cfg->blocks[0].rpo = 0;     // visited
+    while(top > 0) {
+        int b = stack[top - 1];
+        BasicBlock *block = cfg->blocks + b;
+        if(next[b] < block->succCnt) {
+            int s = block->succ[next[b]++];
+            if(cfg->blocks[s].rpo < 0) {
+                cfg->blocks[s].rpo = 0;
+                stack[top++] = s;
+            }
+        } else {
+            post[postCnt++] = b;
+            top--;
+        }
+    }
+    cfg->order = (int*)malloc(sizeof(int) * n);
+    cfg->orderCnt = postCnt;
+    for(int i = 0; i < postCnt; i++) {
+        int b = post[postCnt - 1 - i];
+        cfg->order[i] = b;
+        cfg->blocks[b].rpo = i;
+    }
+    free(stack);
+    free(next);
+    free(post);
+}
+
+// Cooper, Harvey and Kennedy: "A Simple, Fast Dominance Algorithm"
+static void findDominators(CFG *cfg) {
+    bool changed = true;
+    cfg->blocks[0].idom = 0;
+    while(changed) {
+        changed = false;
+        for(int i = 1; i < cfg->orderCnt; i++) {
+            int b = cfg->order[i];
+            BasicBlock *block = cfg->blocks + b;
+            int idom = -1;
+            for(int k = 0; k < block->predCnt; k++) {
+                int p = block->preds[k];
+                if(cfg->blocks[p].idom < 0) continue;   // unreachable or not processed yet
+                idom = idom < 0 ? p : intersect(cfg, p, idom);
+            }
+            if(block->idom != idom) {
+                block->idom = idom;
+                changed = true;
+            }
+        }
+    }
+    cfg->blocks[0].idom = -1;
+}
+
+static int intersect(CFG *cfg, int b1, int b2) {
+    while(b1 != b2) {
+        while(cfg->blocks[b1].rpo > cfg->blocks[b2].rpo) {
+            b1 = cfg->blocks[b1].idom;
+        }
+        while(cfg->blocks[b2].rpo > cfg->blocks[b1].rpo) {
+            b2 = cfg->blocks[b2].idom;
+        }
+    }
+    return b1;
+}
+
+// preorder and postorder numbers of the dominator tree: b1 dominates b2
+// iff the interval of b1 contains the interval of b2
+static void numberDomTree(CFG *cfg) {
+    int n = cfg->blockCnt;
+    int *childCnt = (int*)calloc(n + 1, sizeof(int));
+    int *children = (int*)malloc(sizeof(int) * n);
+    int *stack = (int*)malloc(sizeof(int) * n);
+    int *next = (int*)calloc(n, sizeof(int));
+    for(int i = 1; i < cfg->orderCnt; i++) {
+        childCnt[cfg->blocks[cfg->order[i]].idom + 1]++;
+    }
+    for(int b = 0; b < n; b++) {    // childCnt[b] becomes the first child of b
+        childCnt[b + 1] += childCnt[b];
+    }
+    int *fill = (int*)malloc(sizeof(int) * n);
+    memcpy(fill, childCnt, sizeof(int) * n);
+    for(int i = 1; i < cfg->orderCnt; i++) {
+        int b = cfg->order[i];
+        children[fill[cfg->blocks[b].idom]++] = b;
+    }
+    int top = 0, clock = 0, pre = 0;
+    cfg->domOrder = (int*)malloc(sizeof(int) * n);
+    stack[top++] = 0;
+    cfg->blocks[0].domPre = clock++;
+    cfg->domOrder[pre++] = 0;
+    while(top > 0) {
+        int b = stack[top - 1];
+        if(childCnt[b] + next[b] < childCnt[b + 1]) {
+            int c = children[childCnt[b] + next[b]++];
+            cfg->blocks[c].domPre = clock++;
+            cfg->domOrder[pre++] = c;
+            stack[top++] = c;
+        } else {
+            cfg->blocks[b].domPost = clock++;
+            top--;
+        }
+    }
+    free(childCnt);
+    free(children);
+    free(stack);
+    free(next);
+    free(fill);
+}
+
+static int cmpLoopSize(const void *p1, const void *p2) {
+    const Loop *l1 = (const Loop*)p1, *l2 = (const Loop*)p2;
+    if(l1->blockCnt != l2->blockCnt) return l2->blockCnt - l1->blockCnt;
+    return l1->header - l2->header;
+}
+
+// a back edge goes to a block which dominates its source, the loop body is
+// every block reaching the source without passing the header
+static void findLoops(CFG *cfg) {
+    int n = cfg->blockCnt;
+    int *stack = (int*)malloc(sizeof(int) * (2 * n + 1));  // a block is pushed once per edge
+    int *mark = (int*)malloc(sizeof(int) * n);  // header of the body being collected
+    int *start = NULL;  // body of loop k starts at pool[start[k]]
+    int poolCap = 16, poolCnt = 0, cap = 0;
+    int *pool = (int*)malloc(sizeof(int) * poolCap);
+    Loop *loops = NULL;
+    for(int b = 0; b < n; b++) {
+        mark[b] = -1;
+    }
+    for(int i = 0; i < cfg->orderCnt; i++) {
+        int h = cfg->order[i];
+        BasicBlock *header = cfg->blocks + h;
+        int top = 0;
+        for(int k = 0; k < header->predCnt; k++) {
+            int p = header->preds[k];
+            if(CFG_dominates(cfg, h, p)) {
+                stack[top++] = p;
+            }
+        }
+        if(top == 0) continue;
+        if(cfg->loopCnt == cap) {
+            cap = cap ? cap * 2 : 8;
+            loops = (Loop*)realloc(loops, sizeof(Loop) * cap);
+            start = (int*)realloc(start, sizeof(int) * cap);
+        }
+        Loop *loop = loops + cfg->loopCnt;
+        start[cfg->loopCnt++] = poolCnt;
+        stack[top++] = h;
+        while(top > 0) {
+            int b = stack[--top];
+            if(mark[b] == h) continue;
+            mark[b] = h;
+            if(poolCnt == poolCap) {
+                poolCap *= 2;
+                pool = (int*)realloc(pool, sizeof(int) * poolCap);
+            }
+            pool[poolCnt++] = b;
+            if(b == h) continue;    // the body stops at the header
+            BasicBlock *block = cfg->blocks + b;
+            for(int k = 0; k < block->predCnt; k++) {
+                int p = block->preds[k];
+                if(mark[p] != h && cfg->blocks[p].rpo >= 0) {
+                    stack[top++] = p;
+                }
+            }
+        }
+        loop->header = h;
+        loop->blockCnt = poolCnt - start[cfg->loopCnt - 1];
+    }
+    for(int k = 0; k < cfg->loopCnt; k++) {
+        loops[k].blocks = pool + start[k];
+    }
+    cfg->loops = loops;
+    cfg->loopPool = pool;
+    // outer loops are larger: walking from the largest, the loop a header is
+    // in so far is its parent, and the last loop to claim a block is innermost
+    if(cfg->loopCnt > 1) {
+        qsort(loops, cfg->loopCnt, sizeof(Loop), cmpLoopSize);
+    }
+    for(int k = 0; k < cfg->loopCnt; k++) {
+        Loop *loop = loops + k;
+        loop->parent = cfg->blocks[loop->header].loop;
+        loop->depth = loop->parent ? loop->parent->depth + 1 : 1;
+        for(int i = 0; i < loop->blockCnt; i++) {
+            cfg->blocks[loop->blocks[i]].loop = loop;
+        }
+    }
+    free(stack);
+    free(mark);
+    free(start);
+}
@@ -0,0 +1,65 @@
+#ifndef __CFG_H__
+#define __CFG_H__
+
+#include "ir.h"
+
+typedef struct BasicBlock BasicBlock;
+typedef struct Loop Loop;
+typedef struct CFG CFG;     // control flow graph of one function
+
+// codes [first, last) of func->codes, removed codes included. a block starts
+// at the FUNCTION, at a label or after a jump, and ends before the next one
+struct BasicBlock {
+    int first;
+    int last;
+    int succ[2];    // fall through first, then the jump target
+    int succCnt;
+    int *preds;     // points into CFG.predPool
+    int predCnt;
+    int rpo;        // reverse postorder number, -1 if unreachable
+    int idom;       // immediate dominator, -1 for the entry and unreachable blocks
+    int domPre;     // dominator tree interval, for dominates()
+    int domPost;
+    Loop *loop;     // innermost loop, NULL if none
+};
+
+// natural loop, the loops of one header are merged
+struct Loop {
+    int header;
+    Loop *parent;   // enclosing loop
+    int depth;      // 1 for an outermost loop
+    int *blocks;    // header included, points into CFG.loopPool
+    int blockCnt;
+};
+
+// built on demand by getCFG. editing a jump or a label invalidates the graph,
+// any other edit keeps it. compactCode renumbers the blocks in place
+struct CFG {
+    BasicBlock *blocks;     // in code order, blocks[0] is the entry
+    int blockCnt;
+    int *order;     // reachable blocks in reverse postorder
+    int orderCnt;
+    int *domOrder;  // reachable blocks in preorder of the dominator tree
+    int *codeBlock;     // block of each code
+    int codeCnt;
+    int *labelBlock;    // block of label labelBase + i, -1 if not in the function
+    int labelBase;
+    int labelCnt;
+    Loop *loops;    // outermost first
+    int loopCnt;
+    int *predPool;
+    int *loopPool;
+    bool valid;
+};
+
+CFG* getCFG(IRFunc *func);  // rebuilt if edits invalidated it
+void invalidateCFG(IRFunc *func);
+void remapCFG(IRFunc *func, const int *newIndex);   // codes moved by compaction
+void freeCFG(CFG *cfg);
+int CFG_labelBlock(CFG *cfg, int labelId);  // -1 if the label is not in the function
+bool CFG_dominates(CFG *cfg, int b1, int b2);
+int CFG_loopDepth(CFG *cfg, int block);
+bool CFG_inLoop(CFG *cfg, int block, Loop *loop);
+bool isControlCode(IR *code);   // a code which ends or starts a block
+
+#endif
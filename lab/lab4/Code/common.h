@@ -6,4 +6,6 @@
 #define __LAB3__
 #define __LAB4__
 #define __OPT__
+
+typedef struct CompilerContext CompilerContext;    // state of one compilation, see context.h
 #endif
@@ -0,0 +1,204 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "context.h"
+#include "semantic.h"
+#include "ir.h"
+#include "oc.h"
+
+// reentrant scanner (lexical.l)
+extern void initLexer(CompilerContext*);
+extern void destroyLexer(CompilerContext*);
+extern void lexLine(CompilerContext*, int, char*, int);
+extern int yyget_lineno(void*);
+extern YYLTYPE* yyget_lloc(void*);
+
+static void resetContext(CompilerContext *ctx);
+static void clearDiagnostics(CompilerContext *ctx);
+static bool openOutput(CompilerContext *ctx);
+
+CompilerContext* newContext() {
+    CompilerContext *ctx = (CompilerContext*)malloc(sizeof(CompilerContext));
+    memset(ctx, 0, sizeof(CompilerContext));
+    ctx->nodeArena = newArena();
+    ctx->errStream = stderr;
+    return ctx;
+}
+
+void freeContext(CompilerContext *ctx) {
+    clearDiagnostics(ctx);
+    free(ctx->diags);
+    AR_clear(ctx->nodeArena);
+    free(ctx->nodeArena);
+    free(ctx);
+}
+
+// a context can compile one file after another
+static void resetContext(CompilerContext *ctx) {
+    ctx->root = NULL;
+    clearDiagnostics(ctx);
+    ctx->errnum = ctx->lexerr = ctx->semerr = 0;
+    ctx->lastline = -1;
+    ctx->output = false;
+    memset(&ctx->errloc, 0, sizeof(ctx->errloc));
+    ctx->func = NULL;
+    ctx->alloc_id = 1;
+    ctx->funcList = ctx->funcTail = NULL;
+    ctx->illegal = false;
+    ctx->labelId = ctx->tmpId = 1;
+    memset(&ctx->optStats, 0, sizeof(ctx->optStats));
+    ctx->alloc = NULL;
+    ctx->homes = NULL;
+    ctx->lvList = NULL;
+    ctx->param_off = ctx->lv_off = 0;
+}
+
+static void clearDiagnostics(CompilerContext *ctx) {
+    for(int i = 0; i < ctx->diagCnt; i++) {
+        free(ctx->diags[i].message);
+    }
+    ctx->diagCnt = 0;
+}
+
+int compileFile(CompilerContext *ctx, const char *src, const char *dst) {
+    Source *source = openSource(src);
+    if(!source) {
+        perror(src);
+        return -1;
+    }
+    ctx->src = source;
+    strncpy(ctx->filename, src, sizeof(ctx->filename)-1);
+    ctx->outPath = dst;
+    ctx->out = NULL;
+    int errors = compileSource(ctx);
+    if(ctx->out) {
+        fclose(ctx->out);
+        ctx->out = NULL;
+    }
+    closeSource(source);
+    ctx->src = NULL;
+    return errors;
+}
+
+// the file at outPath is only created when there is code to write
+static bool openOutput(CompilerContext *ctx) {
+    if(!ctx->out) {
+        ctx->out = fopen(ctx->outPath, "w");
+        if(!ctx->out) {
+            perror("fopen");
+            return false;
+        }
+    }
+    return true;
+}
+
+int compileSource(CompilerContext *ctx) {
+    resetContext(ctx);
+    ctx->atoms = newAtomTable();
+    initLexer(ctx);
+    yyparse(ctx);
+    // no lexical error and no syntax error
+    if(ctx->errnum == 0 && !ctx->lexerr) {
+        semantic_parse(ctx, ctx->root);
+#ifdef __LAB3__
+        if(!ctx->semerr && openOutput(ctx)) {
+#ifdef __LAB4__
+            if(ctx->emitIR) {
+                generate_ir(ctx, ctx->root, ctx->out);
+            } else {
+                generate_ir(ctx, ctx->root, NULL);
+                generate_oc(ctx, getFuncList(ctx), ctx->out);
+            }
+#else
+            generate_ir(ctx, ctx->root, ctx->out);
+#endif
+            clearFuncList(ctx);
+        }
+        clearSymbolTable(ctx);
+#endif
+        /* printf("syntax analyze succeed.\n"); */
+        /* traverseTree(root, 0); */
+    } else if(!ctx->output && ctx->errnum > 0){ /* synchronized token not found */
+        addDiagnostic(ctx, CMM_SYNTAX, 0, ctx->errloc.first_line, 0, "Syntax error", NULL);
+        if(ctx->errStream) {
+            fprintf(ctx->errStream, "\033[31mError type B at line %d: Syntax error.\n\033[0m", 
+                    ctx->errloc.first_line);
+        }
+    }
+    destroyLexer(ctx);
+    freeTree(ctx);
+    AT_clear(ctx->atoms);
+    ctx->atoms = NULL;
+    return ctx->errnum + ctx->lexerr + ctx->semerr + ctx->illegal;
+}
+
+// message is desc, followed by "text" if any
+void addDiagnostic(CompilerContext *ctx, CmmDiagKind kind, int errType, int line, int column, const char *desc, const char *text) {
+    if(ctx->diagCnt == ctx->diagCap) {
+        ctx->diagCap = ctx->diagCap ? ctx->diagCap * 2 : 16;
+        ctx->diags = (CmmDiagnostic*)realloc(ctx->diags, sizeof(CmmDiagnostic) * ctx->diagCap);
+    }
+    CmmDiagnostic *diag = ctx->diags + ctx->diagCnt++;
+    diag->kind = kind;
+    diag->errType = errType;
+    diag->line = line;
+    diag->column = column;
+    size_t len = strlen(desc) + (text ? strlen(text) + 3 : 0) + 1;
+    diag->message = (char*)malloc(len);
+    if(text) {
+        snprintf(diag->message, len, "%s \"%s\"", desc, text);
+    } else {
+        snprintf(diag->message, len, "%s", desc);
+    }
+}
+
+void synerror(CompilerContext *ctx, const char* msg) {
+    ctx->output = true;
+    /* errnum++; */
+    YYLTYPE *errloc = &ctx->errloc;
+    if(errloc->first_line != ctx->lastline){
+        addDiagnostic(ctx, CMM_SYNTAX, 0, errloc->first_line, errloc->first_column, msg, NULL);
+        int lineno = yyget_lineno(ctx->scanner);
+        if(ctx->errStream && errloc->first_line == lineno) {
+            lexLine(ctx, lineno, ctx->linebuf, sizeof(ctx->linebuf));
+            fprintf(ctx->errStream, "\033[31mError type B at line %d: %s.\t\033[33m[%s:%d:%d: %s]\n\033[0m", 
+                    errloc->first_line, msg, ctx->filename, errloc->first_line, errloc->first_column, ctx->linebuf);
+        } else if(ctx->errStream) {
+            fprintf(ctx->errStream, "\033[31mError type B at line %d: %s.\n\033[0m", 
+                    errloc->first_line, msg);
+        }
+        /* lastline = yylineno; */
+        ctx->lastline = errloc->first_line;
+    }
+}
+
+void lexerror(CompilerContext *ctx, int lineno, const char* desc, const char* text) {
+    ctx->lexerr = 1;
+    /* errnum++; */
+    int curline = yyget_lineno(ctx->scanner);
+    int column = yyget_lloc(ctx->scanner)->first_column;
+    addDiagnostic(ctx, CMM_LEXICAL, 0, lineno, column, desc, text);
+    ctx->lastline = curline;
+    if(!ctx->errStream) {
+        return;
+    }
+    lexLine(ctx, curline, ctx->linebuf, sizeof(ctx->linebuf));
+    if(text != NULL) {
+        fprintf(ctx->errStream, "\033[31mError type A at line %d: %s \"%s\".\t\033[33m[%s:%d:%d: %s]\n\033[0m", 
+                lineno, desc, text, ctx->filename, curline, column, ctx->linebuf);
+    } else {
+        fprintf(ctx->errStream, "\033[31mError type A at line %d: %s.\t\033[33m[%s:%d:%d: %s]\n\033[0m", 
+                lineno, desc, ctx->filename, curline, column, ctx->linebuf);
+    }
+}
+
+void Log(const char* format, ...) {
+#ifdef DEBUG
+    printf("\033[33mdebug mode> ");
+    va_list ap;
+    va_start(ap, format);
+    vprintf(format, ap);
+    va_end(ap);
+    printf("\033[0m");
+#endif
+}
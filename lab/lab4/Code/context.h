@@ -0,0 +1,82 @@
+#ifndef __CONTEXT_H__
+#define __CONTEXT_H__
+
+#include "common.h"
+#include "arena.h"
+#include "atom.h"
+#include "source.h"
+#include "Node.h"
+#include "syntax.tab.h"
+#include "symtab.h"
+#include "type_table.h"
+#include "operand_table.h"
+#include "oc.h"
+#include "libcmm.h"
+
+#define LINE_BUF_SIZE 4096
+
+// everything one compilation reads and writes. contexts share no state,
+// so independent compilations may run concurrently, one context per thread
+struct CompilerContext {
+    // input
+    char filename[128];
+    Source *src;
+    void *scanner;  // reentrant flex scanner (yyscan_t)
+    // output
+    const char *outPath;    // created once there is code to write
+    FILE *out;
+    bool emitIR;    // write the intermediate code instead of assembly
+    // syntax tree
+    Arena *nodeArena;   // all nodes of the tree
+    AtomTable *atoms;
+    Node *root;
+    // diagnostics
+    FILE *errStream;    // messages for a terminal, NULL to keep quiet
+    CmmDiagnostic *diags;   // every error, whether printed or not
+    int diagCnt, diagCap;
+    int errnum;     // syntax error num
+    int lexerr;
+    int semerr;
+    int lastline;   // line of the last reported error
+    bool output;    // a syntax error has been reported
+    YYLTYPE errloc;
+    char linebuf[LINE_BUF_SIZE];
+    // semantic analysis
+    SymTable *symbolTable;
+    Symbol *func;   // current function: for check return type
+    Type *intType;
+    Type *floatType;
+    Arena *typeArena;   // all types and fields of the program
+    TypeTable *types;
+    int alloc_id;   // for anonymous structure, simulate java anonymous class
+    // intermediate code
+    IRFunc *funcList;   // one code array per function
+    IRFunc *funcTail;
+    OperandTable *operands;     // constants and symbols of the operands
+    FILE *irStream;
+    bool illegal;
+    int labelId;    // next label id
+    int tmpId;      // next temporary id
+    OptStats optStats;
+    // object code
+    FILE *ocStream;
+    struct RegAlloc *alloc;     // of the function being generated
+    int *homes;     // slot of each interval of alloc, see alloc_frame
+    int call_cnt;   // CALLs generated so far in the function
+    bool save_ra;   // the function calls, so keeps $ra in its frame
+    LVList *lvList;     // operands not in alloc, and parameters
+    int param_off;
+    int lv_off;
+};
+
+CompilerContext* newContext();
+int compileFile(CompilerContext *ctx, const char *src, const char *dst); // errors found, -1 if src can't be read
+int compileSource(CompilerContext *ctx);    // compile ctx->src to ctx->out or ctx->outPath
+void freeContext(CompilerContext *ctx);
+
+// report errors of the parser and the scanner
+void synerror(CompilerContext *ctx, const char *msg);
+void lexerror(CompilerContext *ctx, int lineno, const char *desc, const char *text);
+void addDiagnostic(CompilerContext *ctx, CmmDiagKind kind, int errType, int line, int column, const char *desc, const char *text);
+
+#endif
@@ -0,0 +1,102 @@
+#include "dataflow.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int* visitOrder(CFG *cfg, DFDirection dir);
+static void meetInto(Dataflow *self, BitVec *x, int *blocks, int cnt, BitVec *sets, BitVec *boundary);
+
+Dataflow* newDataflow(CFG *cfg, DFDirection dir, DFMeet meet, int bits) {
+    Dataflow *self = (Dataflow*)malloc(sizeof(Dataflow));
+    int n = cfg->blockCnt;
+    self->cfg = cfg;
+    self->dir = dir;
+    self->meet = meet;
+    self->bits = bits;
+    self->gen = newBitVecs(n, bits);
+    self->kill = newBitVecs(n, bits);
+    self->in = newBitVecs(n, bits);
+    self->out = newBitVecs(n, bits);
+    self->visits = 0;
+    return self;
+}
+
+void freeDataflow(Dataflow *self) {
+    if(!self) return;
+    freeBitVecs(self->gen);
+    freeBitVecs(self->kill);
+    freeBitVecs(self->in);
+    freeBitVecs(self->out);
+    free(self);
+}
+
+// reverse postorder forward, postorder backward, so most blocks see their
+// inputs settled. unreachable blocks go last
+static int* visitOrder(CFG *cfg, DFDirection dir) {
+    int *order = (int*)malloc(sizeof(int) * cfg->blockCnt);
+    int cnt = 0;
+    for(int i = 0; i < cfg->orderCnt; i++) {
+        order[cnt++] = cfg->order[dir == DF_FORWARD ? i : cfg->orderCnt - 1 - i];
+    }
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        if(cfg->blocks[b].rpo < 0) {
+            order[cnt++] = b;
+        }
+    }
+    return order;
+}
+
+// x = meet of sets[blocks[i]], boundary (or empty) if there is no block
+static void meetInto(Dataflow *self, BitVec *x, int *blocks, int cnt, BitVec *sets, BitVec *boundary) {
+    if(cnt == 0) {
+        if(boundary) {
+            BV_copy(x, boundary);
+        } else {
+            BV_clear(x);
+        }
+        return;
+    }
+    BV_copy(x, sets + blocks[0]);
+    for(int k = 1; k < cnt; k++) {
+        if(self->meet == DF_UNION) {
+            BV_union(x, sets + blocks[k]);
+        } else {
+            BV_intersect(x, sets + blocks[k]);
+        }
+    }
+}
+
+void DF_solve(Dataflow *self, BitVec *boundary) {
+    CFG *cfg = self->cfg;
+    int n = cfg->blockCnt;
+    bool forward = self->dir == DF_FORWARD;
+    BitVec *src = forward ? self->in : self->out;   // met from the neighbours
+    BitVec *dst = forward ? self->out : self->in;   // result of the transfer
+    for(int b = 0; b < n; b++) {
+        if(self->meet == DF_INTERSECT) {
+            BV_fill(dst + b);
+        } else {
+            BV_clear(dst + b);
+        }
+    }
+    int *order = visitOrder(cfg, self->dir);
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(int i = 0; i < n; i++) {
+            int b = order[i];
+            BasicBlock *block = cfg->blocks + b;
+            if(forward && b == 0) {
+                meetInto(self, src + b, NULL, 0, dst, boundary);
+            } else if(forward) {
+                meetInto(self, src + b, block->preds, block->predCnt, dst, NULL);
+            } else {
+                meetInto(self, src + b, block->succ, block->succCnt, dst, boundary);
+            }
+            self->visits++;
+            if(BV_transfer(dst + b, self->gen + b, src + b, self->kill + b)) {
+                changed = true;
+            }
+        }
+    }
+    free(order);
+}
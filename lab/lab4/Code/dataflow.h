@@ -0,0 +1,37 @@
+#ifndef __DATAFLOW_H__
+#define __DATAFLOW_H__
+
+#include "cfg.h"
+#include "bitvec.h"
+
+typedef struct Dataflow Dataflow;
+
+typedef enum {
+    DF_FORWARD,     // in from the predecessors, out = f(in)
+    DF_BACKWARD     // out from the successors, in = f(out)
+} DFDirection;
+typedef enum {
+    DF_UNION,       // may analysis, starts empty
+    DF_INTERSECT    // must analysis, starts full
+} DFMeet;
+
+// iterative bit-vector dataflow over the blocks of a CFG. an analysis fills
+// gen and kill of each block, the transfer is gen + (x - kill)
+struct Dataflow {
+    CFG *cfg;
+    DFDirection dir;
+    DFMeet meet;
+    int bits;
+    BitVec *gen;    // one per block
+    BitVec *kill;
+    BitVec *in;
+    BitVec *out;
+    int visits;     // blocks visited by DF_solve
+};
+
+Dataflow* newDataflow(CFG *cfg, DFDirection dir, DFMeet meet, int bits);
+// boundary is in of the entry (forward) or out of the exits (backward), NULL for empty
+void DF_solve(Dataflow *self, BitVec *boundary);
+void freeDataflow(Dataflow *self);
+
+#endif
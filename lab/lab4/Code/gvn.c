@@ -0,0 +1,215 @@
+#include "ssa.h"
+#include "context.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ValueEntry ValueEntry;
+typedef struct Numbering Numbering;
+
+// an expression over leaders and the name which computed it first
+struct ValueEntry {
+    unsigned char kind;
+    Operand arg1;
+    Operand arg2;
+    Operand name;
+    int next;   // in the same bucket
+};
+
+// the table is scoped by the dominator tree: a block sees the expressions
+// of the blocks dominating it. entries are pushed in walk order, so leaving
+// a block pops the heads of their buckets
+struct Numbering {
+    CompilerContext *ctx;
+    SSA *ssa;
+    Operand *leader;    // of each SSA name, OP_INV while it is its own
+    int *buckets;
+    int mask;
+    ValueEntry *entries;
+    int cnt;
+};
+
+static Operand leaderOf(Numbering *self, Operand op);
+static unsigned hashExpr(int kind, Operand arg1, Operand arg2);
+static bool sameExpr(ValueEntry *entry, int kind, Operand arg1, Operand arg2);
+static void numberBlock(Numbering *self, int b);
+static bool numberPhi(Numbering *self, IR *phi, int b);
+static bool numberCode(Numbering *self, IR *code);
+
+// Briggs, Cooper and Simpson's dominator-based value numbering: a code
+// computing what a dominating code computed goes, its name is replaced by
+// the first one. copies go the same way
+void GVN(CompilerContext *ctx, SSA *ssa) {
+    Numbering self;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    memset(&self, 0, sizeof(Numbering));
+    self.ctx = ctx;
+    self.ssa = ssa;
+    self.leader = (Operand*)malloc(sizeof(Operand) * (ssa->nameCnt + 1));
+    for(int i = 0; i < ssa->nameCnt; i++) {
+        self.leader[i].kind = OP_INV;
+        self.leader[i].id = 0;
+    }
+    int size = 16;
+    while(size < func->cnt * 2) {
+        size *= 2;
+    }
+    self.mask = size - 1;
+    self.buckets = (int*)malloc(sizeof(int) * size);
+    memset(self.buckets, -1, sizeof(int) * size);
+    self.entries = (ValueEntry*)malloc(sizeof(ValueEntry) * (func->cnt + 1));
+
+    int *open = (int*)malloc(sizeof(int) * cfg->orderCnt);
+    int *mark = (int*)malloc(sizeof(int) * cfg->orderCnt);    // entries before each open block
+    int depth = 0;
+    for(int i = 0; i < cfg->orderCnt; i++) {
+        int b = cfg->domOrder[i];
+        while(depth > 0 && !CFG_dominates(cfg, open[depth - 1], b)) {
+            depth--;
+            while(self.cnt > mark[depth]) {
+                ValueEntry *entry = self.entries + --self.cnt;
+                self.buckets[hashExpr(entry->kind, entry->arg1, entry->arg2) & self.mask] = entry->next;
+            }
+        }
+        open[depth] = b;
+        mark[depth++] = self.cnt;
+        numberBlock(&self, b);
+    }
+    free(open);
+    free(mark);
+    free(self.leader);
+    free(self.buckets);
+    free(self.entries);
+}
+
+static Operand leaderOf(Numbering *self, Operand op) {
+    if(isSSAName(self->ssa, op)) {
+        Operand leader = self->leader[op.id - self->ssa->nameBase];
+        if(leader.kind != OP_INV) return leader;
+    }
+    return op;
+}
+
+static unsigned hashExpr(int kind, Operand arg1, Operand arg2) {
+    unsigned h = kind;
+    h = h * 31 + ((arg1.id << 3) | arg1.kind);
+    h = h * 31 + ((arg2.id << 3) | arg2.kind);
+    return h ^ (h >> 15);
+}
+
+static bool sameExpr(ValueEntry *entry, int kind, Operand arg1, Operand arg2) {
+    return entry->kind == kind
+        && entry->arg1.kind == arg1.kind && entry->arg1.id == arg1.id
+        && entry->arg2.kind == arg2.kind && entry->arg2.id == arg2.id;
+}
+
+// the phi arguments for the edges out of b take their leaders once b is
+// done, as every name they may hold is known by then
+static void numberBlock(Numbering *self, int b) {
+    SSA *ssa = self->ssa;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    BasicBlock *block = cfg->blocks + b;
+    OptStats *stats = &self->ctx->optStats;
+    for(int i = block->first; i < block->last; i++) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        bool redundant = p->kind == IR_PHI ? numberPhi(self, p, b) : numberCode(self, p);
+        if(redundant) {
+            removeCode(func, p);
+            stats->redundant++;
+        }
+    }
+    for(int k = 0; k < block->succCnt; k++) {
+        BasicBlock *succ = cfg->blocks + block->succ[k];
+        int j = 0;
+        while(succ->preds[j] != b) {
+            j++;
+        }
+        for(int i = succ->first + 1; i < succ->last; i++) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            if(p->kind != IR_PHI) break;
+            Operand *args = phiArgs(ssa, p);
+            if(args[j].kind != OP_INV) {
+                args[j] = leaderOf(self, args[j]);
+            }
+        }
+    }
+}
+
+// a phi whose arguments are all one value is that value
+static bool numberPhi(Numbering *self, IR *phi, int b) {
+    SSA *ssa = self->ssa;
+    Operand *args = phiArgs(ssa, phi);
+    Operand value;
+    value.kind = OP_INV;
+    value.id = 0;
+    for(int k = 0; k < ssa->cfg->blocks[b].predCnt; k++) {
+        if(args[k].kind == OP_INV) continue;
+        Operand arg = leaderOf(self, args[k]);
+        if(isOperandEqual(arg, phi->result)) continue;
+        if(value.kind == OP_INV) {
+            value = arg;
+        } else if(!isOperandEqual(arg, value)) {
+            return false;
+        }
+    }
+    if(value.kind == OP_INV || !isFixed(self->ssa, value)) return false;
+    self->leader[phi->result.id - ssa->nameBase] = value;
+    return true;
+}
+
+// operands take their leaders first. &v is an address, which is one
+// value whatever v holds
+static bool numberCode(Numbering *self, IR *code) {
+    SSA *ssa = self->ssa;
+    Operand *uses[2];
+    int cnt = useOperands(code, uses);
+    for(int k = 0; k < cnt; k++) {
+        *uses[k] = leaderOf(self, *uses[k]);
+    }
+    Operand *def = defOperand(code);
+    if(!def || !isSSAName(ssa, *def)) return false;
+    Operand *leader = self->leader + (def->id - ssa->nameBase);
+    Operand arg1 = code->arg1, arg2 = code->arg2;
+    switch(code->kind) {
+        case IR_ASSIGN:
+            if(!isFixed(self->ssa, arg1)) return false;
+            *leader = arg1;
+            return true;
+        case IR_ADD:
+        case IR_MUL:
+            if(arg1.kind > arg2.kind || (arg1.kind == arg2.kind && arg1.id > arg2.id)) {
+                arg1 = code->arg2;
+                arg2 = code->arg1;
+            }
+            // fall through
+        case IR_SUB:
+        case IR_DIV:
+            if(!isFixed(self->ssa, arg1) || !isFixed(self->ssa, arg2)) return false;
+            break;
+        case IR_REF:
+            arg2.kind = OP_INV;
+            arg2.id = 0;
+            break;
+        default:
+            return false;
+    }
+    unsigned h = hashExpr(code->kind, arg1, arg2) & self->mask;
+    for(int e = self->buckets[h]; e >= 0; e = self->entries[e].next) {
+        if(sameExpr(self->entries + e, code->kind, arg1, arg2)) {
+            *leader = self->entries[e].name;
+            return true;
+        }
+    }
+    ValueEntry *entry = self->entries + self->cnt;
+    entry->kind = code->kind;
+    entry->arg1 = arg1;
+    entry->arg2 = arg2;
+    entry->name = *def;
+    entry->next = self->buckets[h];
+    self->buckets[h] = self->cnt++;
+    return false;
+}
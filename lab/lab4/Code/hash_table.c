@@ -15,7 +15,7 @@ void Log(const char *format, ...);
 /* const Value INV_VALUE = { .kind = OP_INV }; */
 
 /* static HashNode* find(Key key); */
-static unsigned hash(unsigned char *key, unsigned len);
+static unsigned hash(Key key);
 
 HashNode* newHashNode(Key key, Value value) {
     HashNode* hashNode = (HashNode*)malloc(sizeof(HashNode));
@@ -33,24 +33,15 @@ HashTable* newHashTable() {
     return hashTable;
 }
 
-unsigned hash(unsigned char *key, unsigned len) {
-    unsigned val = 0;
-    for(unsigned i = 0; i < len; i++) {
-        val = 31 * val + key[i];
-    }
-    /* unsigned val = 0; */
-    /* for(unsigned i = 0; *key && i < len; i++) { */
-    /*     val = (val << 2) + *key; */
-    /*     if((i = val & ~HASH_SIZE) != 0) { */
-    /*         val = (val ^ (i >> 12)) & ~HASH_SIZE; */
-    /*     } */
-    /* } */
+// a packed operand is one 32-bit word
+unsigned hash(Key key) {
+    unsigned val = (unsigned)key.id << 3 | key.kind;
     val ^= (val >> 20) ^ (val >> 12);
     return (val ^ (val >> 7) ^ (val >> 4)) % HASH_SIZE;
 }
 
 Value HT_find(HashTable *self, Key key) {
-    unsigned hashcode = hash((unsigned char*)&key, sizeof(Key));
+    unsigned hashcode = hash(key);
     /* Value value = INV_VALUE;    // pre assign to invalid value */
     assert(hashcode < HASH_SIZE);
     HashNode *node = self->table[hashcode];
@@ -63,7 +54,7 @@ Value HT_find(HashTable *self, Key key) {
 
 
 void HT_insert(HashTable *self, Key key, Value value) {
-    unsigned hashcode = hash((unsigned char*)&key, sizeof(Key));
+    unsigned hashcode = hash(key);
     /* Value value = INV_VALUE;    // pre assign to invalid value */
     assert(hashcode < HASH_SIZE);
     HashNode *cur = self->table[hashcode];
@@ -104,13 +95,7 @@ void HT_clear(HashTable *self) {
 }
 
 bool keyEqual(Key key1, Key key2) {
-    int len = sizeof(Key);
-    for(int i = 0; i < len; i++) {
-        if(*((unsigned char*)&key1 + i) != *((unsigned char*)&key2 + i)) {
-            return false;
-        }
-    }
-    return true;
+    return key1.kind == key2.kind && key1.id == key2.id;
 }
 
 void printHashTable(HashTable *self) {
@@ -7,7 +7,7 @@
 
 typedef Operand Key;
 /* typedef Operand Value; */
-typedef IRList* Value;
+typedef IR* Value;
 
 typedef struct HashNode HashNode;
 typedef struct HashTable HashTable;
@@ -0,0 +1,350 @@
+#include "ir.h"
+#include "cfg.h"
+#include "context.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Callee Callee;
+typedef struct Inliner Inliner;
+typedef struct Renaming Renaming;
+
+// a function and what the cost model needs of it
+struct Callee {
+    IRFunc *func;
+    int size;       // codes other than removed ones
+    int paramCnt;
+    int retCnt;
+    int callCnt;    // calls to it left in the program
+    int index;      // Tarjan's numbering, -1 until visited
+    int low;
+    bool onStack;
+    bool inlined;   // into some caller at least once
+};
+
+struct Inliner {
+    CompilerContext *ctx;
+    Callee *callees;
+    int calleeCnt;
+    int *calleeOf;  // by FUNCTION operand id - funcBase, -1 if none
+    int funcBase;
+    int funcCnt;
+    int *stack;
+    int depth;
+    int visited;
+};
+
+// fresh ids of the temps, variables and labels of one copy, over the
+// ranges of ids it holds
+struct Renaming {
+    int *ids[3];    // OP_TEMP, OP_VAR and OP_LABEL
+    int base[3];
+    int cnt[3];
+};
+
+static void findCallees(Inliner *self);
+static Callee* calleeOf(Inliner *self, IR *call);
+static void visit(Inliner *self, int i);
+static void inlineInto(Inliner *self, Callee *caller, int scc);
+static bool collectArgs(IRFunc *func, int call, int paramCnt, bool *isArg);
+static int copyBody(Inliner *self, Callee *callee, IRFunc *caller, int call, IR *codes, int cnt);
+static void initRenaming(Renaming *self, IRFunc *func);
+static Operand freshName(CompilerContext *ctx, Renaming *self, Operand op);
+static void clearRenaming(Renaming *self);
+static int renamed(Operand op);
+static void removeFunc(CompilerContext *ctx, IRFunc *func);
+
+// bottom-up over the call graph: the strongly connected components come out
+// of Tarjan's walk callees first, so a callee has taken in its own callees
+// before it is copied. calls inside a component are recursive and stay
+void inlineCalls(CompilerContext *ctx) {
+    Inliner self;
+    memset(&self, 0, sizeof(Inliner));
+    self.ctx = ctx;
+    findCallees(&self);
+    self.stack = (int*)malloc(sizeof(int) * (self.calleeCnt + 1));
+    for(int i = 0; i < self.calleeCnt; i++) {
+        if(self.callees[i].index < 0) {
+            visit(&self, i);
+        }
+    }
+    for(int i = 0; i < self.calleeCnt; i++) {
+        Callee *callee = self.callees + i;
+        if(callee->inlined && callee->callCnt == 0) {
+            removeFunc(ctx, callee->func);
+            ctx->optStats.funcsRemoved++;
+        }
+    }
+    free(self.callees);
+    free(self.calleeOf);
+    free(self.stack);
+}
+
+static void findCallees(Inliner *self) {
+    CompilerContext *ctx = self->ctx;
+    int min = OPERAND_ID_MAX, max = -1;
+    for(IRFunc *func = ctx->funcList; func; func = func->next) {
+        int id = func->codes[0].arg1.id;
+        min = id < min ? id : min;
+        max = id > max ? id : max;
+        self->calleeCnt++;
+    }
+    self->funcBase = min;
+    self->funcCnt = max >= min ? max - min + 1 : 0;
+    self->calleeOf = (int*)malloc(sizeof(int) * (self->funcCnt + 1));
+    memset(self->calleeOf, -1, sizeof(int) * self->funcCnt);
+    self->callees = (Callee*)malloc(sizeof(Callee) * (self->calleeCnt + 1));
+    memset(self->callees, 0, sizeof(Callee) * self->calleeCnt);
+    int i = 0;
+    for(IRFunc *func = ctx->funcList; func; func = func->next, i++) {
+        Callee *callee = self->callees + i;
+        callee->func = func;
+        callee->size = func->cnt - func->dead;
+        callee->index = -1;
+        for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+            callee->paramCnt += p->kind == IR_PARM;
+            callee->retCnt += p->kind == IR_RET;
+        }
+        self->calleeOf[func->codes[0].arg1.id - self->funcBase] = i;
+    }
+    for(i = 0; i < self->calleeCnt; i++) {
+        IRFunc *func = self->callees[i].func;
+        for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+            Callee *callee = p->kind == IR_CALL ? calleeOf(self, p) : NULL;
+            if(callee) {
+                callee->callCnt++;
+            }
+        }
+    }
+}
+
+static Callee* calleeOf(Inliner *self, IR *call) {
+    int i = (int)call->arg1.id - self->funcBase;
+    if(i < 0 || i >= self->funcCnt || self->calleeOf[i] < 0) return NULL;
+    return self->callees + self->calleeOf[i];
+}
+
+static void visit(Inliner *self, int i) {
+    Callee *caller = self->callees + i;
+    IRFunc *func = caller->func;
+    caller->index = caller->low = self->visited++;
+    caller->onStack = true;
+    self->stack[self->depth++] = i;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        Callee *callee = p->kind == IR_CALL ? calleeOf(self, p) : NULL;
+        if(!callee) continue;
+        if(callee->index < 0) {
+            visit(self, callee - self->callees);
+            caller->low = callee->low < caller->low ? callee->low : caller->low;
+        } else if(callee->onStack) {
+            caller->low = callee->index < caller->low ? callee->index : caller->low;
+        }
+    }
+    if(caller->low != caller->index) return;
+    int top = self->depth;
+    do {
+        self->callees[self->stack[--self->depth]].onStack = false;
+    } while(self->stack[self->depth] != i);
+    // the component is stack[depth .. top), its index marks its members
+    for(int k = self->depth; k < top; k++) {
+        self->callees[self->stack[k]].low = caller->index;
+    }
+    for(int k = self->depth; k < top; k++) {
+        inlineInto(self, self->callees + self->stack[k], caller->index);
+    }
+}
+
+// a callee is copied in when it is small, or when this is its only call,
+// while the caller stays under INLINE_GROWTH. the caller is rebuilt once,
+// relabeled so its labels keep one short range
+static void inlineInto(Inliner *self, Callee *caller, int scc) {
+    CompilerContext *ctx = self->ctx;
+    IRFunc *func = caller->func;
+    Callee **site = (Callee**)calloc(func->cnt, sizeof(Callee*));
+    bool *isArg = (bool*)calloc(func->cnt, sizeof(bool));   // of an inlined call
+    int size = caller->size, cap = caller->size, siteCnt = 0;
+    for(int i = 0; i < func->cnt; i++) {
+        IR *p = func->codes + i;
+        Callee *callee = p->kind == IR_CALL ? calleeOf(self, p) : NULL;
+        if(!callee || callee->low == scc) continue;
+        if(callee->size > INLINE_SMALL && (callee->callCnt > 1 || callee->size > INLINE_ONCE)) continue;
+        if(size + callee->size > INLINE_GROWTH || !collectArgs(func, i, callee->paramCnt, isArg)) continue;
+        site[i] = callee;
+        siteCnt++;
+        size += callee->size;
+        cap += callee->size + callee->retCnt + 1;
+    }
+    if(siteCnt == 0) {
+        free(site);
+        free(isArg);
+        return;
+    }
+    IR *codes = (IR*)malloc(sizeof(IR) * cap);
+    int cnt = 0;
+    for(int i = 0; i < func->cnt; i++) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD || isArg[i]) continue;
+        if(site[i]) {
+            cnt = copyBody(self, site[i], func, i, codes, cnt);
+        } else {
+            codes[cnt++] = *p;
+        }
+    }
+    assert(cnt <= cap);
+    relabelCodes(ctx, func, codes, cnt, cap);
+    caller->size = cnt;
+    caller->retCnt = 0;
+    for(int i = 0; i < cnt; i++) {
+        caller->retCnt += codes[i].kind == IR_RET;
+    }
+    free(site);
+    free(isArg);
+}
+
+// the ARGs right before the call, as many as the callee has params
+static bool collectArgs(IRFunc *func, int call, int paramCnt, bool *isArg) {
+    int cnt = 0, i;
+    for(i = call - 1; i > 0; i--) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        if(p->kind != IR_ARG || cnt == paramCnt) break;
+        cnt++;
+    }
+    if(cnt != paramCnt || func->codes[i].kind == IR_ARG) return false;
+    for(i = call - 1; cnt > 0; i--) {
+        if(func->codes[i].kind == IR_ARG) {
+            isArg[i] = true;
+            cnt--;
+        }
+    }
+    return true;
+}
+
+// params become copies of the args, the last one pushed being the first
+// param. x := CALL f takes each return value and goes past the copy.
+// every temp, variable and label of the copy is fresh
+static int copyBody(Inliner *self, Callee *callee, IRFunc *caller, int call, IR *codes, int cnt) {
+    CompilerContext *ctx = self->ctx;
+    IRFunc *func = callee->func;
+    Operand result = caller->codes[call].result;
+    Operand end = labelOperand(ctx);
+    Renaming names;
+    initRenaming(&names, func);
+    int last = func->cnt - 1;
+    while(last > 0 && func->codes[last].kind == IR_DEAD) {
+        last--;
+    }
+    int arg = call;
+    for(int i = 1; i < func->cnt; i++) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        IR *q = codes + cnt++;
+        *q = *p;
+        if(p->kind == IR_PARM) {
+            do {
+                arg--;
+            } while(caller->codes[arg].kind != IR_ARG);
+            q->kind = IR_ASSIGN;
+            q->result = freshName(ctx, &names, p->arg1);
+            q->arg1 = caller->codes[arg].arg1;
+        } else if(p->kind == IR_RET) {
+            q->kind = IR_ASSIGN;
+            q->result = result;
+            q->arg1 = freshName(ctx, &names, p->arg1);
+            if(i != last) {
+                IR *jump = codes + cnt++;
+                memset(jump, 0, sizeof(IR));
+                jump->kind = IR_GOTO;
+                jump->arg1 = end;
+            }
+        } else {
+            Callee *next = p->kind == IR_CALL ? calleeOf(self, p) : NULL;
+            if(next) {
+                next->callCnt++;
+            }
+            q->result = freshName(ctx, &names, p->result);
+            q->arg1 = freshName(ctx, &names, p->arg1);
+            q->arg2 = freshName(ctx, &names, p->arg2);
+        }
+    }
+    IR *label = codes + cnt++;
+    memset(label, 0, sizeof(IR));
+    label->kind = IR_LABEL;
+    label->arg1 = end;
+    clearRenaming(&names);
+    callee->callCnt--;
+    callee->inlined = true;
+    ctx->optStats.inlined++;
+    return cnt;
+}
+
+static void initRenaming(Renaming *self, IRFunc *func) {
+    int min[3] = { OPERAND_ID_MAX, OPERAND_ID_MAX, OPERAND_ID_MAX }, max[3] = { -1, -1, -1 };
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEAD) continue;
+        Operand ops[3] = { p->result, p->arg1, p->arg2 };
+        for(int k = 0; k < 3; k++) {
+            int r = renamed(ops[k]);
+            if(r < 0) continue;
+            min[r] = (int)ops[k].id < min[r] ? (int)ops[k].id : min[r];
+            max[r] = (int)ops[k].id > max[r] ? (int)ops[k].id : max[r];
+        }
+    }
+    for(int r = 0; r < 3; r++) {
+        self->base[r] = min[r];
+        self->cnt[r] = max[r] >= min[r] ? max[r] - min[r] + 1 : 0;
+        self->ids[r] = (int*)malloc(sizeof(int) * (self->cnt[r] + 1));
+        memset(self->ids[r], -1, sizeof(int) * self->cnt[r]);
+    }
+}
+
+// a variable becomes a temp, it is local to the copy as well. such a temp
+// may be assigned more than once, like the variable was
+static Operand freshName(CompilerContext *ctx, Renaming *self, Operand op) {
+    int r = renamed(op);
+    if(r < 0) return op;
+    int *id = self->ids[r] + (op.id - self->base[r]);
+    assert(op.id - self->base[r] < (unsigned)self->cnt[r]);
+    if(*id < 0) {
+        *id = (op.kind == OP_LABEL ? labelOperand(ctx) : tempOperand(ctx)).id;
+    }
+    op.kind = op.kind == OP_LABEL ? OP_LABEL : OP_TEMP;
+    op.id = *id;
+    return op;
+}
+
+// which of the ranges holds op, -1 if it keeps its id
+static int renamed(Operand op) {
+    switch(op.kind) {
+        case OP_TEMP:
+            return 0;
+        case OP_VAR:
+            return 1;
+        case OP_LABEL:
+            return 2;
+        default:
+            return -1;
+    }
+}
+
+static void clearRenaming(Renaming *self) {
+    for(int r = 0; r < 3; r++) {
+        free(self->ids[r]);
+    }
+}
+
+static void removeFunc(CompilerContext *ctx, IRFunc *func) {
+    IRFunc *prev = NULL;
+    for(IRFunc *p = ctx->funcList; p != func; p = p->next) {
+        prev = p;
+    }
+    if(prev) {
+        prev->next = func->next;
+    } else {
+        ctx->funcList = func->next;
+    }
+    if(ctx->funcTail == func) {
+        ctx->funcTail = prev;
+    }
+    freeFunc(func);
+}
@@ -1,329 +1,453 @@
 #include "ir.h"
+#include "context.h"
 #include "syntax.tab.h"
 #include "hash_table.h"
+#include "cfg.h"
+#include "liveness.h"
+#include "ssa.h"
 #include <assert.h>
 
 #define LABEL_FALL 0
 #define VAR_NULL 0
 
-static IRList* codeList = NULL;
-static FILE* stream = NULL;
-static bool illegal = false;
-static void addCode(IRList *code); // add code to the end of codeList
-static void initIRList();
+static void addCode(CompilerContext *ctx, IR *code); // add code to the end of the last function
+static void initIRList(CompilerContext *ctx);
 /* static void clearIRList();  // dealloc irlist */
-static void translate(Node *node);  // entry
-static void removeCode(IRList *code);
-
-static int newLableId();
-static int newTmpId();
-
-static void translateExtDef(Node *extDef);
-static void translateDec(Node *dec);
-static void translateStmt(Node *stmt);
-
-static void translateFunDec(Node *funDec); // param 
-static void translateExp(Node *exp, int place);
-static void translateArr(Node *exp, int place);
-static void translateCond(Node *exp, int label_true, int label_false);
-static ArgNode* translateArgs(ArgNode *argList, Node *args);
-static ArgNode* translateArgs1(Node *args);
-
-static void printOperand(Operand op);
-static void printRelop(RELOP_t relop);
-static void printCodeList(); 
-
-static void genGoto(int labelId);
-static void genLabel(int labelId);
+static void translate(CompilerContext *ctx, Node *node);  // entry
+static IR* prevCode(IRFunc *func, IR *code);
+static void compactCode(IRFunc *func);
+static LabelUse* labelUse(IRFunc *func, int labelId);
+static int jumpLabel(IR *code);
+static void addLabelUse(IRFunc *func, int labelId, int index);
+static void dropLabelUse(IRFunc *func, int labelId, int index);
+static void retargetJump(IRFunc *func, IR *code, int labelId);
+static IR* nextCode(IRFunc *func, IR *code);
+
+static int newLableId(CompilerContext *ctx);
+static int newTmpId(CompilerContext *ctx);
+
+static void translateExtDef(CompilerContext *ctx, Node *extDef);
+static void translateDec(CompilerContext *ctx, Node *dec);
+static void translateStmt(CompilerContext *ctx, Node *stmt);
+
+static void translateFunDec(CompilerContext *ctx, Node *funDec); // param 
+static void translateExp(CompilerContext *ctx, Node *exp, int place);
+static void translateArr(CompilerContext *ctx, Node *exp, int place);
+static void translateCond(CompilerContext *ctx, Node *exp, int label_true, int label_false);
+static ArgNode* translateArgs(CompilerContext *ctx, ArgNode *argList, Node *args);
+static ArgNode* translateArgs1(CompilerContext *ctx, Node *args);
+
+static void printOperand(CompilerContext *ctx, Operand op);
+static void printRelop(CompilerContext *ctx, RELOP_t relop);
+static void printCodeList(CompilerContext *ctx); 
+
+static void genGoto(CompilerContext *ctx, int labelId);
+static void genLabel(CompilerContext *ctx, int labelId);
 static RELOP_t getRelop(Node *relop);
 static RELOP_t getRevRelop(RELOP_t relop);
-static int getTypeSize(Type *type);
-static IRList* newIRList();
-
-static void optimize();
-static void optimize_once(bool *changed);
-static void last_optimize();
-static void substitute();
-static void assignSubs(bool *changed);
-static void assignSubs1(bool *changed);
-static void evalConst(bool *changed);
-static void assignElimit(bool *changed);
-static void labelElimit(bool *changed);
-static IRList *lookback(IRList *list, IRList *p);
-static DeadCode* updateDeadList(DeadCode *deadList, Operand op);
+static IR newCode();
 
-static bool isOperandValid(Operand Operand);
-static bool isModifyInstr(IRList *irList, Operand op);
-static bool checkOrder(IRList *p1, IRList *p2, IRList *end);
+static void optimize(CompilerContext *ctx);
+static void optimizeFunc(CompilerContext *ctx, IRFunc *func);
+static void assignSubs(CompilerContext *ctx, IRFunc *func, bool *changed);
+static void assignSubs1(CompilerContext *ctx, IRFunc *func, bool *changed);
+static void evalConst(CompilerContext *ctx, IRFunc *func, bool *changed);
+static void assignElimit(CompilerContext *ctx, IRFunc *func, bool *changed);
+static void labelElimit(CompilerContext *ctx, IRFunc *func, bool *changed);
+static void jumpThread(CompilerContext *ctx, IRFunc *func, bool *changed);
 
-void generate_ir(Node *root, const char* filename) {
-    initIRList();
-    translate(root);
+static bool isOperandValid(Operand Operand);
+static bool isModifyInstr(IR *code, Operand op);
+static bool checkOrder(IR *p1, IR *p2);
+static Operand foldConst(CompilerContext *ctx, IRKind kind, Operand a, Operand b);
+
+// the code list stays with ctx for the code generator, stream may be NULL
+void generate_ir(CompilerContext *ctx, Node *root, FILE *stream) {
+    initIRList(ctx);
+    translate(ctx, root);
     /* printf("=====================before optimize===================\n"); */
     /* printCodeList(); */
     /* printf("=====================after optimize===================\n"); */
 #ifdef __ARR__
-    illegal = false;
+    ctx->illegal = false;
 #endif
-    if(!illegal) {
+    if(!ctx->illegal) {
 #ifdef __OPT__
-        optimize();
+        optimize(ctx);
 #endif
-#ifndef __LAB4__
-        stream = fopen(filename, "w");
-        if(!stream) {
-            perror("fopen");
-            return;
+        if(stream) {
+            ctx->irStream = stream;
+            printCodeList(ctx);
         }
-        printCodeList();
-        fclose(stream);
-#endif
     } else {
-        fprintf(stderr, "\033[31mCannot translate: Code contains variables of multi-dimensional array type or parameters of array type[use -D__ARR__ to change the behavior of compiler]\n\033[0m");
+        addDiagnostic(ctx, CMM_TRANSLATE, 0, 0, 0, "Cannot translate: Code contains variables of multi-dimensional array type or parameters of array type", NULL);
+        if(ctx->errStream) {
+            fprintf(ctx->errStream, "\033[31mCannot translate: Code contains variables of multi-dimensional array type or parameters of array type[use -D__ARR__ to change the behavior of compiler]\n\033[0m");
+        }
     }
-    // do something
-#ifndef __LAB4__
-    clearIRList();
-    clearSymbolTable();
-#endif
 }
 
-IRList* getCodeList() {
-    return codeList;
+IRFunc* getFuncList(CompilerContext *ctx) {
+    return ctx->funcList;
 }
 
-void printOperand(Operand op) {
+// scopes let two variables share a name, the index of the symbol tells
+// them apart. it follows the last _v, so no two variables print alike, nor
+// a variable like a temp
+void printOperand(CompilerContext *ctx, Operand op) {
     switch(op.kind) {
         case OP_VAR:
-            fprintf(stream, "%s", op.u.symbol->name);
+            fprintf(ctx->irStream, "%s_v%d", operandSymbol(ctx, op)->name, op.id);
             break;
         case OP_FUNC:
-            fprintf(stream, "%s", op.u.symbol->name);
+            fprintf(ctx->irStream, "%s", operandSymbol(ctx, op)->name);
             break;
         case OP_TEMP:
-            fprintf(stream, "t_%d", op.u.tmpId);
+            fprintf(ctx->irStream, "t_%d", op.id);
             break;
         case OP_CONST:
-            fprintf(stream, "#%d", op.u.value);
+            fprintf(ctx->irStream, "#%d", constValue(ctx, op));
             break;
         case OP_LABEL:
-            fprintf(stream, "label_%d", op.u.labelId);
+            fprintf(ctx->irStream, "label_%d", op.id);
             break;
         default:
             assert(0);
     }
 }
 
-void printRelop(RELOP_t relop) {
+void printRelop(CompilerContext *ctx, RELOP_t relop) {
     switch(relop) {
         case RELOP_EQ:
-            fprintf(stream, " == ");
+            fprintf(ctx->irStream, " == ");
             break;
         case RELOP_LE:
-            fprintf(stream, " <= ");
+            fprintf(ctx->irStream, " <= ");
             break;
         case RELOP_LT:
-            fprintf(stream, " < ");
+            fprintf(ctx->irStream, " < ");
             break;
         case RELOP_GE:
-            fprintf(stream, " >= ");
+            fprintf(ctx->irStream, " >= ");
             break;
         case RELOP_GT:
-            fprintf(stream, " > ");
+            fprintf(ctx->irStream, " > ");
             break;
         case RELOP_NE:
-            fprintf(stream, " != ");
+            fprintf(ctx->irStream, " != ");
             break;
         default:
             assert(0);
     }
 }
 
-void printCodeList() {
-    if(codeList == NULL) return;
-    IRList *p = codeList;
-    do {
-        switch(p->code.kind) {
-            case IR_LABEL:
-                fprintf(stream, "LABEL ");
-                printOperand(p->code.arg1);
-                fprintf(stream, " :\n");
-                break;
-            case IR_FUNC:
-                fprintf(stream, "FUNCTION ");
-                printOperand(p->code.arg1);
-                fprintf(stream, " :\n");
-                break;
-            case IR_ASSIGN:
-                printOperand(p->code.result);
-                fprintf(stream, " := ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_ADD:
-                printOperand(p->code.result);
-                fprintf(stream, " := ");
-                printOperand(p->code.arg1);
-                fprintf(stream, " + ");
-                printOperand(p->code.arg2);
-                fprintf(stream, "\n");
-                break;
-            case IR_SUB:
-                printOperand(p->code.result);
-                fprintf(stream, " := ");
-                printOperand(p->code.arg1);
-                fprintf(stream, " - ");
-                printOperand(p->code.arg2);
-                fprintf(stream, "\n");
-                break;
-            case IR_MUL:
-                printOperand(p->code.result);
-                fprintf(stream, " := ");
-                printOperand(p->code.arg1);
-                fprintf(stream, " * ");
-                printOperand(p->code.arg2);
-                fprintf(stream, "\n");
-                break;
-            case IR_DIV:
-                printOperand(p->code.result);
-                fprintf(stream, " := ");
-                printOperand(p->code.arg1);
-                fprintf(stream, " / ");
-                printOperand(p->code.arg2);
-                fprintf(stream, "\n");
-                break;
-            case IR_REF:
-                printOperand(p->code.result);
-                fprintf(stream, " := &");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_DEREF_R:
-                printOperand(p->code.result);
-                fprintf(stream, " := *");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_DEREF_L:
-                fprintf(stream, "*");
-                printOperand(p->code.result);
-                fprintf(stream, " := ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_GOTO:
-                fprintf(stream, "GOTO ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_RELOP:
-                fprintf(stream, "IF ");
-                printOperand(p->code.arg1);
-                printRelop(p->code.u.relop);
-                printOperand(p->code.arg2);
-                fprintf(stream, " GOTO ");
-                printOperand(p->code.result);
-                fprintf(stream, "\n");
-                break;
-            case IR_RET:
-                fprintf(stream, "RETURN ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_DEC:
-                fprintf(stream, "DEC ");
-                printOperand(p->code.result);
-                fprintf(stream, " ");
-                fprintf(stream, "%d", p->code.arg1.u.value);
-                /* printOperand(p->code.arg1); */
-                fprintf(stream, "\n");
-                break;
-            case IR_ARG:
-                fprintf(stream, "ARG ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_CALL:
-                printOperand(p->code.result);
-                fprintf(stream, " := CALL ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_PARM:
-                fprintf(stream, "PARAM ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_READ:
-                fprintf(stream, "READ ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            case IR_WRITE:
-                fprintf(stream, "WRITE ");
-                printOperand(p->code.arg1);
-                fprintf(stream, "\n");
-                break;
-            default:
-                assert(0);
-        } 
-        p = p->next;
-    } while(p != codeList);
+void printCodeList(CompilerContext *ctx) {
+    for(IRFunc *f = ctx->funcList; f; f = f->next) {
+        for(IR *p = f->codes; p < f->codes + f->cnt; p++) {
+            switch(p->kind) {
+                case IR_LABEL:
+                    fprintf(ctx->irStream, "LABEL ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, " :\n");
+                    break;
+                case IR_FUNC:
+                    fprintf(ctx->irStream, "FUNCTION ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, " :\n");
+                    break;
+                case IR_ASSIGN:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_ADD:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, " + ");
+                    printOperand(ctx, p->arg2);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_SUB:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, " - ");
+                    printOperand(ctx, p->arg2);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_MUL:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, " * ");
+                    printOperand(ctx, p->arg2);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_DIV:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, " / ");
+                    printOperand(ctx, p->arg2);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_REF:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := &");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_DEREF_R:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := *");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_DEREF_L:
+                    fprintf(ctx->irStream, "*");
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_GOTO:
+                    fprintf(ctx->irStream, "GOTO ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_RELOP:
+                    fprintf(ctx->irStream, "IF ");
+                    printOperand(ctx, p->arg1);
+                    printRelop(ctx, p->relop);
+                    printOperand(ctx, p->arg2);
+                    fprintf(ctx->irStream, " GOTO ");
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_RET:
+                    fprintf(ctx->irStream, "RETURN ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_DEC:
+                    fprintf(ctx->irStream, "DEC ");
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " ");
+                    fprintf(ctx->irStream, "%d", constValue(ctx, p->arg1));
+                    /* printOperand(p->arg1); */
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_ARG:
+                    fprintf(ctx->irStream, "ARG ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_CALL:
+                    printOperand(ctx, p->result);
+                    fprintf(ctx->irStream, " := CALL ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_PARM:
+                    fprintf(ctx->irStream, "PARAM ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_READ:
+                    fprintf(ctx->irStream, "READ ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_WRITE:
+                    fprintf(ctx->irStream, "WRITE ");
+                    printOperand(ctx, p->arg1);
+                    fprintf(ctx->irStream, "\n");
+                    break;
+                case IR_DEAD:
+                    break;
+                default:
+                    assert(0);
+            } 
+        }
+    }
 }
 
-void genGoto(int labelId) {
-    IRList *irList = newIRList();
-    irList->code.kind = IR_GOTO;
-    irList->code.arg1.kind = OP_LABEL;
-    irList->code.arg1.u.labelId = labelId;
-    addCode(irList);
+void genGoto(CompilerContext *ctx, int labelId) {
+    IR code = newCode();
+    code.kind = IR_GOTO;
+    code.arg1.kind = OP_LABEL;
+    code.arg1.id = labelId;
+    addCode(ctx, &code);
 }
 
-void genLabel(int labelId) {
-    IRList *irList = newIRList();
-    irList->code.kind = IR_LABEL;
-    irList->code.arg1.kind = OP_LABEL;
-    irList->code.arg1.u.labelId = labelId;
-    addCode(irList);
+void genLabel(CompilerContext *ctx, int labelId) {
+    IR code = newCode();
+    code.kind = IR_LABEL;
+    code.arg1.kind = OP_LABEL;
+    code.arg1.id = labelId;
+    addCode(ctx, &code);
 }
 
-void initIRList() {
-    /* create list head node */
+void initIRList(CompilerContext *ctx) {
+    ctx->operands = newOperandTable();
 }
 
-// bidirect linkedlist insert
-void addCode(IRList *code) {
-    if(code) {
-        if(!codeList) {
-            codeList = code;
+// a FUNCTION starts a new function, any other code goes to the last one
+void addCode(CompilerContext *ctx, IR *code) {
+    if(code->kind == IR_FUNC) {
+        IRFunc *func = (IRFunc*)malloc(sizeof(IRFunc));
+        memset(func, 0, sizeof(IRFunc));
+        if(ctx->funcTail) {
+            ctx->funcTail->next = func;
         } else {
-            code->prev = codeList->prev;
-            codeList->prev->next = code;
-            code->next = codeList;
-            codeList->prev = code;
+            ctx->funcList = func;
         }
+        ctx->funcTail = func;
+        func->labelBase = ctx->labelId;     // labels of the body are allocated after it
     }
+    IRFunc *func = ctx->funcTail;
+    assert(func);
+    if(func->cnt == func->cap) {
+        func->cap = func->cap ? func->cap * 2 : 64;
+        func->codes = (IR*)realloc(func->codes, sizeof(IR) * func->cap);
+    }
+    if(code->kind == IR_LABEL) {
+        labelUse(func, code->arg1.id)->def = func->cnt;
+    } else if(code->kind == IR_GOTO || code->kind == IR_RELOP) {
+        addLabelUse(func, jumpLabel(code), func->cnt);
+    }
+    func->codes[func->cnt++] = *code;
+}
+
+// grown on demand, a label nobody placed yet has def -1
+LabelUse* labelUse(IRFunc *func, int labelId) {
+    int i = labelId - func->labelBase;
+    assert(i >= 0);
+    if(i >= func->labelCnt) {
+        int cnt = func->labelCnt ? func->labelCnt : 16;
+        while(cnt <= i) {
+            cnt *= 2;
+        }
+        func->labels = (LabelUse*)realloc(func->labels, sizeof(LabelUse) * cnt);
+        memset(func->labels + func->labelCnt, 0, sizeof(LabelUse) * (cnt - func->labelCnt));
+        for(int k = func->labelCnt; k < cnt; k++) {
+            func->labels[k].def = -1;
+        }
+        func->labelCnt = cnt;
+    }
+    return func->labels + i;
+}
+
+int jumpLabel(IR *code) {
+    assert(code->kind == IR_GOTO || code->kind == IR_RELOP);
+    return code->kind == IR_GOTO ? code->arg1.id : code->result.id;
 }
 
-void clearIRList() {
-    if(!codeList) return;
-    IRList *end = codeList;
-    while(codeList->next != end) {
-        IRList *p = codeList;
-        codeList = p->next;
-        free(p);
+void addLabelUse(IRFunc *func, int labelId, int index) {
+    LabelUse *label = labelUse(func, labelId);
+    if(label->useCnt == label->useCap) {
+        label->useCap = label->useCap ? label->useCap * 2 : 4;
+        label->uses = (int*)realloc(label->uses, sizeof(int) * label->useCap);
     }
-    free(codeList);
+    label->uses[label->useCnt++] = index;
 }
 
-static int newLableId() {
-    static int labelId = 1;
-    return labelId++;
+void dropLabelUse(IRFunc *func, int labelId, int index) {
+    LabelUse *label = labelUse(func, labelId);
+    for(int k = 0; k < label->useCnt; k++) {
+        if(label->uses[k] == index) {
+            label->uses[k] = label->uses[--label->useCnt];
+            return;
+        }
+    }
+    assert(0);
 }
 
-static int newTmpId() {
-    static int tmpId = 1;
-    return tmpId++;
+// every jump edit goes through here to keep the label index right
+void retargetJump(IRFunc *func, IR *code, int labelId) {
+    int index = code - func->codes;
+    dropLabelUse(func, jumpLabel(code), index);
+    if(code->kind == IR_GOTO) {
+        code->arg1.id = labelId;
+    } else {
+        code->result.id = labelId;
+    }
+    addLabelUse(func, labelId, index);
+    invalidateCFG(func);
+}
+
+void clearFuncList(CompilerContext *ctx) {
+    while(ctx->funcList) {
+        IRFunc *func = ctx->funcList;
+        ctx->funcList = func->next;
+        freeFunc(func);
+    }
+    ctx->funcTail = NULL;
+    if(ctx->operands) {
+        OT_clear(ctx->operands);
+        ctx->operands = NULL;
+    }
+}
+
+void freeFunc(IRFunc *func) {
+    free(func->codes);
+    freeCFG(func->cfg);
+    for(int i = 0; i < func->labelCnt; i++) {
+        free(func->labels[i].uses);
+    }
+    free(func->labels);
+    free(func);
+}
+
+static int newLableId(CompilerContext *ctx) {
+    assert(ctx->labelId <= OPERAND_ID_MAX);
+    return ctx->labelId++;
+}
+
+static int newTmpId(CompilerContext *ctx) {
+    assert(ctx->tmpId <= OPERAND_ID_MAX);
+    return ctx->tmpId++;
+}
+
+Operand tempOperand(CompilerContext *ctx) {
+    Operand op;
+    op.kind = OP_TEMP;
+    op.id = newTmpId(ctx);
+    return op;
+}
+
+Operand labelOperand(CompilerContext *ctx) {
+    Operand op;
+    op.kind = OP_LABEL;
+    op.id = newLableId(ctx);
+    return op;
+}
+
+Operand constOperand(CompilerContext *ctx, int value) {
+    Operand op;
+    op.kind = OP_CONST;
+    op.id = OT_const(ctx->operands, value);
+    return op;
+}
+
+Operand symbolOperand(CompilerContext *ctx, OperandKind kind, Symbol *sym) {
+    assert(kind == OP_VAR || kind == OP_FUNC);
+    Operand op;
+    op.kind = kind;
+    op.id = OT_symbol(ctx->operands, sym);
+    return op;
+}
+
+int constValue(CompilerContext *ctx, Operand op) {
+    assert(op.kind == OP_CONST);
+    return ctx->operands->consts[op.id];
+}
+
+Symbol* operandSymbol(CompilerContext *ctx, Operand op) {
+    assert(op.kind == OP_VAR || op.kind == OP_FUNC);
+    return ctx->operands->syms[op.id];
 }
 
 RELOP_t getRelop(Node *relop) {
@@ -364,55 +488,51 @@ RELOP_t getRevRelop(RELOP_t relop) {
     }
 }
 
-IRList* newIRList() {
-    IRList *irList = (IRList*)malloc(sizeof(IRList));
-    memset(irList, 0, sizeof(IRList));
-    irList->prev = irList->next = irList;
-    /* irList->prev = NULL; */
-    /* irList->next = NULL; */
-    return irList;
+IR newCode() {
+    IR code;
+    memset(&code, 0, sizeof(IR));
+    return code;
 }
 
-void translate(Node *node) {
+void translate(CompilerContext *ctx, Node *node) {
     if(!node) return;
     switch(node->type) {
         case NODE_ExtDef:
-            translateExtDef(node);
+            translateExtDef(ctx, node);
             return;
         case NODE_Dec:
-            translateDec(node);
+            translateDec(ctx, node);
             return;
         case NODE_Stmt:
-            translateStmt(node);
+            translateStmt(ctx, node);
             return;
         default:
             break;
     }
     for(Node *p = node->child; p; p=p->sib) {
-        translate(p);
+        translate(ctx, p);
     }
 }
 
-void translateExtDef(Node *extDef) {
+void translateExtDef(CompilerContext *ctx, Node *extDef) {
     assert(extDef->type == NODE_ExtDef);
     // extdef -> specifier fundec compst
     if(extDef->child->sib->type == NODE_FunDec) {
-        translateFunDec(extDef->child->sib);
-        translate(extDef->child->sib->sib); // translate compst
+        translateFunDec(ctx, extDef->child->sib);
+        translate(ctx, extDef->child->sib->sib); // translate compst
     }
     // no global variables, no need to deal it
 }
 
-void translateFunDec(Node *funDec) {
+void translateFunDec(CompilerContext *ctx, Node *funDec) {
     assert(funDec->type == NODE_FunDec);
     // generate funcion
-    IRList *irList = newIRList();
-    irList->code.kind = IR_FUNC;
-    irList->code.arg1.kind = OP_FUNC;
-    Symbol *sym = lookupSymbol(funDec->child->val.name, SYM_FUNC);
+    IR code = newCode();
+    code.kind = IR_FUNC;
+    Symbol *sym = funDec->val.sym;  // resolved by the semantic pass
     assert(sym);
-    irList->code.arg1.u.symbol = sym;
-    addCode(irList);
+    code.arg1 = symbolOperand(ctx, OP_FUNC, sym);
+    addCode(ctx, &code);
     // generate parameter declare
     if(funDec->childno == 4) {  // fundec -> id lp varlist rp
         Node *varList = funDec->child->sib->sib;
@@ -420,20 +540,16 @@ void translateFunDec(Node *funDec) {
         while(true) {
             Node *paramDec = varList->child;
             Node *varDec = paramDec->child->sib;
-            while(varDec->childno != 1) {
-                varDec = varDec->child;
-            }
 
-            IRList *irList = newIRList();
-            irList->code.kind = IR_PARM;
-            irList->code.arg1.kind = OP_VAR;
-            Symbol *sym = lookupSymbol(varDec->child->val.name, SYM_VAR);
+            IR code = newCode();
+            code.kind = IR_PARM;
+            Symbol *sym = varDec->val.sym;
             assert(sym);
             if(sym->u.type->kind == ARRAY) {
-                illegal = true;
+                ctx->illegal = true;
             }
-            irList->code.arg1.u.symbol = sym;
-            addCode(irList);
+            code.arg1 = symbolOperand(ctx, OP_VAR, sym);
+            addCode(ctx, &code);
 
             if(varList->childno == 1) break;
             varList = varList->child->sib->sib;            
@@ -441,129 +557,104 @@ void translateFunDec(Node *funDec) {
     }
 }
 
-void translateDec(Node *dec) {
+void translateDec(CompilerContext *ctx, Node *dec) {
     assert(dec->type == NODE_Dec);
-    Node *varDec = dec->child;
-    while(varDec->childno != 1) {
-        varDec = varDec->child;
-    }
-    Symbol *sym = lookupSymbol(varDec->child->val.name, SYM_VAR);
+    Symbol *sym = dec->child->val.sym;  // vardec
     assert(sym);
-    int size = getTypeSize(sym->u.type);
+    int size = sym->u.type->size;
     if(dec->childno == 1) { // dec -> vardec
         if(sym->u.type->kind != BASIC) {    // use dec to allocate mem
             if(sym->u.type->kind == ARRAY) {
-                illegal = true;
+                ctx->illegal = true;
             }
         /* if(size > 4) { */
-            int t1 = newTmpId();
-            IRList *irList = newIRList();
-            irList->code.kind = IR_DEC;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = t1;
-            irList->code.arg1.kind = OP_CONST;
-            irList->code.arg1.u.value = size;
-            addCode(irList);
-
-            irList = newIRList();
-            irList->code.kind = IR_REF;
-            irList->code.result.kind = OP_VAR;
-            irList->code.result.u.symbol = sym;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = t1;
-            addCode(irList);
+            int t1 = newTmpId(ctx);
+            IR code = newCode();
+            code.kind = IR_DEC;
+            code.result.kind = OP_TEMP;
+            code.result.id = t1;
+            code.arg1 = constOperand(ctx, size);
+            addCode(ctx, &code);
+
+            code = newCode();
+            code.kind = IR_REF;
+            code.result = symbolOperand(ctx, OP_VAR, sym);
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = t1;
+            addCode(ctx, &code);
         }
     } else {    // only basic variable is allow to initial
         assert(dec->child->child->type == NODE_ID);
-        int t1 = newTmpId();
-        translateExp(dec->child->sib->sib, t1);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_ASSIGN;
-        irList->code.result.kind = OP_VAR;
-        irList->code.result.u.symbol = sym;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, dec->child->sib->sib, t1);
 
-        addCode(irList);
-    }
-}
+        IR code = newCode();
+        code.kind = IR_ASSIGN;
+        code.result = symbolOperand(ctx, OP_VAR, sym);
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
 
-int getTypeSize(Type *type) {
-    if(type->kind == BASIC) {
-        return 4;
-    }
-    if(type->kind == ARRAY) {
-        return type->u.array.size * getTypeSize(type->u.array.elem);
-    }
-    assert(type->kind == STRUCTURE);
-    int size = 0;
-    FieldList *field = type->u.structure;
-    while(field) {
-        size += getTypeSize(field->type);
-        field = field->next;
+        addCode(ctx, &code);
     }
-    return size;
 }
 
 // translate array
-void translateArr(Node *exp, int place) {
+void translateArr(CompilerContext *ctx, Node *exp, int place) {
     assert(exp->child->sib->type == NODE_LB);
     // Exp -> exp1 LB exp2 RB
     Node *exp1 = exp->child;
     Node *exp2 = exp1->sib->sib;
-    int index = newTmpId();
-    translateExp(exp2, index);
-    Type *type = getExpType(exp);
-    int size = getTypeSize(type);
-    int offset = newTmpId();
+    int index = newTmpId(ctx);
+    translateExp(ctx, exp2, index);
+    Type *type = getExpType(ctx, exp);
+    int size = type->size;
+    int offset = newTmpId(ctx);
 
     // offset = index * size
-    IRList *irList = newIRList();
-    irList->code.kind = IR_MUL;
-    irList->code.result.kind = OP_TEMP;
-    irList->code.result.u.tmpId = offset;
-    irList->code.arg1.kind = OP_TEMP;
-    irList->code.arg1.u.tmpId = index;
-    irList->code.arg2.kind = OP_CONST;
-    irList->code.arg2.u.value = size;
-    addCode(irList);
+    IR code = newCode();
+    code.kind = IR_MUL;
+    code.result.kind = OP_TEMP;
+    code.result.id = offset;
+    code.arg1.kind = OP_TEMP;
+    code.arg1.id = index;
+    code.arg2 = constOperand(ctx, size);
+    addCode(ctx, &code);
 
     if(type->kind != BASIC) {
-        int t1 = newTmpId();
-        translateExp(exp1, t1);
-        irList = newIRList();
-        irList->code.kind = IR_ADD;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_TEMP;
-        irList->code.arg2.u.tmpId = offset;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, exp1, t1);
+        code = newCode();
+        code.kind = IR_ADD;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2.kind = OP_TEMP;
+        code.arg2.id = offset;
+        addCode(ctx, &code);
         return;
     }
 
-    int t1 = newTmpId();
-    translateExp(exp1, t1);
-    int addr = newTmpId();
-    irList = newIRList();
-    irList->code.kind = IR_ADD;
-    irList->code.result.kind = OP_TEMP;
-    irList->code.result.u.tmpId = addr;
-    irList->code.arg1.kind = OP_TEMP;
-    irList->code.arg1.u.tmpId = t1;
-    irList->code.arg2.kind = OP_TEMP;
-    irList->code.arg2.u.tmpId = offset;
-    addCode(irList);
-
-    irList = newIRList();
-    irList->code.kind = IR_DEREF_R;
-    irList->code.result.kind = OP_TEMP;
-    irList->code.result.u.tmpId = place;
-    irList->code.arg1.kind = OP_TEMP;
-    irList->code.arg1.u.tmpId = addr;
-    addCode(irList);
+    int t1 = newTmpId(ctx);
+    translateExp(ctx, exp1, t1);
+    int addr = newTmpId(ctx);
+    code = newCode();
+    code.kind = IR_ADD;
+    code.result.kind = OP_TEMP;
+    code.result.id = addr;
+    code.arg1.kind = OP_TEMP;
+    code.arg1.id = t1;
+    code.arg2.kind = OP_TEMP;
+    code.arg2.id = offset;
+    addCode(ctx, &code);
+
+    code = newCode();
+    code.kind = IR_DEREF_R;
+    code.result.kind = OP_TEMP;
+    code.result.id = place;
+    code.arg1.kind = OP_TEMP;
+    code.arg1.id = addr;
+    addCode(ctx, &code);
 
 
     /* // exp -> exp lb exp rb */
@@ -572,30 +663,30 @@ void translateArr(Node *exp, int place) {
     /*     Symbol *sym = lookupSymbol(exp1->child->val.name, SYM_VAR); */
     /*     assert(sym); */
 
-    /*     irList = newIRList(); */
-    /*     irList->code.kind = IR_ADD; */
-    /*     irList->code.result.kind = OP_TEMP; */
-    /*     irList->code.result.u.tmpId = place; */
-    /*     irList->code.arg1.kind = OP_VAR; */
-    /*     irList->code.arg1.u.symbol = sym; */
-    /*     irList->code.arg2.kind = OP_TEMP; */
-    /*     irList->code.arg2.u.tmpId = offset; */
-    /*     addCode(irList); */
+    /*     code = newCode(); */
+    /*     code.kind = IR_ADD; */
+    /*     code.result.kind = OP_TEMP; */
+    /*     code.result.id = place; */
+    /*     code.arg1.kind = OP_VAR; */
+    /*     code.arg1.u.symbol = sym; */
+    /*     code.arg2.kind = OP_TEMP; */
+    /*     code.arg2.id = offset; */
+    /*     addCode(&code); */
     /* } else if(exp1->child->sib->type == NODE_LB){ */
     /*     assert(exp1->child->sib->type == NODE_LB); */
 
     /*     int t1 = newTmpId(); */
     /*     translateExp(exp1, t1); */
     /*     /1* translateArr(exp1, t1); *1/ */
-    /*     irList = newIRList(); */
-    /*     irList->code.kind = IR_ADD; */
-    /*     irList->code.result.kind = OP_TEMP; */
-    /*     irList->code.result.u.tmpId = place; */
-    /*     irList->code.arg1.kind = OP_TEMP; */
-    /*     irList->code.arg1.u.tmpId = t1; */
-    /*     irList->code.arg2.kind = OP_TEMP; */
-    /*     irList->code.arg2.u.tmpId = offset; */
-    /*     addCode(irList); */
+    /*     code = newCode(); */
+    /*     code.kind = IR_ADD; */
+    /*     code.result.kind = OP_TEMP; */
+    /*     code.result.id = place; */
+    /*     code.arg1.kind = OP_TEMP; */
+    /*     code.arg1.id = t1; */
+    /*     code.arg2.kind = OP_TEMP; */
+    /*     code.arg2.id = offset; */
+    /*     addCode(&code); */
     /* } else if(exp1->child->sib->type == NODE_DOT) { */
     /*     int addr = newTmpId(); */
     /*     translateExp(exp1->child, addr); */
@@ -611,102 +702,98 @@ void translateArr(Node *exp, int place) {
     /*     } */
         
     /*     int t1 = newTmpId(); */
-    /*     irList = newIRList(); */
-    /*     irList->code.kind = IR_ADD; */
-    /*     irList->code.result.kind = OP_TEMP; */
-    /*     irList->code.result.u.tmpId = t1; */
-    /*     irList->code.arg1.kind = OP_TEMP; */
-    /*     irList->code.arg1.u.tmpId = addr; */
-    /*     irList->code.arg2.kind = OP_CONST; */
-    /*     irList->code.arg2.u.value = offset1; */
-    /*     addCode(irList); */
-
-    /*     irList = newIRList(); */
-    /*     irList->code.kind = IR_ADD; */
-    /*     irList->code.result.kind = OP_TEMP; */
-    /*     irList->code.result.u.tmpId = place; */
-    /*     irList->code.arg1.kind = OP_TEMP; */
-    /*     irList->code.arg1.u.tmpId = t1; */
-    /*     irList->code.arg2.kind = OP_TEMP; */
-    /*     irList->code.arg2.u.value = offset; */
-    /*     addCode(irList); */
+    /*     code = newCode(); */
+    /*     code.kind = IR_ADD; */
+    /*     code.result.kind = OP_TEMP; */
+    /*     code.result.id = t1; */
+    /*     code.arg1.kind = OP_TEMP; */
+    /*     code.arg1.id = addr; */
+    /*     code.arg2.kind = OP_CONST; */
+    /*     code.arg2.u.value = offset1; */
+    /*     addCode(&code); */
+
+    /*     code = newCode(); */
+    /*     code.kind = IR_ADD; */
+    /*     code.result.kind = OP_TEMP; */
+    /*     code.result.id = place; */
+    /*     code.arg1.kind = OP_TEMP; */
+    /*     code.arg1.id = t1; */
+    /*     code.arg2.kind = OP_TEMP; */
+    /*     code.arg2.u.value = offset; */
+    /*     addCode(&code); */
         
     /*     /1* assert(0);  // TOOD *1/ */
     /* } */
 }
 
-void translateExp(Node *exp, int place) {
+void translateExp(CompilerContext *ctx, Node *exp, int place) {
     assert(exp->type == NODE_Exp);
     if(exp->childno == 1) {
-        IRList *irList = newIRList();
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
+        IR code = newCode();
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
         if(exp->child->type == NODE_INT) {
-            irList->code.kind = IR_ASSIGN;
-            irList->code.arg1.kind = OP_CONST;
-            irList->code.arg1.u.value = exp->child->val.intVal;
-            addCode(irList);
+            code.kind = IR_ASSIGN;
+            code.arg1 = constOperand(ctx, exp->child->val.intVal);
+            addCode(ctx, &code);
         } else if(exp->child->type == NODE_ID) {
-            Symbol *sym = lookupSymbol(exp->child->val.name, SYM_VAR);
+            Symbol *sym = exp->val.sym;
             assert(sym);
-            irList->code.kind = IR_ASSIGN;
-            irList->code.arg1.kind = OP_VAR;
-            irList->code.arg1.u.symbol = sym;
-            addCode(irList);
+            code.kind = IR_ASSIGN;
+            code.arg1 = symbolOperand(ctx, OP_VAR, sym);
+            addCode(ctx, &code);
         } else {
             assert(0);
         }
         return;
     }
     if(exp->child->type == NODE_LP) {   // parenthese
-        translateExp(exp->child->sib, place);
+        translateExp(ctx, exp->child->sib, place);
         return;
     } else if(exp->child->type == NODE_ID) {    // function call
-        Symbol *sym = lookupSymbol(exp->child->val.name, SYM_FUNC);
+        Symbol *sym = exp->val.sym;
         assert(sym);
         if(exp->childno == 3) {
-            IRList *irList = newIRList();
+            IR code = newCode();
             if(strcmp(sym->name, "read") == 0) {
-                irList->code.kind = IR_READ;
-                irList->code.arg1.kind = OP_TEMP;
-                irList->code.arg1.u.tmpId = place;
+                code.kind = IR_READ;
+                code.arg1.kind = OP_TEMP;
+                code.arg1.id = place;
             } else {
-                irList->code.kind = IR_CALL;
-                irList->code.result.kind = OP_TEMP;
-                irList->code.result.u.tmpId = place;
-                irList->code.arg1.kind = OP_FUNC;
-                irList->code.arg1.u.symbol = sym;
+                code.kind = IR_CALL;
+                code.result.kind = OP_TEMP;
+                code.result.id = place;
+                code.arg1 = symbolOperand(ctx, OP_FUNC, sym);
             }
-            addCode(irList);
+            addCode(ctx, &code);
         } else if(exp->childno == 4) {
             ArgNode *argList = NULL;
-            argList = translateArgs1(exp->child->sib->sib);
+            argList = translateArgs1(ctx, exp->child->sib->sib);
             /* argList = translateArgs(argList, exp->child->sib->sib); */
             if(strcmp(sym->name, "write") == 0) {
                 assert(argList->next == NULL);
-                IRList *irList = newIRList(); 
-                irList->code.kind = IR_WRITE;
-                irList->code.arg1.kind = OP_TEMP;
-                irList->code.arg1.u.tmpId = argList->tmpId;
-                addCode(irList);
+                IR code = newCode(); 
+                code.kind = IR_WRITE;
+                code.arg1.kind = OP_TEMP;
+                code.arg1.id = argList->tmpId;
+                addCode(ctx, &code);
             } else {
                 ArgNode *p = argList;
-                IRList *irList = NULL;
+                IR code;
                 while(p) {
-                    irList = newIRList();
-                    irList->code.kind = IR_ARG;
-                    irList->code.arg1.kind = OP_TEMP;
-                    irList->code.arg1.u.tmpId = p->tmpId;
-                    addCode(irList);
+                    code = newCode();
+                    code.kind = IR_ARG;
+                    code.arg1.kind = OP_TEMP;
+                    code.arg1.id = p->tmpId;
+                    addCode(ctx, &code);
                     p = p->next;
                 }
-                irList = newIRList();
-                irList->code.kind = IR_CALL;
-                irList->code.result.kind = OP_TEMP;
-                irList->code.result.u.tmpId = place;
-                irList->code.arg1.kind = OP_FUNC;
-                irList->code.arg1.u.symbol = sym;
-                addCode(irList);
+                code = newCode();
+                code.kind = IR_CALL;
+                code.result.kind = OP_TEMP;
+                code.result.id = place;
+                code.arg1 = symbolOperand(ctx, OP_FUNC, sym);
+                addCode(ctx, &code);
             }
 
             // deallocate arglist
@@ -723,396 +810,378 @@ void translateExp(Node *exp, int place) {
     if(exp->child->sib->type == NODE_ASSIGNOP) {
         Node *exp1 = exp->child;
         Node *exp2 = exp1->sib->sib;
-        int rvalue = newTmpId();    // t1 is result of rvalue
-        translateExp(exp2, rvalue);
+        int rvalue = newTmpId(ctx);    // t1 is result of rvalue
+        translateExp(ctx, exp2, rvalue);
 
-        IRList *irList = newIRList();
-        irList->code.kind = IR_ASSIGN;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = rvalue;
-        addCode(irList);
+        IR code = newCode();
+        code.kind = IR_ASSIGN;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = rvalue;
+        addCode(ctx, &code);
 
         if(exp1->child->type == NODE_ID) {
-            Symbol *sym = lookupSymbol(exp1->child->val.name, SYM_VAR);
+            Symbol *sym = exp1->val.sym;
             assert(sym);
 
             // assign to variable
-            irList = newIRList();
-            irList->code.kind = IR_ASSIGN;
-            irList->code.result.kind = OP_VAR;
-            irList->code.result.u.symbol = sym;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = rvalue;
-            addCode(irList);
+            code = newCode();
+            code.kind = IR_ASSIGN;
+            code.result = symbolOperand(ctx, OP_VAR, sym);
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = rvalue;
+            addCode(ctx, &code);
         } else if(exp1->child->sib->type == NODE_LB) {    // array
-            int index = newTmpId();
-            translateExp(exp1->child->sib->sib, index);
-            Type *type = getExpType(exp1);
-            int size = getTypeSize(type);
-            int offset = newTmpId();
+            int index = newTmpId(ctx);
+            translateExp(ctx, exp1->child->sib->sib, index);
+            Type *type = getExpType(ctx, exp1);
+            int size = type->size;
+            int offset = newTmpId(ctx);
             // offset = index * size
-            IRList *irList = newIRList();
-            irList->code.kind = IR_MUL;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = offset;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = index;
-            irList->code.arg2.kind = OP_CONST;
-            irList->code.arg2.u.value = size;
-            addCode(irList);
-            int t1 = newTmpId();
-            translateExp(exp1->child, t1);
-            int addr = newTmpId();
-            irList = newIRList();
-            irList->code.kind = IR_ADD;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = addr;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = t1;
-            irList->code.arg2.kind = OP_TEMP;
-            irList->code.arg2.u.value = offset;
-            addCode(irList);
+            IR code = newCode();
+            code.kind = IR_MUL;
+            code.result.kind = OP_TEMP;
+            code.result.id = offset;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = index;
+            code.arg2 = constOperand(ctx, size);
+            addCode(ctx, &code);
+            int t1 = newTmpId(ctx);
+            translateExp(ctx, exp1->child, t1);
+            int addr = newTmpId(ctx);
+            code = newCode();
+            code.kind = IR_ADD;
+            code.result.kind = OP_TEMP;
+            code.result.id = addr;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = t1;
+            code.arg2.kind = OP_TEMP;
+            code.arg2.id = offset;
+            addCode(ctx, &code);
             /* translateArr(exp1, addr); */
 
-            irList = newIRList();
-            irList->code.kind = IR_DEREF_L;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = addr;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = rvalue;
-            addCode(irList);
+            code = newCode();
+            code.kind = IR_DEREF_L;
+            code.result.kind = OP_TEMP;
+            code.result.id = addr;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = rvalue;
+            addCode(ctx, &code);
         } else if(exp1->child->sib->type == NODE_DOT) { // structure
-            int addr = newTmpId();
-            translateExp(exp1->child, addr);
-            Type *type = getExpType(exp1->child);
+            int addr = newTmpId(ctx);
+            translateExp(ctx, exp1->child, addr);
+            Type *type = getExpType(ctx, exp1->child);
             assert(type->kind == STRUCTURE);
-            char *name = exp1->child->sib->sib->val.name;
-            FieldList *field = type->u.structure;
-            int offset = 0;
-            while(strcmp(field->name, name) != 0) {
-                offset += getTypeSize(field->type);
-                assert(field->next);
-                field = field->next;
-            }
+            Atom name = exp1->child->sib->sib->val.name;
+            FieldList *field = getField(type, name);
+            assert(field);
+            int offset = field->offset;
             
-            int t1 = newTmpId();
-            irList = newIRList();
-            irList->code.kind = IR_ADD;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = t1;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = addr;
-            irList->code.arg2.kind = OP_CONST;
-            irList->code.arg2.u.value = offset;
-            addCode(irList);
-
-            irList = newIRList();
-            irList->code.kind = IR_DEREF_L;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = t1;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = rvalue;
-            addCode(irList);
+            int t1 = newTmpId(ctx);
+            code = newCode();
+            code.kind = IR_ADD;
+            code.result.kind = OP_TEMP;
+            code.result.id = t1;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = addr;
+            code.arg2 = constOperand(ctx, offset);
+            addCode(ctx, &code);
+
+            code = newCode();
+            code.kind = IR_DEREF_L;
+            code.result.kind = OP_TEMP;
+            code.result.id = t1;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = rvalue;
+            addCode(ctx, &code);
             /* assert(0);  // todo */
         } else {
             assert(0);
         }
     } else if(exp->child->sib->type == NODE_PLUS) {
-        int t1 = newTmpId();
-        int t2 = newTmpId();
-        translateExp(exp->child, t1);
-        translateExp(exp->child->sib->sib, t2);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_ADD;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_TEMP;
-        irList->code.arg2.u.tmpId = t2;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        int t2 = newTmpId(ctx);
+        translateExp(ctx, exp->child, t1);
+        translateExp(ctx, exp->child->sib->sib, t2);
+
+        IR code = newCode();
+        code.kind = IR_ADD;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2.kind = OP_TEMP;
+        code.arg2.id = t2;
+        addCode(ctx, &code);
     } else if(exp->child->sib->type == NODE_MINUS) {
-        int t1 = newTmpId();
-        int t2 = newTmpId();
-        translateExp(exp->child, t1);
-        translateExp(exp->child->sib->sib, t2);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_SUB;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_TEMP;
-        irList->code.arg2.u.tmpId = t2;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        int t2 = newTmpId(ctx);
+        translateExp(ctx, exp->child, t1);
+        translateExp(ctx, exp->child->sib->sib, t2);
+
+        IR code = newCode();
+        code.kind = IR_SUB;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2.kind = OP_TEMP;
+        code.arg2.id = t2;
+        addCode(ctx, &code);
     } else if(exp->child->sib->type == NODE_STAR) {
-        int t1 = newTmpId();
-        int t2 = newTmpId();
-        translateExp(exp->child, t1);
-        translateExp(exp->child->sib->sib, t2);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_MUL;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_TEMP;
-        irList->code.arg2.u.tmpId = t2;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        int t2 = newTmpId(ctx);
+        translateExp(ctx, exp->child, t1);
+        translateExp(ctx, exp->child->sib->sib, t2);
+
+        IR code = newCode();
+        code.kind = IR_MUL;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2.kind = OP_TEMP;
+        code.arg2.id = t2;
+        addCode(ctx, &code);
     } else if(exp->child->sib->type == NODE_DIV) {
-        int t1 = newTmpId();
-        int t2 = newTmpId();
-        translateExp(exp->child, t1);
-        translateExp(exp->child->sib->sib, t2);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_DIV;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_TEMP;
-        irList->code.arg2.u.tmpId = t2;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        int t2 = newTmpId(ctx);
+        translateExp(ctx, exp->child, t1);
+        translateExp(ctx, exp->child->sib->sib, t2);
+
+        IR code = newCode();
+        code.kind = IR_DIV;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2.kind = OP_TEMP;
+        code.arg2.id = t2;
+        addCode(ctx, &code);
     } else if(exp->child->type == NODE_MINUS) {
-        int t1 = newTmpId();
-        translateExp(exp->child->sib, t1);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_SUB;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_CONST;
-        irList->code.arg1.u.value = 0;
-        irList->code.arg2.kind = OP_TEMP;
-        irList->code.arg2.u.tmpId = t1;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, exp->child->sib, t1);
+
+        IR code = newCode();
+        code.kind = IR_SUB;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1 = constOperand(ctx, 0);
+        code.arg2.kind = OP_TEMP;
+        code.arg2.id = t1;
+        addCode(ctx, &code);
     } else if(exp->child->sib->type == NODE_RELOP
             || exp->child->sib->type == NODE_AND
             || exp->child->sib->type == NODE_OR
             || exp->child->type == NODE_NOT) {
-        int label_true = newLableId();
-        int label_false = newLableId();
+        int label_true = newLableId(ctx);
+        int label_false = newLableId(ctx);
 
         // pre assign 0
-        IRList *irList = newIRList();
-        irList->code.kind = IR_ASSIGN;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_CONST;
-        irList->code.arg1.u.value = 0;
-        addCode(irList);
-
-        translateCond(exp, label_true, label_false);
-        genLabel(label_true);
-
-        irList = newIRList();
-        irList->code.kind = IR_ASSIGN;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_CONST;
-        irList->code.arg1.u.value = 1;
-        addCode(irList);
-
-        genLabel(label_false);
+        IR code = newCode();
+        code.kind = IR_ASSIGN;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1 = constOperand(ctx, 0);
+        addCode(ctx, &code);
+
+        translateCond(ctx, exp, label_true, label_false);
+        genLabel(ctx, label_true);
+
+        code = newCode();
+        code.kind = IR_ASSIGN;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1 = constOperand(ctx, 1);
+        addCode(ctx, &code);
+
+        genLabel(ctx, label_false);
     } else if(exp->child->sib->type == NODE_LB) {   // exp -> exp lb exp rb
-        translateArr(exp, place);
+        translateArr(ctx, exp, place);
         /* int addr = newTmpId(); */
         /* translateArr(exp, addr); */
 
-        /* IRList *irList = newIRList(); */
-        /* irList->code.kind = IR_DEREF_R; */
-        /* irList->code.result.kind = OP_TEMP; */
-        /* irList->code.result.u.tmpId = place; */
-        /* irList->code.arg1.kind = OP_TEMP; */
-        /* irList->code.arg1.u.tmpId = addr; */
-        /* addCode(irList); */
+        /* IR code = newCode(); */
+        /* code.kind = IR_DEREF_R; */
+        /* code.result.kind = OP_TEMP; */
+        /* code.result.id = place; */
+        /* code.arg1.kind = OP_TEMP; */
+        /* code.arg1.id = addr; */
+        /* addCode(&code); */
     } else if(exp->child->sib->type == NODE_DOT) {
-        int addr = newTmpId();
-        translateExp(exp->child, addr);
-        Type *type = getExpType(exp->child);
+        int addr = newTmpId(ctx);
+        translateExp(ctx, exp->child, addr);
+        Type *type = getExpType(ctx, exp->child);
         assert(type->kind == STRUCTURE);
-        char *name = exp->child->sib->sib->val.name;
-        FieldList *field = type->u.structure;
-        int offset = 0;
-        while(strcmp(field->name, name) != 0) {
-            offset += getTypeSize(field->type);
-            assert(field->next);
-            field = field->next;
-        }
+        Atom name = exp->child->sib->sib->val.name;
+        FieldList *field = getField(type, name);
+        assert(field);
+        int offset = field->offset;
 
-        Type *type1 = getExpType(exp);
+        Type *type1 = getExpType(ctx, exp);
         if(type1->kind != BASIC) {
-            IRList *irList = newIRList();
-            irList->code.kind = IR_ADD;
-            irList->code.result.kind = OP_TEMP;
-            irList->code.result.u.tmpId = place;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = addr;
-            irList->code.arg2.kind = OP_CONST;
-            irList->code.arg2.u.value = offset;
-            addCode(irList);
+            IR code = newCode();
+            code.kind = IR_ADD;
+            code.result.kind = OP_TEMP;
+            code.result.id = place;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = addr;
+            code.arg2 = constOperand(ctx, offset);
+            addCode(ctx, &code);
             return;
         }
         
-        int t1 = newTmpId();
-        IRList *irList = newIRList();
-        irList->code.kind = IR_ADD;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = t1;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = addr;
-        irList->code.arg2.kind = OP_CONST;
-        irList->code.arg2.u.value = offset;
-        addCode(irList);
-
-        irList = newIRList();
-        irList->code.kind = IR_DEREF_R;
-        irList->code.result.kind = OP_TEMP;
-        irList->code.result.u.tmpId = place;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        IR code = newCode();
+        code.kind = IR_ADD;
+        code.result.kind = OP_TEMP;
+        code.result.id = t1;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = addr;
+        code.arg2 = constOperand(ctx, offset);
+        addCode(ctx, &code);
+
+        code = newCode();
+        code.kind = IR_DEREF_R;
+        code.result.kind = OP_TEMP;
+        code.result.id = place;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        addCode(ctx, &code);
     } else {
         assert(0);
     }
 }
 
-void translateCond(Node *exp, int label_true, int label_false) {
+void translateCond(CompilerContext *ctx, Node *exp, int label_true, int label_false) {
     if(exp->childno == 1) { // id and int
-        int t1 = newTmpId();
-        translateExp(exp, t1);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_RELOP;
-        irList->code.result.kind = OP_LABEL;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_CONST;
-        irList->code.arg2.u.value = 0;
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, exp, t1);
+
+        IR code = newCode();
+        code.kind = IR_RELOP;
+        code.result.kind = OP_LABEL;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2 = constOperand(ctx, 0);
         if(label_true != LABEL_FALL && label_false != LABEL_FALL) {
-            irList->code.result.u.labelId = label_true;
-            irList->code.u.relop = RELOP_NE;
-            addCode(irList);
-            genGoto(label_false);
+            code.result.id = label_true;
+            code.relop = RELOP_NE;
+            addCode(ctx, &code);
+            genGoto(ctx, label_false);
         } else if(label_true == LABEL_FALL) {
-            irList->code.result.u.labelId = label_false;
-            irList->code.u.relop = RELOP_EQ;
-            addCode(irList);
+            code.result.id = label_false;
+            code.relop = RELOP_EQ;
+            addCode(ctx, &code);
         } else if(label_false == LABEL_FALL) {
-            irList->code.result.u.labelId = label_true;
-            irList->code.u.relop = RELOP_NE;
-            addCode(irList);
+            code.result.id = label_true;
+            code.relop = RELOP_NE;
+            addCode(ctx, &code);
         }
         return;
     }
     if(exp->child->type == NODE_NOT) {
-        translateCond(exp->child->sib, label_false, label_true);
+        translateCond(ctx, exp->child->sib, label_false, label_true);
     } else if(exp->child->sib->type == NODE_RELOP) {
-        int t1 = newTmpId();
-        int t2 = newTmpId();
-        translateExp(exp->child, t1);
-        translateExp(exp->child->sib->sib, t2);
+        int t1 = newTmpId(ctx);
+        int t2 = newTmpId(ctx);
+        translateExp(ctx, exp->child, t1);
+        translateExp(ctx, exp->child->sib->sib, t2);
 
         if(label_true != LABEL_FALL && label_false != LABEL_FALL) {
-            IRList *irList = newIRList();
-            irList->code.kind = IR_RELOP;
-            irList->code.u.relop = getRelop(exp->child->sib);
-            irList->code.result.kind = OP_LABEL;
-            irList->code.result.u.labelId = label_true;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = t1;
-            irList->code.arg2.kind = OP_TEMP;
-            irList->code.arg2.u.tmpId = t2;
-            addCode(irList);
-            genGoto(label_false);
+            IR code = newCode();
+            code.kind = IR_RELOP;
+            code.relop = getRelop(exp->child->sib);
+            code.result.kind = OP_LABEL;
+            code.result.id = label_true;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = t1;
+            code.arg2.kind = OP_TEMP;
+            code.arg2.id = t2;
+            addCode(ctx, &code);
+            genGoto(ctx, label_false);
         } else if(label_true == LABEL_FALL) {
-            IRList *irList = newIRList();
-            irList->code.kind = IR_RELOP;
-            irList->code.u.relop = getRevRelop(getRelop(exp->child->sib));
-            irList->code.result.kind = OP_LABEL;
-            irList->code.result.u.labelId = label_false;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = t1;
-            irList->code.arg2.kind = OP_TEMP;
-            irList->code.arg2.u.tmpId = t2;
-            addCode(irList);
+            IR code = newCode();
+            code.kind = IR_RELOP;
+            code.relop = getRevRelop(getRelop(exp->child->sib));
+            code.result.kind = OP_LABEL;
+            code.result.id = label_false;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = t1;
+            code.arg2.kind = OP_TEMP;
+            code.arg2.id = t2;
+            addCode(ctx, &code);
         } else if(label_false == LABEL_FALL) {
-            IRList *irList = newIRList();
-            irList->code.kind = IR_RELOP;
-            irList->code.u.relop = getRelop(exp->child->sib);
-            irList->code.result.kind = OP_LABEL;
-            irList->code.result.u.labelId = label_true;
-            irList->code.arg1.kind = OP_TEMP;
-            irList->code.arg1.u.tmpId = t1;
-            irList->code.arg2.kind = OP_TEMP;
-            irList->code.arg2.u.tmpId = t2;
-            addCode(irList);
+            IR code = newCode();
+            code.kind = IR_RELOP;
+            code.relop = getRelop(exp->child->sib);
+            code.result.kind = OP_LABEL;
+            code.result.id = label_true;
+            code.arg1.kind = OP_TEMP;
+            code.arg1.id = t1;
+            code.arg2.kind = OP_TEMP;
+            code.arg2.id = t2;
+            addCode(ctx, &code);
         } else {
             assert(0);
         }
     } else if(exp->child->sib->type == NODE_AND) {
         if(label_false == LABEL_FALL) {
-            int exp1_false = newLableId();
-            translateCond(exp->child, LABEL_FALL, exp1_false);
-            translateCond(exp->child->sib->sib, label_true, label_false);
-            genLabel(exp1_false);
+            int exp1_false = newLableId(ctx);
+            translateCond(ctx, exp->child, LABEL_FALL, exp1_false);
+            translateCond(ctx, exp->child->sib->sib, label_true, label_false);
+            genLabel(ctx, exp1_false);
         } else {
-            translateCond(exp->child, LABEL_FALL, label_false);
-            translateCond(exp->child->sib->sib, label_true, label_false);
+            translateCond(ctx, exp->child, LABEL_FALL, label_false);
+            translateCond(ctx, exp->child->sib->sib, label_true, label_false);
         }
     } else if(exp->child->sib->type == NODE_OR) {
         if(label_true == LABEL_FALL) {
-            int exp1_true = newLableId();
-            translateCond(exp->child, exp1_true, LABEL_FALL);
-            translateCond(exp->child->sib->sib, label_true, label_false);
-            genLabel(exp1_true);
+            int exp1_true = newLableId(ctx);
+            translateCond(ctx, exp->child, exp1_true, LABEL_FALL);
+            translateCond(ctx, exp->child->sib->sib, label_true, label_false);
+            genLabel(ctx, exp1_true);
         } else {
-            translateCond(exp->child, label_true, LABEL_FALL);
-            translateCond(exp->child->sib->sib, label_true, label_false);
+            translateCond(ctx, exp->child, label_true, LABEL_FALL);
+            translateCond(ctx, exp->child->sib->sib, label_true, label_false);
         }
     } else if(exp->child->type == NODE_LP){
-        translateCond(exp->child->sib, label_true, label_false);
+        translateCond(ctx, exp->child->sib, label_true, label_false);
     } else {
-        int t1 = newTmpId();
-        translateExp(exp, t1);
-
-        IRList *irList = newIRList();
-        irList->code.kind = IR_RELOP;
-        irList->code.result.kind = OP_LABEL;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        irList->code.arg2.kind = OP_CONST;
-        irList->code.arg2.u.value = 0;
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, exp, t1);
+
+        IR code = newCode();
+        code.kind = IR_RELOP;
+        code.result.kind = OP_LABEL;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        code.arg2 = constOperand(ctx, 0);
         if(label_true != LABEL_FALL && label_false != LABEL_FALL) {
-            irList->code.result.u.labelId = label_true;
-            irList->code.u.relop = RELOP_NE;
-            addCode(irList);
-            genGoto(label_false);
+            code.result.id = label_true;
+            code.relop = RELOP_NE;
+            addCode(ctx, &code);
+            genGoto(ctx, label_false);
         } else if(label_true == LABEL_FALL) {
-            irList->code.result.u.labelId = label_false;
-            irList->code.u.relop = RELOP_EQ;
-            addCode(irList);
+            code.result.id = label_false;
+            code.relop = RELOP_EQ;
+            addCode(ctx, &code);
         } else if(label_false == LABEL_FALL) {
-            irList->code.result.u.labelId = label_true;
-            irList->code.u.relop = RELOP_NE;
-            addCode(irList);
+            code.result.id = label_true;
+            code.relop = RELOP_NE;
+            addCode(ctx, &code);
         } else {
             assert(0);
         }
     }
 }
 
-ArgNode* translateArgs(ArgNode *argList, Node *args) {
+ArgNode* translateArgs(CompilerContext *ctx, ArgNode *argList, Node *args) {
     assert(args->type == NODE_Args);
 
-    int t1 = newTmpId();
-    translateExp(args->child, t1);
+    int t1 = newTmpId(ctx);
+    translateExp(ctx, args->child, t1);
     ArgNode *arg = (ArgNode*)malloc(sizeof(ArgNode));
     arg->next = argList;
     arg->tmpId = t1;
@@ -1120,23 +1189,23 @@ ArgNode* translateArgs(ArgNode *argList, Node *args) {
     if(args->childno == 1) {
         return arg;
     } else {
-        return translateArgs(arg, args->child->sib->sib);
+        return translateArgs(ctx, arg, args->child->sib->sib);
     }
 }
 
-ArgNode* translateArgs1(Node *args) {
+ArgNode* translateArgs1(CompilerContext *ctx, Node *args) {
     assert(args->type == NODE_Args);
     if(args->childno == 1) {
-        int t1 = newTmpId();
-        translateExp(args->child, t1);
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, args->child, t1);
         ArgNode *arg = (ArgNode*)malloc(sizeof(ArgNode));
         arg->next = NULL;
         arg->tmpId = t1;
         return arg;
     } else {
-        ArgNode* argList = translateArgs1(args->child->sib->sib);
-        int t1 = newTmpId();
-        translateExp(args->child, t1);
+        ArgNode* argList = translateArgs1(ctx, args->child->sib->sib);
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, args->child, t1);
         ArgNode *arg = (ArgNode*)malloc(sizeof(ArgNode));
         arg->next = NULL;
         arg->tmpId = t1;
@@ -1149,44 +1218,44 @@ ArgNode* translateArgs1(Node *args) {
     }
 }
 
-void translateStmt(Node *stmt) {
+void translateStmt(CompilerContext *ctx, Node *stmt) {
     assert(stmt->type == NODE_Stmt);
     if(stmt->child->type == NODE_Exp) {
-        translateExp(stmt->child, VAR_NULL);
+        translateExp(ctx, stmt->child, VAR_NULL);
     } else if(stmt->child->type == NODE_CompSt) {
-        translate(stmt->child);
+        translate(ctx, stmt->child);
     } else if(stmt->child->type == NODE_RETURN) {
-        int t1 = newTmpId();
-        translateExp(stmt->child->sib, t1);
-        IRList *irList = newIRList();
-        irList->code.kind = IR_RET;
-        irList->code.arg1.kind = OP_TEMP;
-        irList->code.arg1.u.tmpId = t1;
-        addCode(irList);
+        int t1 = newTmpId(ctx);
+        translateExp(ctx, stmt->child->sib, t1);
+        IR code = newCode();
+        code.kind = IR_RET;
+        code.arg1.kind = OP_TEMP;
+        code.arg1.id = t1;
+        addCode(ctx, &code);
     } else if(stmt->child->type == NODE_WHILE) {
-        int begin = newLableId();
-        int label_false = newLableId();
-
-        genLabel(begin);
-        translateCond(stmt->child->sib->sib, LABEL_FALL, label_false);
-        translateStmt(stmt->child->sib->sib->sib->sib);
-        genGoto(begin);
-        genLabel(label_false);
+        int begin = newLableId(ctx);
+        int label_false = newLableId(ctx);
+
+        genLabel(ctx, begin);
+        translateCond(ctx, stmt->child->sib->sib, LABEL_FALL, label_false);
+        translateStmt(ctx, stmt->child->sib->sib->sib->sib);
+        genGoto(ctx, begin);
+        genLabel(ctx, label_false);
     } else if(stmt->child->type == NODE_IF) {
         if(stmt->childno == 5) {  // if lb exp rb stmt
-            int label_false = newLableId();
-            translateCond(stmt->child->sib->sib, LABEL_FALL, label_false);
-            translateStmt(stmt->child->sib->sib->sib->sib);
-            genLabel(label_false);
+            int label_false = newLableId(ctx);
+            translateCond(ctx, stmt->child->sib->sib, LABEL_FALL, label_false);
+            translateStmt(ctx, stmt->child->sib->sib->sib->sib);
+            genLabel(ctx, label_false);
         } else if(stmt->childno == 7) {
-            int label_false = newLableId();
-            int label_next = newLableId();
-            translateCond(stmt->child->sib->sib, LABEL_FALL, label_false);
-            translateStmt(stmt->child->sib->sib->sib->sib);
-            genGoto(label_next);
-            genLabel(label_false);
-            translateStmt(stmt->child->sib->sib->sib->sib->sib->sib);
-            genLabel(label_next);
+            int label_false = newLableId(ctx);
+            int label_next = newLableId(ctx);
+            translateCond(ctx, stmt->child->sib->sib, LABEL_FALL, label_false);
+            translateStmt(ctx, stmt->child->sib->sib->sib->sib);
+            genGoto(ctx, label_next);
+            genLabel(ctx, label_false);
+            translateStmt(ctx, stmt->child->sib->sib->sib->sib->sib->sib);
+            genLabel(ctx, label_next);
         } else {
             assert(0);
         }
@@ -1199,208 +1268,344 @@ bool isOperandValid(Operand operand) {
     return operand.kind != OP_INV;
 }
 
-void optimize() {
-    bool changed = false;
-    do {
-        /* printf("optimize once\n"); */
-        optimize_once(&changed);
-    } while(changed);
-    /* last_optimize(); */
+// the local passes clean up every function first, so the inliner sizes
+// cleaned up callees. then each function in turn has its self tail
+// recursion made a loop, the local passes again, SSA form to see across
+// blocks what they can't, and the local passes once more for the copies
+// SSA leaves
+void optimize(CompilerContext *ctx) {
+    for(IRFunc *func = ctx->funcList; func; func = func->next) {
+        optimizeFunc(ctx, func);
+    }
+    inlineCalls(ctx);
+    for(IRFunc *func = ctx->funcList; func; func = func->next) {
+        eliminateTailRecursion(ctx, func);
+        optimizeFunc(ctx, func);
+        ssaOptimize(ctx, func);
+        optimizeFunc(ctx, func);
+    }
 }
 
-void removeCode(IRList *code) {
-    // single node
-    if(code->next == code) {
-        codeList = NULL;
-        free(code);
+// the slot is left as a tombstone, compactCode drops it later
+void removeCode(IRFunc *func, IR *code) {
+    assert(code->kind != IR_DEAD);
+    if(isControlCode(code)) {
+        invalidateCFG(func);
+    }
+    if(code->kind == IR_LABEL) {
+        labelUse(func, code->arg1.id)->def = -1;
+    } else if(code->kind == IR_GOTO || code->kind == IR_RELOP) {
+        dropLabelUse(func, jumpLabel(code), code - func->codes);
+    }
+    code->kind = IR_DEAD;
+    func->dead++;
+}
+
+// a RELOP whose outcome is known becomes a GOTO, or goes if never taken.
+// the label keeps its use at the same index
+void resolveRelop(IRFunc *func, IR *code, bool taken) {
+    assert(code->kind == IR_RELOP);
+    if(!taken) {
+        removeCode(func, code);
         return;
     }
-    // pick up code node
-    code->next->prev = code->prev;
-    code->prev->next = code->next;
-    if(code == codeList) {  // change global codelist
-        codeList = code->next;
+    code->kind = IR_GOTO;
+    code->arg1 = code->result;
+    invalidateCFG(func);
+}
+
+// codes replaces the whole array of func, which takes it over
+void setCodes(IRFunc *func, IR *codes, int cnt, int cap) {
+    free(func->codes);
+    func->codes = codes;
+    func->cnt = cnt;
+    func->cap = cap;
+    func->dead = 0;
+    for(int i = 0; i < func->labelCnt; i++) {
+        func->labels[i].def = -1;
+        func->labels[i].useCnt = 0;
+    }
+    for(int i = 0; i < cnt; i++) {
+        if(codes[i].kind == IR_LABEL) {
+            labelUse(func, codes[i].arg1.id)->def = i;
+        } else if(codes[i].kind == IR_GOTO || codes[i].kind == IR_RELOP) {
+            addLabelUse(func, jumpLabel(codes + i), i);
+        }
     }
-    free(code);
+    invalidateCFG(func);
 }
 
-void optimize_once(bool *changed) {
-    *changed = false;
-    if(!codeList) return;
-    // assignment optimization
-    assignSubs(changed);
-    // constant optimization
-    evalConst(changed);
-    // delete unused code
-    assignElimit(changed);
-
-    labelElimit(changed);
+// setCodes with every label of codes renamed, in order, to a fresh one. a
+// function taking labels made after its own keeps one short label range
+void relabelCodes(CompilerContext *ctx, IRFunc *func, IR *codes, int cnt, int cap) {
+    int min = OPERAND_ID_MAX, max = -1;
+    for(int i = 0; i < cnt; i++) {
+        if(codes[i].kind == IR_LABEL) {
+            min = (int)codes[i].arg1.id < min ? (int)codes[i].arg1.id : min;
+            max = (int)codes[i].arg1.id > max ? (int)codes[i].arg1.id : max;
+        }
+    }
+    int range = max >= min ? max - min + 1 : 0;
+    int *fresh = (int*)malloc(sizeof(int) * (range + 1));
+    memset(fresh, -1, sizeof(int) * range);
+    for(int i = 0; i < func->labelCnt; i++) {
+        free(func->labels[i].uses);
+    }
+    free(func->labels);
+    func->labels = NULL;
+    func->labelCnt = 0;
+    func->labelBase = ctx->labelId;
+    for(int i = 0; i < cnt; i++) {
+        Operand *label = NULL;
+        if(codes[i].kind == IR_LABEL || codes[i].kind == IR_GOTO) {
+            label = &codes[i].arg1;
+        } else if(codes[i].kind == IR_RELOP) {
+            label = &codes[i].result;
+        }
+        if(!label) continue;
+        int k = label->id - min;
+        assert(k >= 0 && k < range);    // every jump goes to a label of codes
+        if(fresh[k] < 0) {
+            fresh[k] = newLableId(ctx);
+        }
+        label->id = fresh[k];
+    }
+    free(fresh);
+    setCodes(func, codes, cnt, cap);
 }
 
-// remove all dead code which is related to op
-DeadCode* updateDeadList(DeadCode *deadList, Operand op) {
-    DeadCode *cur = deadList;
-    DeadCode *prev = deadList;
-    while(cur) {
-        if(isOperandEqual(cur->irList->code.result, op)) { // remove cur node
-            DeadCode *p = cur;
-            if(cur == deadList) {
-                deadList = cur->next;
-                prev = deadList;
-                cur = deadList;
+// previous code which is not removed, NULL for the FUNCTION
+IR* prevCode(IRFunc *func, IR *code) {
+    while(code > func->codes) {
+        code--;
+        if(code->kind != IR_DEAD) return code;
+    }
+    return NULL;
+}
+
+// next code which is not removed, NULL at the end of the function
+IR* nextCode(IRFunc *func, IR *code) {
+    while(++code < func->codes + func->cnt) {
+        if(code->kind != IR_DEAD) return code;
+    }
+    return NULL;
+}
+
+// the blocks of a valid CFG are moved along with their codes
+void compactCode(IRFunc *func) {
+    if(!func->dead) return;
+    int cnt = 0;
+    int *newIndex = (int*)malloc(sizeof(int) * (func->cnt + 1));
+    for(int i = 0; i < func->cnt; i++) {
+        newIndex[i] = cnt;
+        if(func->codes[i].kind != IR_DEAD) {
+            func->codes[cnt++] = func->codes[i];
+        }
+    }
+    newIndex[func->cnt] = cnt;
+    remapCFG(func, newIndex);
+    for(int i = 0; i < func->labelCnt; i++) {
+        LabelUse *label = func->labels + i;
+        if(label->def >= 0) {
+            label->def = newIndex[label->def];
+        }
+        for(int k = 0; k < label->useCnt; k++) {
+            label->uses[k] = newIndex[label->uses[k]];
+        }
+    }
+    free(newIndex);
+    func->cnt = cnt;
+    func->dead = 0;
+}
+
+typedef void (*OptPass)(CompilerContext *ctx, IRFunc *func, bool *changed);
+
+// in the order of a round
+static const OptPass optPasses[OPT_PASS_NUM] = {
+    assignSubs,     // assignment optimization
+    evalConst,      // constant optimization
+    assignElimit,   // delete unused code
+    labelElimit,
+    jumpThread
+};
+
+// rounds of the passes until one changes nothing. every edit bumps version;
+// a pass which found nothing to do at the current version would find nothing
+// again, so it is skipped until some other pass edits the function
+void optimizeFunc(CompilerContext *ctx, IRFunc *func) {
+    OptStats *stats = &ctx->optStats;
+    int version = 0;
+    int clean[OPT_PASS_NUM];    // version of the last run which changed nothing
+    int rounds = 0;
+    bool changed = true;
+    for(int k = 0; k < OPT_PASS_NUM; k++) {
+        clean[k] = -1;
+    }
+    while(changed) {
+        if(rounds == OPT_MAX_ROUNDS) {
+            stats->budgetHits++;
+            break;
+        }
+        rounds++;
+        changed = false;
+        for(int k = 0; k < OPT_PASS_NUM; k++) {
+            if(clean[k] == version) {
+                stats->passSkips++;
+                continue;
+            }
+            bool passChanged = false;
+            int dead = func->dead;
+            optPasses[k](ctx, func, &passChanged);
+            stats->passRuns++;
+            if(passChanged || func->dead != dead) {   // a removal is an edit even if not reported
+                version++;
+                changed = changed || passChanged;
             } else {
-                prev->next = cur->next;
-                cur = cur->next;
+                clean[k] = version;
             }
-            free(p);
-        } else {
-            prev = cur;
-            cur = cur->next;
         }
+        compactCode(func);
+    }
+    stats->funcs++;
+    stats->rounds += rounds;
+    if(rounds > stats->maxRounds) {
+        stats->maxRounds = rounds;
     }
-    return deadList;
 }
 
+void printOptStats(CompilerContext *ctx, FILE *stream) {
+    OptStats *stats = &ctx->optStats;
+    fprintf(stream, "optimizer: %d functions, %d rounds (at most %d in a function), %d pass runs, %d skipped, %d over budget\n",
+            stats->funcs, stats->rounds, stats->maxRounds, stats->passRuns, stats->passSkips, stats->budgetHits);
+    fprintf(stream, "ssa: %d constant uses, %d constant codes, %d branches resolved, %d dead blocks, %d redundant codes\n",
+            stats->constUses, stats->constDefs, stats->branches, stats->deadBlocks, stats->redundant);
+    fprintf(stream, "loops: %d codes hoisted, %d induction multiplies reduced\n", stats->hoisted, stats->reduced);
+    fprintf(stream, "inline: %d calls inlined, %d functions removed\n", stats->inlined, stats->funcsRemoved);
+    fprintf(stream, "tail: %d recursions made loops, %d calls reusing the frame\n", stats->tailRecursions, stats->tailCalls);
+}
+
+// constants and symbols are interned, equal operands have equal ids
 bool isOperandEqual(Operand op1, Operand op2) {
-    if(op1.kind == op2.kind) {
-        if(op1.kind == OP_TEMP) {
-            return op1.u.tmpId == op2.u.tmpId;
-        } else if(op1.kind == OP_VAR) {
-            return op1.u.symbol == op2.u.symbol;
-        } else if(op1.kind == OP_CONST) {
-            return op1.u.value == op2.u.value;
-        }
-    }
-    return false;
+    return op1.kind <= OP_CONST && op1.kind == op2.kind && op1.id == op2.id;
 }
 
-void assignSubs1(bool *changed) {
-    IRList *p = codeList;
-    IRList *irList1 = NULL;
-    IRList *irList2 = NULL;
+void assignSubs1(CompilerContext *ctx, IRFunc *func, bool *changed) {
+    IR *code1 = NULL;
+    IR *code2 = NULL;
     HashTable *hashTable = newHashTable();
-    do {
-        switch(p->code.kind) {
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        switch(p->kind) {
             case IR_LABEL:
             case IR_FUNC:
                 HT_clear(hashTable);
                 break;
             case IR_ASSIGN:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && !isOperandEqual(irList1->code.result, p->code.result)) {   // TODO: check correctness
-                    switch(irList1->code.kind) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && !isOperandEqual(code1->result, p->result)) {   // TODO: check correctness
+                    switch(code1->kind) {
                         case IR_REF:
                             *changed = true;
-                            p->code.kind = IR_REF;
-                            p->code.arg1 = irList1->code.arg1;
+                            p->kind = IR_REF;
+                            p->arg1 = code1->arg1;
                             break;
                         case IR_DEREF_R:    // warning!!!
                             break;
                         case IR_ASSIGN:
-                            if(irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) {
+                            if(checkOrder(HT_find(hashTable, code1->arg1), code1)) {
                                 *changed = true;
-                                p->code.kind = irList1->code.kind;
-                                p->code.arg1 = irList1->code.arg1;
+                                p->kind = code1->kind;
+                                p->arg1 = code1->arg1;
                             }
                             break;
                         default:
                             break;
                     }
                 }
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_ADD:
             case IR_SUB:
             case IR_MUL:
             case IR_DIV:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                irList2 = HT_find(hashTable, p->code.arg2);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                code2 = HT_find(hashTable, p->arg2);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                if(irList2 && irList2->code.kind == IR_ASSIGN && (irList2->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList2->code.arg1),irList2, p))) {
+                if(code2 && code2->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code2->arg1), code2))) {
                     *changed = true;
-                    p->code.arg2 = irList2->code.arg1;
+                    p->arg2 = code2->arg1;
                 }
-                if(isOperandEqual(p->code.arg1, p->code.arg2) && p->code.kind == IR_SUB) {
+                if(isOperandEqual(p->arg1, p->arg2) && p->kind == IR_SUB) {
                     *changed = true;
-                    p->code.kind = IR_ASSIGN;
-                    p->code.arg1.kind = OP_CONST;
-                    p->code.arg1.u.value = 0;
-                } else if(isOperandEqual(p->code.arg1, p->code.arg2) && p->code.kind == IR_DIV) {
+                    p->kind = IR_ASSIGN;
+                    p->arg1 = constOperand(ctx, 0);
+                } else if(isOperandEqual(p->arg1, p->arg2) && p->kind == IR_DIV) {
                     *changed = true;
-                    p->code.kind = IR_ASSIGN;
-                    p->code.arg1.kind = OP_CONST;
-                    p->code.arg1.u.value = 1;
-                } else {
-                    /* irList1 = lookback(p->prev, p); */
-                    /* if(irList1) { */
-                    /*     *changed = true; */
-                    /*     p->code.kind = IR_ASSIGN; */
-                    /*     p->code.arg1 = irList1->code.result; */
-                    /* } */
+                    p->kind = IR_ASSIGN;
+                    p->arg1 = constOperand(ctx, 1);
                 }
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_REF:
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_DEREF_L:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                irList2 = HT_find(hashTable, p->code.result);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                code2 = HT_find(hashTable, p->result);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                if(irList2 && irList2->code.kind == IR_ASSIGN && (irList2->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p))) {
+                if(code2 && code2->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code2->arg1), code2))) {
                     *changed = true;
-                    p->code.result = irList2->code.arg1;
+                    p->result = code2->arg1;
                 }
                 break;
             case IR_DEREF_R:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_ARG:
             case IR_WRITE:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
                 break;
             /* case IR_GOTO: */
             /*     break; */
             case IR_RELOP:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                irList2 = HT_find(hashTable, p->code.arg2);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                code2 = HT_find(hashTable, p->arg2);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                if(irList2 && irList2->code.kind == IR_ASSIGN && (irList2->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p))) {
+                if(code2 && code2->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code2->arg1), code2))) {
                     *changed = true;
-                    p->code.arg2 = irList2->code.arg1;
+                    p->arg2 = code2->arg1;
                 }
                 /* HT_clear(hashTable); */
                 break;
             case IR_RET:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
                 /* HT_clear(hashTable); */  // TODO: check the correctness
                 break;
             /* case IR_DEC: */
             /*     break; */
             case IR_CALL:
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             /* case IR_PARM: */
             /*     break; */
@@ -1411,323 +1616,306 @@ void assignSubs1(bool *changed) {
             default:
                 break;
         }
-        p = p->next;
-    } while(p != codeList);
+    }
     HT_clear(hashTable);
     free(hashTable);
 }
 
-void assignSubs(bool *changed) {
-    IRList *p = codeList;
-    IRList *irList1 = NULL;
-    IRList *irList2 = NULL;
+void assignSubs(CompilerContext *ctx, IRFunc *func, bool *changed) {
+    IR *code1 = NULL;
+    IR *code2 = NULL;
     HashTable *hashTable = newHashTable();
     /* Operand arg1, arg2; */
-    do {
-        if(isModifyInstr(p->prev, p->code.result) && isModifyInstr(p, p->code.result) && isOperandEqual(p->prev->code.result, p->code.result)) {
-            removeCode(p->prev);
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        IR *prev = prevCode(func, p);
+        if(prev && isModifyInstr(prev, p->result) && isModifyInstr(p, p->result) && isOperandEqual(prev->result, p->result)) {
+            removeCode(func, prev);
         }
-        switch(p->code.kind) {
+        switch(p->kind) {
             case IR_LABEL:
             case IR_FUNC:
                 HT_clear(hashTable);
                 break;
             case IR_ASSIGN:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && !isOperandEqual(irList1->code.result, p->code.result)) {   // TODO: check correctness
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && !isOperandEqual(code1->result, p->result)) {   // TODO: check correctness
                     /* bool flag = false; */
-                    switch(irList1->code.kind) {
+                    switch(code1->kind) {
                         case IR_REF:
                             *changed = true;
-                            p->code.kind = IR_REF;
-                            p->code.arg1 = irList1->code.arg1;
+                            p->kind = IR_REF;
+                            p->arg1 = code1->arg1;
                             /* flag = true; */
                             break;
                         case IR_DEREF_R:
                             break;
                         case IR_ASSIGN:
-                            if(irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) {
+                            if(checkOrder(HT_find(hashTable, code1->arg1), code1)) {
                                 *changed = true;
-                                p->code.kind = irList1->code.kind;
-                                p->code.arg1 = irList1->code.arg1;
+                                p->kind = code1->kind;
+                                p->arg1 = code1->arg1;
                             }
                             break;
                         case IR_ADD:
                         case IR_SUB:
                         case IR_MUL:
                         case IR_DIV:
-                            if((irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))
-                                    && (irList1->code.arg2.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg2), irList1, p))) {
+                            if((checkOrder(HT_find(hashTable, code1->arg1), code1))
+                                    && (checkOrder(HT_find(hashTable, code1->arg2), code1))) {
                                 *changed = true;
-                                p->code.kind = irList1->code.kind;
-                                p->code.arg1 = irList1->code.arg1;
-                                p->code.arg2 = irList1->code.arg2;
+                                p->kind = code1->kind;
+                                p->arg1 = code1->arg1;
+                                p->arg2 = code1->arg2;
                             }
                             break;
                         default:
                             break;
                     }
                 }
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_ADD:
             case IR_SUB:
             case IR_MUL:
             case IR_DIV:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                irList2 = HT_find(hashTable, p->code.arg2);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                code2 = HT_find(hashTable, p->arg2);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                if(irList2 && irList2->code.kind == IR_ASSIGN && (irList2->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p))) {
+                if(code2 && code2->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code2->arg1), code2))) {
                     *changed = true;
-                    p->code.arg2 = irList2->code.arg1;
+                    p->arg2 = code2->arg1;
                 }
-                if(p->code.arg1.kind != OP_CONST && p->code.arg2.kind == OP_CONST && (p->code.kind == IR_ADD || p->code.kind == IR_SUB)) {
-                    if(p->code.kind == IR_SUB) {
-                        p->code.kind = IR_ADD;
-                        p->code.arg2.u.value = -p->code.arg2.u.value;
+                if(p->arg1.kind != OP_CONST && p->arg2.kind == OP_CONST && (p->kind == IR_ADD || p->kind == IR_SUB)) {
+                    if(p->kind == IR_SUB) {
+                        p->kind = IR_ADD;
+                        p->arg2 = foldConst(ctx, IR_SUB, constOperand(ctx, 0), p->arg2);
                     }
-                    Operand arg = p->code.arg1;
-                    p->code.arg1 = p->code.arg2;
-                    p->code.arg2 = arg;
+                    Operand arg = p->arg1;
+                    p->arg1 = p->arg2;
+                    p->arg2 = arg;
                 }
-                if(p->code.kind == IR_ADD) {
-                    if(p->code.arg1.kind == OP_CONST && irList2) {  // for example, c = 4 + b
-                        if(irList2->code.kind == IR_ADD && irList2->code.arg1.kind == OP_CONST && (irList2->code.arg2.kind == OP_TEMP
-                                    || checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) { // b = 4 + a
+                if(p->kind == IR_ADD) {
+                    if(p->arg1.kind == OP_CONST && code2) {  // for example, c = 4 + b
+                        if(code2->kind == IR_ADD && code2->arg1.kind == OP_CONST
+                                && (checkOrder(HT_find(hashTable, code2->arg2), code2))) { // b = 4 + a
                             *changed = true;
-                            p->code.arg1.u.value += irList2->code.arg1.u.value; 
-                            p->code.arg2 = irList2->code.arg2;
-                        } else if(irList2->code.kind == IR_SUB && irList2->code.arg1.kind == OP_CONST && (irList2->code.arg2.kind == OP_TEMP
-                                    || checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {  // b = 4 - a
+                            p->arg1 = foldConst(ctx, IR_ADD, p->arg1, code2->arg1);
+                            p->arg2 = code2->arg2;
+                        } else if(code2->kind == IR_SUB && code2->arg1.kind == OP_CONST
+                                && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {  // b = 4 - a
                             *changed = true;
-                            p->code.arg1.u.value += irList2->code.arg1.u.value;
-                            p->code.arg2 = irList2->code.arg2;
-                            p->code.kind = IR_SUB;
+                            p->arg1 = foldConst(ctx, IR_ADD, p->arg1, code2->arg1);
+                            p->arg2 = code2->arg2;
+                            p->kind = IR_SUB;
                         }
-                    } else if(irList1 && irList2) { // a + b
-                        if(irList1->code.kind == IR_SUB && irList2->code.kind == IR_ADD) {
-                            IRList *irList = irList1;
-                            irList1 = irList2;
-                            irList2 = irList;
+                    } else if(code1 && code2) { // a + b
+                        if(code1->kind == IR_SUB && code2->kind == IR_ADD) {
+                            IR *code = code1;
+                            code1 = code2;
+                            code2 = code;
                         }
-                        if(irList1->code.kind == IR_ADD && irList2->code.kind == IR_SUB)  {
-                            if((irList1->code.arg1.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) 
-                                    && (irList1->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList1->code.arg2), irList1, p))
-                                    && (irList2->code.arg1.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p)) 
-                                    && (irList2->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {
-                                if(isOperandEqual(irList1->code.arg1, irList2->code.arg2)) {
-                                /* if(irList1->code.arg1.u.tmpId == irList2->code.arg2.u.tmpId) { */
+                        if(code1->kind == IR_ADD && code2->kind == IR_SUB)  {
+                            if((checkOrder(HT_find(hashTable, code1->arg1), code1)) 
+                                    && (checkOrder(HT_find(hashTable, code1->arg2), code1))
+                                    && (checkOrder(HT_find(hashTable, code2->arg1), code2)) 
+                                    && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {
+                                if(isOperandEqual(code1->arg1, code2->arg2)) {
+                                /* if(code1->arg1.id == code2->arg2.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_ADD;
-                                    p->code.arg1 = irList1->code.arg2;
-                                    p->code.arg2 = irList2->code.arg1;
-                                }else if(isOperandEqual(irList1->code.arg2, irList2->code.arg2)) {
-                                /* } else if(irList1->code.arg2.u.tmpId == irList2->code.arg2.u.tmpId) { */
+                                    p->kind = IR_ADD;
+                                    p->arg1 = code1->arg2;
+                                    p->arg2 = code2->arg1;
+                                }else if(isOperandEqual(code1->arg2, code2->arg2)) {
+                                /* } else if(code1->arg2.id == code2->arg2.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_ADD;
-                                    p->code.arg1 = irList1->code.arg1;
-                                    p->code.arg2 = irList2->code.arg1;
+                                    p->kind = IR_ADD;
+                                    p->arg1 = code1->arg1;
+                                    p->arg2 = code2->arg1;
                                 }
                             }
-                        } else if(irList1->code.kind == IR_SUB && irList2->code.kind == IR_SUB) {
-                            if((irList1->code.arg1.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) 
-                                    && (irList1->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList1->code.arg2), irList1, p))
-                                    && (irList2->code.arg1.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p)) 
-                                    && (irList2->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {
-                            /* if(irList1->code.arg1.kind == OP_TEMP && irList1->code.arg2.kind == OP_TEMP */
-                            /*         && irList2->code.arg1.kind == OP_TEMP && irList2->code.arg2.kind == OP_TEMP) { */
-                                if(isOperandEqual(irList1->code.arg1, irList2->code.arg2)) {
-                                /* if(irList1->code.arg1.u.tmpId == irList2->code.arg2.u.tmpId) { */
+                        } else if(code1->kind == IR_SUB && code2->kind == IR_SUB) {
+                            if((checkOrder(HT_find(hashTable, code1->arg1), code1)) 
+                                    && (checkOrder(HT_find(hashTable, code1->arg2), code1))
+                                    && (checkOrder(HT_find(hashTable, code2->arg1), code2)) 
+                                    && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {
+                            /* if(code1->arg1.kind == OP_TEMP && code1->arg2.kind == OP_TEMP */
+                            /*         && code2->arg1.kind == OP_TEMP && code2->arg2.kind == OP_TEMP) { */
+                                if(isOperandEqual(code1->arg1, code2->arg2)) {
+                                /* if(code1->arg1.id == code2->arg2.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList2->code.arg1;
-                                    p->code.arg2 = irList1->code.arg2;
-                                } else if(isOperandEqual(irList1->code.arg2, irList2->code.arg1)) {
-                                /* } else if(irList1->code.arg2.u.tmpId == irList2->code.arg1.u.tmpId) { */
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code2->arg1;
+                                    p->arg2 = code1->arg2;
+                                } else if(isOperandEqual(code1->arg2, code2->arg1)) {
+                                /* } else if(code1->arg2.id == code2->arg1.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList1->code.arg1;
-                                    p->code.arg2 = irList2->code.arg2;
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code1->arg1;
+                                    p->arg2 = code2->arg2;
                                 }
                             }
                         }
                     }
-                } else if(p->code.kind == IR_SUB) {
-                    if(p->code.arg1.kind == OP_CONST && irList2) {  // for example, c = 4 - b
-                        if(irList2->code.kind == IR_ADD && irList2->code.arg1.kind == OP_CONST 
-                                && (irList2->code.arg2.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) { // b = 4 + a
+                } else if(p->kind == IR_SUB) {
+                    if(p->arg1.kind == OP_CONST && code2) {  // for example, c = 4 - b
+                        if(code2->kind == IR_ADD && code2->arg1.kind == OP_CONST 
+                                && (checkOrder(HT_find(hashTable, code2->arg2), code2))) { // b = 4 + a
                             *changed = true;
-                            p->code.arg1.u.value -= irList2->code.arg1.u.value; 
-                            p->code.arg2 = irList2->code.arg2;
-                        } else if(irList2->code.kind == IR_SUB && irList2->code.arg1.kind == OP_CONST 
-                                && (irList2->code.arg2.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {  // b = 4 - a
+                            p->arg1 = foldConst(ctx, IR_SUB, p->arg1, code2->arg1);
+                            p->arg2 = code2->arg2;
+                        } else if(code2->kind == IR_SUB && code2->arg1.kind == OP_CONST 
+                                && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {  // b = 4 - a
                             *changed = true;
-                            p->code.arg1.u.value -= irList2->code.arg1.u.value;
-                            p->code.arg2 = irList2->code.arg2;
-                            p->code.kind = IR_ADD;
+                            p->arg1 = foldConst(ctx, IR_SUB, p->arg1, code2->arg1);
+                            p->arg2 = code2->arg2;
+                            p->kind = IR_ADD;
                         }
-                    } else if(irList1 && irList2) {
-                        if(irList1->code.kind == IR_SUB && irList2->code.kind == IR_ADD) {
-                            IRList *irList = irList1;
-                            irList1 = irList2;
-                            irList2 = irList;
-                        }
-                        if(irList1->code.kind == IR_ADD && irList2->code.kind == IR_SUB)  {
-                            if((irList1->code.arg1.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) 
-                                    && (irList1->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList1->code.arg2), irList1, p))
-                                    && (irList2->code.arg1.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p)) 
-                                    && (irList2->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {
-                            /* if(irList1->code.arg1.kind == OP_TEMP && irList1->code.arg2.kind == OP_TEMP */
-                            /*         && irList2->code.arg1.kind == OP_TEMP && irList2->code.arg2.kind == OP_TEMP) { */
-                                if(isOperandEqual(irList1->code.arg1, irList2->code.arg1)) {
-                                /* if(irList1->code.arg1.u.tmpId == irList2->code.arg1.u.tmpId) { */
+                    } else if(code1 && code2) {    // no swap, a - b is not b - a
+                        if(code1->kind == IR_ADD && code2->kind == IR_SUB)  {
+                            if((checkOrder(HT_find(hashTable, code1->arg1), code1)) 
+                                    && (checkOrder(HT_find(hashTable, code1->arg2), code1))
+                                    && (checkOrder(HT_find(hashTable, code2->arg1), code2)) 
+                                    && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {
+                            /* if(code1->arg1.kind == OP_TEMP && code1->arg2.kind == OP_TEMP */
+                            /*         && code2->arg1.kind == OP_TEMP && code2->arg2.kind == OP_TEMP) { */
+                                if(isOperandEqual(code1->arg1, code2->arg1)) {
+                                /* if(code1->arg1.id == code2->arg1.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_ADD;
-                                    p->code.arg1 = irList1->code.arg2;
-                                    p->code.arg2 = irList2->code.arg2;
-                                } else if(isOperandEqual(irList1->code.arg2, irList2->code.arg1)) {
-                                /* } else if(irList1->code.arg2.u.tmpId == irList2->code.arg1.u.tmpId) { */
+                                    p->kind = IR_ADD;
+                                    p->arg1 = code1->arg2;
+                                    p->arg2 = code2->arg2;
+                                } else if(isOperandEqual(code1->arg2, code2->arg1)) {
+                                /* } else if(code1->arg2.id == code2->arg1.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_ADD;
-                                    p->code.arg1 = irList1->code.arg1;
-                                    p->code.arg2 = irList2->code.arg2;
+                                    p->kind = IR_ADD;
+                                    p->arg1 = code1->arg1;
+                                    p->arg2 = code2->arg2;
                                 }
                             }
-                        } else if(irList1->code.kind == IR_SUB && irList2->code.kind == IR_SUB) {
-                            if((irList1->code.arg1.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) 
-                                    && (irList1->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList1->code.arg2), irList1, p))
-                                    && (irList2->code.arg1.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p)) 
-                                    && (irList2->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {
-                            /* if(irList1->code.arg1.kind == OP_TEMP && irList1->code.arg2.kind == OP_TEMP */
-                            /*         && irList2->code.arg1.kind == OP_TEMP && irList2->code.arg2.kind == OP_TEMP) { */
-                                if(isOperandEqual(irList1->code.arg1, irList2->code.arg1)) {
-                                /* if(irList1->code.arg1.u.tmpId == irList2->code.arg1.u.tmpId) { */
+                        } else if(code1->kind == IR_SUB && code2->kind == IR_SUB) {
+                            if((checkOrder(HT_find(hashTable, code1->arg1), code1)) 
+                                    && (checkOrder(HT_find(hashTable, code1->arg2), code1))
+                                    && (checkOrder(HT_find(hashTable, code2->arg1), code2)) 
+                                    && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {
+                            /* if(code1->arg1.kind == OP_TEMP && code1->arg2.kind == OP_TEMP */
+                            /*         && code2->arg1.kind == OP_TEMP && code2->arg2.kind == OP_TEMP) { */
+                                if(isOperandEqual(code1->arg1, code2->arg1)) {
+                                /* if(code1->arg1.id == code2->arg1.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList2->code.arg2;
-                                    p->code.arg2 = irList1->code.arg2;
-                                } else if(isOperandEqual(irList1->code.arg2, irList2->code.arg2)) {
-                                /* } else if(irList1->code.arg2.u.tmpId == irList2->code.arg2.u.tmpId) { */
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code2->arg2;
+                                    p->arg2 = code1->arg2;
+                                } else if(isOperandEqual(code1->arg2, code2->arg2)) {
+                                /* } else if(code1->arg2.id == code2->arg2.id) { */
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList1->code.arg1;
-                                    p->code.arg2 = irList2->code.arg1;
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code1->arg1;
+                                    p->arg2 = code2->arg1;
                                 }
                             }
-                        } else if(irList1->code.kind == IR_ADD && irList2->code.kind == IR_ADD) {
-                            if((irList1->code.arg1.kind == OP_TEMP || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p)) 
-                                    && (irList1->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList1->code.arg2), irList1, p))
-                                    && (irList2->code.arg1.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p)) 
-                                    && (irList2->code.arg2.kind == OP_TEMP|| checkOrder(HT_find(hashTable, irList2->code.arg2), irList2, p))) {
-                                if(isOperandEqual(irList1->code.arg1, irList2->code.arg1)) {
+                        } else if(code1->kind == IR_ADD && code2->kind == IR_ADD) {
+                            if((checkOrder(HT_find(hashTable, code1->arg1), code1)) 
+                                    && (checkOrder(HT_find(hashTable, code1->arg2), code1))
+                                    && (checkOrder(HT_find(hashTable, code2->arg1), code2)) 
+                                    && (checkOrder(HT_find(hashTable, code2->arg2), code2))) {
+                                if(isOperandEqual(code1->arg1, code2->arg1)) {
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList1->code.arg2;
-                                    p->code.arg2 = irList2->code.arg2;
-                                } else if(isOperandEqual(irList1->code.arg1, irList2->code.arg2)) {
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code1->arg2;
+                                    p->arg2 = code2->arg2;
+                                } else if(isOperandEqual(code1->arg1, code2->arg2)) {
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList1->code.arg2;
-                                    p->code.arg2 = irList2->code.arg1;
-                                } else if(isOperandEqual(irList1->code.arg2, irList2->code.arg1)) {
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code1->arg2;
+                                    p->arg2 = code2->arg1;
+                                } else if(isOperandEqual(code1->arg2, code2->arg1)) {
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList1->code.arg1;
-                                    p->code.arg2 = irList2->code.arg2;
-                                } else if(isOperandEqual(irList1->code.arg2, irList2->code.arg2)) {
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code1->arg1;
+                                    p->arg2 = code2->arg2;
+                                } else if(isOperandEqual(code1->arg2, code2->arg2)) {
                                     *changed = true;
-                                    p->code.kind = IR_SUB;
-                                    p->code.arg1 = irList1->code.arg1;
-                                    p->code.arg2 = irList2->code.arg1;
+                                    p->kind = IR_SUB;
+                                    p->arg1 = code1->arg1;
+                                    p->arg2 = code2->arg1;
                                 }
                             }
                             }            
 
                     }
                 }
-                if(isOperandEqual(p->code.arg1, p->code.arg2) && p->code.kind == IR_SUB) {
+                if(isOperandEqual(p->arg1, p->arg2) && p->kind == IR_SUB) {
                     *changed = true;
-                    p->code.kind = IR_ASSIGN;
-                    p->code.arg1.kind = OP_CONST;
-                    p->code.arg1.u.value = 0;
-                } else if(isOperandEqual(p->code.arg1, p->code.arg2) && p->code.kind == IR_DIV) {
+                    p->kind = IR_ASSIGN;
+                    p->arg1 = constOperand(ctx, 0);
+                } else if(isOperandEqual(p->arg1, p->arg2) && p->kind == IR_DIV) {
                     *changed = true;
-                    p->code.kind = IR_ASSIGN;
-                    p->code.arg1.kind = OP_CONST;
-                    p->code.arg1.u.value = 1;
-                } else if(p->code.result.kind == OP_TEMP){
-                    /* irList1 = lookback(p->prev, p); */
-                    /* if(irList1) { */
-                    /*     *changed = true; */
-                    /*     p->code.kind = IR_ASSIGN; */
-                    /*     p->code.arg1 = irList1->code.result; */
-                    /*     /1* p->code.arg1.kind = irList1->code.result.kind; *1/ */
-                    /*     /1* p->code.arg1.u = p->code.result.u; *1/ */
-                    /* } */
+                    p->kind = IR_ASSIGN;
+                    p->arg1 = constOperand(ctx, 1);
                 }
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_REF:
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_DEREF_L:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                irList2 = HT_find(hashTable, p->code.result);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                code2 = HT_find(hashTable, p->result);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                if(irList2 && irList2->code.kind == IR_ASSIGN && (irList2->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p))) {
+                if(code2 && code2->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code2->arg1), code2))) {
                     *changed = true;
-                    p->code.result = irList2->code.arg1;
+                    p->result = code2->arg1;
                 }
                 break;
             case IR_DEREF_R:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             case IR_ARG:
             case IR_WRITE:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
                 break;
             /* case IR_GOTO: */
             /*     break; */
             case IR_RELOP:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                irList2 = HT_find(hashTable, p->code.arg2);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                code2 = HT_find(hashTable, p->arg2);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
-                if(irList2 && irList2->code.kind == IR_ASSIGN && (irList2->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList2->code.arg1), irList2, p))) {
+                if(code2 && code2->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code2->arg1), code2))) {
                     *changed = true;
-                    p->code.arg2 = irList2->code.arg1;
+                    p->arg2 = code2->arg1;
                 }
                 /* HT_clear(hashTable); */
                 break;
             case IR_RET:
-                irList1 = HT_find(hashTable, p->code.arg1);
-                if(irList1 && irList1->code.kind == IR_ASSIGN && (irList1->code.arg1.kind != OP_VAR || checkOrder(HT_find(hashTable, irList1->code.arg1), irList1, p))) {
+                code1 = HT_find(hashTable, p->arg1);
+                if(code1 && code1->kind == IR_ASSIGN && (checkOrder(HT_find(hashTable, code1->arg1), code1))) {
                     *changed = true;
-                    p->code.arg1 = irList1->code.arg1;
+                    p->arg1 = code1->arg1;
                 }
                 /* HT_clear(hashTable); */  // TODO: check the correctness
                 break;
             /* case IR_DEC: */
             /*     break; */
             case IR_CALL:
-                HT_insert(hashTable, p->code.result, p);
+                HT_insert(hashTable, p->result, p);
                 break;
             /* case IR_PARM: */
             /*     break; */
@@ -1738,308 +1926,285 @@ void assignSubs(bool *changed) {
             default:
                 break;
         }
-        p = p->next;
-    } while(p != codeList);
+    }
     HT_clear(hashTable);
     free(hashTable);
 }
 
-void evalConst(bool *changed) {
-    IRList *p = codeList;
-    do {
-        if(p->code.kind == IR_ADD) {
+void evalConst(CompilerContext *ctx, IRFunc *func, bool *changed) {
+    int c;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind >= IR_ADD && p->kind <= IR_DIV && p->arg1.kind == OP_CONST && p->arg2.kind == OP_CONST) {
             // constant pre calculate
-            if(p->code.arg1.kind == OP_CONST && p->code.arg2.kind == OP_CONST) {
-                p->code.kind = IR_ASSIGN;
-                /* p->code.arg1.kind = OP_CONST; */
-                p->code.arg1.u.value = p->code.arg1.u.value + p->code.arg2.u.value;
-                *changed = true;
-            } else if(p->code.arg1.kind == OP_CONST && p->code.arg1.u.value == 0) {
-                p->code.kind = IR_ASSIGN;
-                p->code.arg1 = p->code.arg2;
-                *changed = true;
-            } else if(p->code.arg2.kind == OP_CONST && p->code.arg2.u.value == 0) {
-                p->code.kind = IR_ASSIGN;
+            if(foldArith(p->kind, constValue(ctx, p->arg1), constValue(ctx, p->arg2), &c)) {
+                p->kind = IR_ASSIGN;
+                p->arg1 = constOperand(ctx, c);
                 *changed = true;
-                /* p->code.arg1 = p->code.arg1; */
             }
-        } else if(p->code.kind == IR_SUB) {
-            if(p->code.arg1.kind == OP_CONST && p->code.arg2.kind == OP_CONST) {
-                p->code.kind = IR_ASSIGN;
-                /* p->code.arg1.kind = OP_CONST; */
-                p->code.arg1.u.value = p->code.arg1.u.value - p->code.arg2.u.value;
+        } else if(p->kind == IR_ADD) {
+            if(p->arg1.kind == OP_CONST && constValue(ctx, p->arg1) == 0) {
+                p->kind = IR_ASSIGN;
+                p->arg1 = p->arg2;
                 *changed = true;
-            } else if(p->code.arg2.kind == OP_CONST && p->code.arg2.u.value == 0) {
-                p->code.kind = IR_ASSIGN;
+            } else if(p->arg2.kind == OP_CONST && constValue(ctx, p->arg2) == 0) {
+                p->kind = IR_ASSIGN;
                 *changed = true;
-                /* p->code.arg1 = p->code.arg1; */
+                /* p->arg1 = p->arg1; */
             }
-        } else if(p->code.kind == IR_MUL) {
-            if(p->code.arg1.kind == OP_CONST && p->code.arg2.kind == OP_CONST) {
-                p->code.kind = IR_ASSIGN;
-                /* p->code.arg1.kind = OP_CONST; */
-                p->code.arg1.u.value = p->code.arg1.u.value * p->code.arg2.u.value;
+        } else if(p->kind == IR_SUB) {
+            if(p->arg2.kind == OP_CONST && constValue(ctx, p->arg2) == 0) {
+                p->kind = IR_ASSIGN;
                 *changed = true;
-            } else if(p->code.arg1.kind == OP_CONST && p->code.arg1.u.value == 1) {
-                p->code.kind = IR_ASSIGN;
-                p->code.arg1 = p->code.arg2;
+                /* p->arg1 = p->arg1; */
+            }
+        } else if(p->kind == IR_MUL) {
+            if(p->arg1.kind == OP_CONST && constValue(ctx, p->arg1) == 1) {
+                p->kind = IR_ASSIGN;
+                p->arg1 = p->arg2;
                 *changed = true;
-            } else if(p->code.arg2.kind == OP_CONST && p->code.arg2.u.value == 1)  {
-                p->code.kind = IR_ASSIGN;
+            } else if(p->arg2.kind == OP_CONST && constValue(ctx, p->arg2) == 1)  {
+                p->kind = IR_ASSIGN;
                 *changed = true;
-                /* p->code.arg1 = p->code.arg1; */
-            } else if((p->code.arg1.kind == OP_CONST && p->code.arg1.u.value == 0)
-                    || (p->code.arg2.kind == OP_CONST && p->code.arg2.u.value == 0)) {
-                p->code.kind = IR_ASSIGN;
-                p->code.arg1.kind = OP_CONST;
-                p->code.arg1.u.value = 0;
+                /* p->arg1 = p->arg1; */
+            } else if((p->arg1.kind == OP_CONST && constValue(ctx, p->arg1) == 0)
+                    || (p->arg2.kind == OP_CONST && constValue(ctx, p->arg2) == 0)) {
+                p->kind = IR_ASSIGN;
+                p->arg1 = constOperand(ctx, 0);
                 *changed = true;
             }
-        } else if(p->code.kind == IR_DIV) {
-            if(p->code.arg1.kind == OP_CONST && p->code.arg2.kind == OP_CONST) {
-                p->code.kind = IR_ASSIGN;
-                p->code.arg1.kind = OP_CONST;
-                int a = p->code.arg1.u.value;
-                int b = p->code.arg2.u.value;
-                p->code.arg1.u.value = a / b;
-                if(a % b) {
-                    p->code.arg1.u.value -= (double)a / b < 0;
-                }
-                /* p->code.arg1.u.value -= p->code.arg1.u.value <= 0;   // floor */
+        } else if(p->kind == IR_DIV) {
+            if(p->arg1.kind == OP_CONST && constValue(ctx, p->arg1) == 0) {
+                p->kind = IR_ASSIGN;
                 *changed = true;
-            } else if(p->code.arg1.kind == OP_CONST && p->code.arg1.u.value == 0) {
-                p->code.kind = IR_ASSIGN;
-                p->code.arg1.u.value = 0;
+            } else if(p->arg2.kind == OP_CONST && constValue(ctx, p->arg2) == 1) {
+                p->kind = IR_ASSIGN;
                 *changed = true;
-            } else if(p->code.arg2.kind == OP_CONST && p->code.arg2.u.value == 1) {
-                p->code.kind = IR_ASSIGN;
-                *changed = true;
-                /* p->code.arg1 = p->code.arg1; */
+                /* p->arg1 = p->arg1; */
             }
         }
-        p = p->next;
-    } while(p != codeList);
+    }
 }
 
-void assignElimit(bool *changed) {
-    DeadCode *deadList = NULL;
-    DeadCode *deadCode = NULL;
-    IRList *p = codeList;
-    /* p = codeList; */
-    do {
-        switch(p->code.kind) {
-            case IR_ASSIGN:
-            case IR_ADD:
-            case IR_SUB:
-            case IR_MUL:
-            case IR_DIV:
-            case IR_REF:
-            case IR_DEREF_R:
-            /* case IR_CALL: */
-                deadCode = (DeadCode*)malloc(sizeof(DeadCode));
-                deadCode->irList = p;
-                deadCode->next = deadList;
-                deadList = deadCode;
-                break;
-            default:
-                break;
-        }
-        p = p->next;
-    } while(p != codeList);
-
-    // check if is used
-    /* p = codeList; */
-    do {
-        switch(p->code.kind) {
-            // uniary operator
-            case IR_ASSIGN:
-            case IR_REF:
-            case IR_DEREF_R:
-            case IR_RET:
-            case IR_ARG:
-            case IR_WRITE:
-                deadList = updateDeadList(deadList, p->code.arg1);
-                break;
-            case IR_DEREF_L:
-                deadList = updateDeadList(deadList, p->code.result);
-                deadList = updateDeadList(deadList, p->code.arg1);
-                break;
-            case IR_ADD:
-            case IR_SUB:
-            case IR_MUL:
-            case IR_DIV:
-            case IR_RELOP:
-                deadList = updateDeadList(deadList, p->code.arg1);
-                deadList = updateDeadList(deadList, p->code.arg2);
-                break;
-            default:
-                break;
+// an assignment whose result is not live after it is removed. walking a
+// block backwards, the uses of a removed code don't keep anything alive
+void assignElimit(CompilerContext *ctx, IRFunc *func, bool *changed) {
+    Liveness *liveness = computeLiveness(func);
+    CFG *cfg = liveness->cfg;
+    BitVec *live = newBitVecs(1, liveness->varCnt);
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        BV_copy(live, liveness->out + b);
+        for(IR *p = func->codes + block->last - 1; p >= func->codes + block->first; p--) {
+            switch(p->kind) {
+                case IR_DEAD:
+                    continue;
+                case IR_ASSIGN:
+                case IR_ADD:
+                case IR_SUB:
+                case IR_MUL:
+                case IR_DIV:
+                case IR_REF:
+                case IR_DEREF_R: {
+                    int slot = liveSlot(liveness, p->result);
+                    if(slot >= 0 && !BV_test(live, slot)) {
+                        *changed = true;
+                        removeCode(func, p);
+                        continue;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            liveStep(liveness, p, live);
         }
-        p = p->next;
-    } while(p != codeList);
-
-    if(deadList) {
-        *changed = true;
     }
-    // delete all dead code
-    while(deadList) {
-        DeadCode *p = deadList;
-        deadList = deadList->next;
-        removeCode(p->irList);
-        free(p);
-    }
-
+    freeBitVecs(live);
+    freeLiveness(liveness);
 }
 
-IRList *lookback(IRList *list, IRList *p) {
-    assert(list && p);
-    IRList *res = NULL;
-    while(list != codeList) {
-        /* switch(list->code.kind) { */
-        /*     case IR_LABEL: */
-        /*     case IR_FUNC: */
-        /*         goto L1; */
-        /*         break; */
-        /*     case IR_ASSIGN: */
-        /*     case IR_REF: */
-        /*     case IR_DEREF_R: */
-        /*     case IR_CALL: */
-        /*         if(isOperandEqual(list->code.result, p->code.arg1) */ 
-        /*                 || isOperandEqual(list->code.result, p->code.arg2)) { */
-        /*             goto L1; */
-        /*         } */
-        /*         break; */
-        /*     case IR_ADD: */
-        /*     case IR_SUB: */
-        /*     case IR_MUL: */
-        /*     case IR_DIV: */
-        /*         if(isOperandEqual(list->code.result, p->code.arg1) */ 
-        /*                 || isOperandEqual(list->code.result, p->code.arg2)) { */
-        /*             goto L1; */
-        /*         } */
-        /*         if(!isOperandEqual(list->code.result, p->code.result)) { */
-        /*             if(list->code.kind == p->code.kind */
-        /*                     && isOperandEqual(list->code.arg1, p->code.arg1) */ 
-        /*                     && isOperandEqual(list->code.arg2, p->code.arg2)) { */
-        /*                 res = list; */
-        /*                 /1* break; *1/ */
-        /*                 goto L1; */
-        /*             } */
-        /*         } */
-        /*         break; */
-        /*     default: */
-        /*         break; */
-        /* } */
-        if(list->code.kind == IR_LABEL 
-                || list->code.kind == IR_FUNC) {
-            break;
-        }
-        if(isOperandEqual(list->code.result, p->code.arg1) 
-                || isOperandEqual(list->code.result, p->code.arg2)) {
-            break;
-        }
-        if(!isOperandEqual(list->code.result, p->code.result)) {
-            if(list->code.kind == p->code.kind
-                    && isOperandEqual(list->code.arg1, p->code.arg1) 
-                    && isOperandEqual(list->code.arg2, p->code.arg2)) {
-                res = list;
-                break;
+
+// a label nobody jumps to is dropped, so is a label right after another
+// one once its jumps are moved to the first. only the jumps are visited
+void labelElimit(CompilerContext *ctx, IRFunc *func, bool *changed) {
+    IR *label = NULL;   // last code is a label
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEAD) continue;
+        if(p->kind == IR_LABEL) {
+            LabelUse *use = labelUse(func, p->arg1.id);
+            if(label) {     // continued label
+                while(use->useCnt > 0) {
+                    retargetJump(func, func->codes + use->uses[use->useCnt - 1], label->arg1.id);
+                }
+                *changed = true;
+                removeCode(func, p);
+            } else if(use->useCnt == 0) {
+                *changed = true;
+                removeCode(func, p);
+            } else {
+                label = p;
             }
+        } else {
+            label = NULL;
         }
-        list = list->prev;
     }
-/* L1: return res; */
-    return res;
 }
 
-void labelElimit(bool *changed) {
-    IRList *p = codeList;
-    int state = 0;  // 0 means last code is not label, 1 means last code is a label
-    do {
-        if(p->code.kind == IR_LABEL) {
-            if(state == 0) {
-                state = 1;
-            } else {    // state = 1, continued label
-                int labelId = p->code.arg1.u.labelId;
-                IRList *pp = codeList;
-                do {
-                    if(pp->code.kind == IR_GOTO && pp->code.arg1.u.labelId == labelId) {
-                        pp->code.arg1.u.labelId = p->prev->code.arg1.u.labelId;
-                    } else if(pp->code.kind == IR_RELOP && pp->code.result.u.labelId == labelId) {
-                        pp->code.result.u.labelId = p->prev->code.arg1.u.labelId;
-                    }
-                    pp = pp->next;
-                } while(pp != codeList);
-                p = p->prev;
+// a jump to a label followed by GOTO L goes to L directly, a GOTO to the
+// very next code is dropped, and so is the code a jump or return skips
+// until the next label
+void jumpThread(CompilerContext *ctx, IRFunc *func, bool *changed) {
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_GOTO || p->kind == IR_RELOP) {
+            int target = jumpLabel(p);
+            // at most one step per label, a loop of GOTOs stops there
+            for(int steps = 0; steps < func->labelCnt; steps++) {
+                LabelUse *label = labelUse(func, target);
+                assert(label->def >= 0);
+                IR *next = nextCode(func, func->codes + label->def);
+                while(next && next->kind == IR_LABEL) {
+                    next = nextCode(func, next);
+                }
+                if(!next || next->kind != IR_GOTO || next->arg1.id == target) break;
+                target = next->arg1.id;
+            }
+            if(target != jumpLabel(p)) {
                 *changed = true;
-                removeCode(p->next);
+                retargetJump(func, p, target);
+            }
+        }
+        if(p->kind == IR_GOTO) {
+            IR *next = nextCode(func, p);
+            while(next && next->kind == IR_LABEL && next->arg1.id != p->arg1.id) {
+                next = nextCode(func, next);
+            }
+            if(next && next->kind == IR_LABEL) {    // falls through to it anyway
+                *changed = true;
+                removeCode(func, p);
+                continue;
+            }
+        }
+        if(p->kind == IR_GOTO || p->kind == IR_RET) {
+            for(IR *next = nextCode(func, p); next && next->kind != IR_LABEL; next = nextCode(func, next)) {
+                *changed = true;
+                removeCode(func, next);
             }
-        } else {
-            state = 0;
         }
-        p = p->next;
-    } while(p != codeList);
+    }
 }
-bool isModifyInstr(IRList *irList, Operand op) {
-    switch(irList->code.kind) {
+// the operand code assigns, NULL if it assigns none
+Operand* defOperand(IR *code) {
+    switch(code->kind) {
         case IR_ASSIGN:
-        case IR_DEREF_R:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
         case IR_REF:
-            return !isOperandEqual(irList->code.arg1, op);
+        case IR_DEREF_R:
+        case IR_CALL:
+        case IR_PHI:
+            return &code->result;
+        case IR_PARM:
+        case IR_READ:
+            return &code->arg1;
+        default:
+            return NULL;
+    }
+}
+
+// the operands code reads, constants included. &v reads no value of v,
+// *x := y reads x. the arguments of a PHI are kept aside, see ssa.h
+int useOperands(IR *code, Operand *uses[2]) {
+    switch(code->kind) {
+        case IR_ASSIGN:
+        case IR_DEREF_R:
+        case IR_RET:
+        case IR_ARG:
+        case IR_WRITE:
+            uses[0] = &code->arg1;
+            return 1;
         case IR_ADD:
         case IR_SUB:
         case IR_MUL:
         case IR_DIV:
-            return !isOperandEqual(irList->code.arg1, op)
-                && !isOperandEqual(irList->code.arg2, op);
+        case IR_RELOP:
+            uses[0] = &code->arg1;
+            uses[1] = &code->arg2;
+            return 2;
+        case IR_DEREF_L:
+            uses[0] = &code->result;
+            uses[1] = &code->arg1;
+            return 2;
         default:
-            return false;
+            return 0;
     }
 }
 
-void last_optimize() {
-    bool changed;
-    substitute();
-    /* assignSubs(&changed); */
-    assignElimit(&changed);
+// constant a op b for an ADD or a SUB, which always fold
+static Operand foldConst(CompilerContext *ctx, IRKind kind, Operand a, Operand b) {
+    int c = 0;
+    bool folded = foldArith(kind, constValue(ctx, a), constValue(ctx, b), &c);
+    assert(folded && (kind == IR_ADD || kind == IR_SUB));
+    return constOperand(ctx, c);
 }
 
-void substitute() {
-    IRList *p = codeList;
-    IRList *irList = NULL;
-    do {
-        switch(p->code.kind) {
-            case IR_ADD:
-            case IR_SUB:
-            case IR_MUL:
-            case IR_DIV:
-                irList = lookback(p->prev, p);
-                if(irList) {
-                    p->code.kind = IR_ASSIGN;
-                    p->code.arg1 = irList->code.result;
-                }
-                break;
-            default:
-                break;
-        }
-        p = p->next;
-    } while(p != codeList);
+// c = a op b as the target computes it: wrapping, division truncated.
+// false for a division by zero, which is left to run
+bool foldArith(IRKind kind, int a, int b, int *c) {
+    switch(kind) {
+        case IR_ADD:
+            *c = (int)((unsigned)a + (unsigned)b);
+            return true;
+        case IR_SUB:
+            *c = (int)((unsigned)a - (unsigned)b);
+            return true;
+        case IR_MUL:
+            *c = (int)((unsigned)a * (unsigned)b);
+            return true;
+        case IR_DIV:
+            if(b == 0) return false;
+            *c = b == -1 ? (int)(0u - (unsigned)a) : a / b;
+            return true;
+        default:
+            assert(0);
+            return false;
+    }
 }
 
-// check if p1 is before p2
-bool checkOrder(IRList *p1, IRList *p2, IRList *end) {
-    static int i = 0;
-    i++;
-    /* return !p1; */
-    if(!p1) return true;
-    while(true) {
-        /* printf("%d\n", i); */
-        if(p1 == end) {
+bool relopHolds(RELOP_t relop, int a, int b) {
+    switch(relop) {
+        case RELOP_EQ: return a == b;
+        case RELOP_LT: return a < b;
+        case RELOP_GT: return a > b;
+        case RELOP_LE: return a <= b;
+        case RELOP_GE: return a >= b;
+        case RELOP_NE: return a != b;
+    }
+    return false;
+}
+
+bool isModifyInstr(IR *code, Operand op) {
+    switch(code->kind) {
+        case IR_ASSIGN:
+        case IR_DEREF_R:
+        case IR_REF:
+            return !isOperandEqual(code->arg1, op);
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+            return !isOperandEqual(code->arg1, op)
+                && !isOperandEqual(code->arg2, op);
+        default:
             return false;
-        } else if(p2 == end) {
-            return true;
-        }
-        p1 = p1->next;
-        p2 = p2->next;
     }
 }
+
+
+
+// check if p1 is before p2: the codes of a function share one array, and
+// passes only rewrite or tombstone codes in place, so the index is the order
+bool checkOrder(IR *p1, IR *p2) {
+    return !p1 || p1 < p2;
+}
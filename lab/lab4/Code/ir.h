@@ -7,8 +7,9 @@
 typedef struct Operand Operand;
 typedef struct IR IR;   // intermediate code
 typedef struct ArgNode ArgNode;
-typedef struct IRList IRList;   // intermediate code list
-typedef struct DeadCode DeadCode;   // for optimization
+typedef struct IRFunc IRFunc;   // intermediate code of a function
+typedef struct OptStats OptStats;
+typedef struct LabelUse LabelUse;
 
 typedef enum { 
     OP_TEMP, 
@@ -37,7 +38,9 @@ typedef enum {
     IR_CALL, 
     IR_PARM, 
     IR_READ, 
-    IR_WRITE 
+    IR_WRITE,
+    IR_PHI,     // result := phi(args), only in SSA form, see ssa.h
+    IR_DEAD     // removed code, skipped by every pass
 } IRKind;
 typedef enum {
     RELOP_EQ,   // == 
@@ -48,42 +51,92 @@ typedef enum {
     RELOP_NE    // !=
 } RELOP_t;
 
+// 4 bytes: constants and symbols live in ctx->operands, an operand only
+// keeps their index, so operands compare and hash as plain integers
 struct Operand {
-    OperandKind kind;
-    union {
-        int tmpId;  // for temporary variable
-        int labelId;    // for label
-        int value;  // for constant
-        Symbol *symbol; // for funcion & variable
-    } u;
+    unsigned kind : 3;  // OperandKind
+    unsigned id : 29;   // temp or label id, constant or symbol index
 };
+#define OPERAND_ID_MAX ((1u << 29) - 1)
+// 16 bytes, four codes per cache line
 struct IR {
-    IRKind kind;
+    unsigned char kind;     // IRKind
+    unsigned char relop;    // RELOP_t, for relop
     Operand result;
     Operand arg1;
     Operand arg2;
-    union {
-        RELOP_t relop;    // for relop
-        int size;   // for dec operator
-    } u;
 };
-struct IRList {
-    IR code;
-    IRList *prev;
-    IRList *next;
+// codes are stored in one array per function, codes[0] is the FUNCTION.
+// removed code stays as IR_DEAD until the array is compacted, so a pass
+// may keep pointers into codes while it runs
+struct IRFunc {
+    IR *codes;
+    int cnt;    // used slots, dead ones included
+    int cap;
+    int dead;   // number of IR_DEAD slots
+    struct CFG *cfg;    // NULL until a pass asks for it, see cfg.h
+    LabelUse *labels;   // label labelBase + i, kept up to date by every edit
+    int labelBase;
+    int labelCnt;
+    IRFunc *next;
+};
+// where a label is and which jumps go to it, as code indices
+struct LabelUse {
+    int def;    // the LABEL, -1 once removed
+    int *uses;  // GOTO and RELOP codes, in no order
+    int useCnt;
+    int useCap;
+};
+#define OPT_PASS_NUM 5
+#define OPT_MAX_ROUNDS 64   // rounds of the passes over one function
+#define INLINE_SMALL 24     // codes of a callee inlined at every call
+#define INLINE_ONCE 400     // codes of a callee inlined at its only call
+#define INLINE_GROWTH 4000  // codes a caller may grow to by inlining
+// work of the optimizer over one compilation
+struct OptStats {
+    int funcs;
+    int rounds;
+    int maxRounds;  // most rounds of one function
+    int passRuns;
+    int passSkips;  // passes with nothing to do, not run
+    int budgetHits; // functions stopped by OPT_MAX_ROUNDS
+    int constUses;  // uses replaced by a constant in SSA form
+    int constDefs;  // codes removed because their value is constant
+    int branches;   // RELOPs whose outcome is known
+    int deadBlocks; // blocks never reached
+    int redundant;  // codes computing a value a dominating code computed
+    int hoisted;    // loop-invariant codes moved out of their loops
+    int reduced;    // multiplies by an induction variable turned into adds
+    int inlined;    // calls replaced by the body of the callee
+    int funcsRemoved;   // functions whose every call was inlined
+    int tailRecursions; // self calls turned into jumps
+    int tailCalls;  // calls which reuse the frame of the caller, see oc.c
 };
 struct ArgNode {
     int tmpId;
     ArgNode *next;
 };
 
-struct DeadCode {
-    IRList *irList;
-    DeadCode *next;
-};
-
-void generate_ir(Node *root, const char* filename); // save ir code to file or print to screen
-IRList* getCodeList();
-void clearIRList();
+void generate_ir(CompilerContext *ctx, Node *root, FILE *stream); // print ir code to stream if any
+IRFunc* getFuncList(CompilerContext *ctx);
+void clearFuncList(CompilerContext *ctx);
+void freeFunc(IRFunc *func);
+void printOptStats(CompilerContext *ctx, FILE *stream);
 bool isOperandEqual(Operand op1, Operand op2);
+Operand* defOperand(IR *code);
+int useOperands(IR *code, Operand *uses[2]);
+bool foldArith(IRKind kind, int a, int b, int *c);
+bool relopHolds(RELOP_t relop, int a, int b);
+void removeCode(IRFunc *func, IR *code);
+void resolveRelop(IRFunc *func, IR *code, bool taken);
+void setCodes(IRFunc *func, IR *codes, int cnt, int cap);
+void relabelCodes(CompilerContext *ctx, IRFunc *func, IR *codes, int cnt, int cap);
+void inlineCalls(CompilerContext *ctx);
+void eliminateTailRecursion(CompilerContext *ctx, IRFunc *func);
+Operand tempOperand(CompilerContext *ctx);
+Operand labelOperand(CompilerContext *ctx);
+Operand constOperand(CompilerContext *ctx, int value);
+Operand symbolOperand(CompilerContext *ctx, OperandKind kind, Symbol *sym);   // OP_VAR or OP_FUNC
+int constValue(CompilerContext *ctx, Operand op);
+Symbol* operandSymbol(CompilerContext *ctx, Operand op);
 #endif
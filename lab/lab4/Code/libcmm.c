@@ -0,0 +1,49 @@
+#define _DEFAULT_SOURCE
+#include "libcmm.h"
+#include "context.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int cmm_compile(const char *src, size_t len, const CmmOptions *options, CmmResult *result) {
+    if(!result) {
+        return -1;
+    }
+    memset(result, 0, sizeof(CmmResult));
+    CompilerContext *ctx = newContext();
+    const char *filename = options && options->filename ? options->filename : "<memory>";
+    strncpy(ctx->filename, filename, sizeof(ctx->filename)-1);
+    ctx->errStream = NULL;
+    ctx->emitIR = options && options->target == CMM_IR;
+    ctx->src = newSource(src, len);
+    // the code is written to a growing buffer instead of a file
+    char *buf = NULL;
+    size_t size = 0;
+    ctx->out = open_memstream(&buf, &size);
+    int errors = compileSource(ctx);
+    fclose(ctx->out);
+    if(errors == 0) {
+        result->output = buf;
+        result->outputLen = size;
+    } else {
+        free(buf);
+    }
+    // the diagnostics are handed over to the caller
+    result->diags = ctx->diags;
+    result->diagCnt = ctx->diagCnt;
+    ctx->diags = NULL;
+    ctx->diagCnt = ctx->diagCap = 0;
+    closeSource(ctx->src);
+    freeContext(ctx);
+    return errors;
+}
+
+void cmm_free_result(CmmResult *result) {
+    if(!result) return;
+    for(int i = 0; i < result->diagCnt; i++) {
+        free(result->diags[i].message);
+    }
+    free(result->diags);
+    free(result->output);
+    memset(result, 0, sizeof(CmmResult));
+}
@@ -0,0 +1,51 @@
+#ifndef __LIBCMM_H__
+#define __LIBCMM_H__
+
+#include <stddef.h>
+
+// in-memory C-- compiler: no file is read or written and nothing is
+// printed, every call is independent and may run on its own thread
+
+typedef enum CmmTarget {
+    CMM_ASM,    // MIPS32 assembly
+    CMM_IR      // intermediate code
+} CmmTarget;
+
+typedef enum CmmDiagKind {
+    CMM_LEXICAL,    // error type A
+    CMM_SYNTAX,     // error type B
+    CMM_SEMANTIC,   // error type 1 to 17, see errType
+    CMM_TRANSLATE   // the program can't be translated
+} CmmDiagKind;
+
+typedef struct CmmOptions CmmOptions;
+typedef struct CmmDiagnostic CmmDiagnostic;
+typedef struct CmmResult CmmResult;
+
+struct CmmOptions {
+    CmmTarget target;
+    const char *filename;   // name of the source in diagnostics, may be NULL
+};
+
+struct CmmDiagnostic {
+    CmmDiagKind kind;
+    int errType;    // semantic error type, 0 for the other kinds
+    int line;
+    int column;     // 0 if unknown
+    char *message;  // e.g. Undefined variable "x"
+};
+
+// owned by the caller, release it with cmm_free_result
+struct CmmResult {
+    char *output;   // '\0' terminated assembly or IR, NULL if there are errors
+    size_t outputLen;
+    CmmDiagnostic *diags;
+    int diagCnt;
+};
+
+// compile len bytes of src (need not be '\0' terminated). options may be NULL
+// for assembly. returns the number of errors, 0 on success, -1 if result is NULL
+int cmm_compile(const char *src, size_t len, const CmmOptions *options, CmmResult *result);
+void cmm_free_result(CmmResult *result);
+
+#endif
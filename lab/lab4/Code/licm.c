@@ -0,0 +1,53 @@
+#include "ssa.h"
+#include "context.h"
+
+static bool isHoistable(CompilerContext *ctx, SSA *ssa, Loop *loop, IR *code);
+
+// loop-invariant code motion: a pure code of a loop whose operands are
+// defined out of it moves to the top of the header, which runs once on the
+// way in. loops go outermost first, so a code leaves as many loops as it
+// can at once, and blocks in reverse postorder, so a code follows the
+// invariants it reads out. in SSA form a moved code keeps its one name, and
+// a code moved out of a block which does not always run computes a value
+// nothing reads
+void LICM(CompilerContext *ctx, SSA *ssa) {
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    for(int l = 0; l < cfg->loopCnt; l++) {
+        Loop *loop = cfg->loops + l;
+        if(loopEntry(ssa, loop) < 0) continue;
+        for(int i = 0; i < cfg->orderCnt; i++) {
+            int b = cfg->order[i];
+            if(!CFG_inLoop(cfg, b, loop)) continue;
+            BasicBlock *block = cfg->blocks + b;
+            for(int k = block->first; k < block->last; k++) {
+                IR *p = func->codes + k;
+                if(p->kind == IR_DEAD || !isHoistable(ctx, ssa, loop, p)) continue;
+                insertCode(ssa, loop->header, false, p);
+                removeCode(func, p);
+                ctx->optStats.hoisted++;
+            }
+        }
+    }
+}
+
+// a division may trap, so only one by a constant other than zero moves
+static bool isHoistable(CompilerContext *ctx, SSA *ssa, Loop *loop, IR *code) {
+    Operand *def = defOperand(code);
+    if(!def || !isSSAName(ssa, *def)) return false;
+    switch(code->kind) {
+        case IR_REF:
+            return true;
+        case IR_ASSIGN:
+            return isInvariant(ssa, loop, code->arg1);
+        case IR_DIV:
+            if(code->arg2.kind != OP_CONST || constValue(ctx, code->arg2) == 0) return false;
+            // fall through
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+            return isInvariant(ssa, loop, code->arg1) && isInvariant(ssa, loop, code->arg2);
+        default:
+            return false;
+    }
+}
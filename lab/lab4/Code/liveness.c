@@ -0,0 +1,155 @@
+#include "liveness.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void numberVars(Liveness *self, IRFunc *func);
+static void rangeOf(Operand op, int *tmpMin, int *tmpMax, int *symMin, int *symMax);
+static void untrack(Liveness *self, Operand op);
+
+// backward may-analysis: gen is the uses before any def in the block,
+// kill the defs
+Liveness* computeLiveness(IRFunc *func) {
+    Liveness *self = (Liveness*)malloc(sizeof(Liveness));
+    memset(self, 0, sizeof(Liveness));
+    CFG *cfg = getCFG(func);
+    self->cfg = cfg;
+    numberVars(self, func);
+    Dataflow *df = newDataflow(cfg, DF_BACKWARD, DF_UNION, self->varCnt);
+    Operand *uses[2], *result;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        for(int i = block->last - 1; i >= block->first; i--) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            if((result = defOperand(p))) {
+                int slot = liveSlot(self, *result);
+                if(slot >= 0) {
+                    BV_set(df->kill + b, slot);
+                    BV_reset(df->gen + b, slot);
+                }
+            }
+            int cnt = useOperands(p, uses);
+            for(int k = 0; k < cnt; k++) {
+                int slot = liveSlot(self, *uses[k]);
+                if(slot >= 0) {
+                    BV_set(df->gen + b, slot);
+                }
+            }
+        }
+    }
+    DF_solve(df, NULL);
+    self->df = df;
+    self->in = df->in;
+    self->out = df->out;
+    return self;
+}
+
+void freeLiveness(Liveness *self) {
+    if(!self) return;
+    free(self->tmpSlot);
+    free(self->symSlot);
+    freeDataflow(self->df);
+    free(self);
+}
+
+int liveSlot(Liveness *self, Operand op) {
+    int i;
+    if(op.kind == OP_TEMP) {
+        i = (int)op.id - self->tmpBase;
+        return i >= 0 && i < self->tmpCnt ? self->tmpSlot[i] : -1;
+    } else if(op.kind == OP_VAR) {
+        i = (int)op.id - self->symBase;
+        return i >= 0 && i < self->symCnt ? self->symSlot[i] : -1;
+    }
+    return -1;
+}
+
+void liveStep(Liveness *self, IR *code, BitVec *live) {
+    Operand *uses[2], *result;
+    if((result = defOperand(code))) {
+        int slot = liveSlot(self, *result);
+        if(slot >= 0) {
+            BV_reset(live, slot);
+        }
+    }
+    int cnt = useOperands(code, uses);
+    for(int k = 0; k < cnt; k++) {
+        int slot = liveSlot(self, *uses[k]);
+        if(slot >= 0) {
+            BV_set(live, slot);
+        }
+    }
+}
+
+static void rangeOf(Operand op, int *tmpMin, int *tmpMax, int *symMin, int *symMax) {
+    int id = op.id;
+    if(op.kind == OP_TEMP) {
+        if(id < *tmpMin) *tmpMin = id;
+        if(id > *tmpMax) *tmpMax = id;
+    } else if(op.kind == OP_VAR) {
+        if(id < *symMin) *symMin = id;
+        if(id > *symMax) *symMax = id;
+    }
+}
+
+static void untrack(Liveness *self, Operand op) {
+    if(op.kind == OP_TEMP) {
+        self->tmpSlot[op.id - self->tmpBase] = -1;
+    } else if(op.kind == OP_VAR) {
+        self->symSlot[op.id - self->symBase] = -1;
+    }
+}
+
+// temps and variables of a function have ids close together, so slots are
+// found through two small arrays over the ranges of ids
+static void numberVars(Liveness *self, IRFunc *func) {
+    int tmpMin = OPERAND_ID_MAX, tmpMax = -1, symMin = OPERAND_ID_MAX, symMax = -1;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEAD) continue;
+        rangeOf(p->result, &tmpMin, &tmpMax, &symMin, &symMax);
+        rangeOf(p->arg1, &tmpMin, &tmpMax, &symMin, &symMax);
+        rangeOf(p->arg2, &tmpMin, &tmpMax, &symMin, &symMax);
+    }
+    self->tmpBase = tmpMin;
+    self->tmpCnt = tmpMax >= tmpMin ? tmpMax - tmpMin + 1 : 0;
+    self->symBase = symMin;
+    self->symCnt = symMax >= symMin ? symMax - symMin + 1 : 0;
+    self->tmpSlot = (int*)malloc(sizeof(int) * (self->tmpCnt > 0 ? self->tmpCnt : 1));
+    self->symSlot = (int*)malloc(sizeof(int) * (self->symCnt > 0 ? self->symCnt : 1));
+    for(int i = 0; i < self->tmpCnt; i++) {
+        self->tmpSlot[i] = 0;
+    }
+    for(int i = 0; i < self->symCnt; i++) {
+        self->symSlot[i] = 0;
+    }
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEC) {
+            untrack(self, p->result);
+        } else if(p->kind == IR_REF) {
+            untrack(self, p->arg1);
+        }
+    }
+    // every operand seen above is in range, untracked ones stay -1
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEAD) continue;
+        Operand ops[3] = { p->result, p->arg1, p->arg2 };
+        for(int k = 0; k < 3; k++) {
+            int *slot = NULL;
+            if(ops[k].kind == OP_TEMP) {
+                slot = self->tmpSlot + (ops[k].id - self->tmpBase);
+            } else if(ops[k].kind == OP_VAR) {
+                slot = self->symSlot + (ops[k].id - self->symBase);
+            }
+            if(slot && *slot == 0) {
+                *slot = ++self->varCnt;     // 0 is unseen, numbered from 1 for now
+            }
+        }
+    }
+    for(int i = 0; i < self->tmpCnt; i++) {
+        self->tmpSlot[i] = self->tmpSlot[i] > 0 ? self->tmpSlot[i] - 1 : -1;
+    }
+    for(int i = 0; i < self->symCnt; i++) {
+        self->symSlot[i] = self->symSlot[i] > 0 ? self->symSlot[i] - 1 : -1;
+    }
+}
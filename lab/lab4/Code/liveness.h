@@ -0,0 +1,31 @@
+#ifndef __LIVENESS_H__
+#define __LIVENESS_H__
+
+#include "ir.h"
+#include "cfg.h"
+#include "dataflow.h"
+
+typedef struct Liveness Liveness;
+
+// live temps and variables at the bounds of each block. a variable whose
+// address is taken (DEC, &v) lives in memory and is not tracked
+struct Liveness {
+    CFG *cfg;
+    int varCnt;     // tracked operands, numbered from 0
+    int *tmpSlot;   // slot of temp tmpBase + i, -1 if not tracked
+    int tmpBase;
+    int tmpCnt;
+    int *symSlot;   // slot of the variable with symbol index symBase + i
+    int symBase;
+    int symCnt;
+    Dataflow *df;
+    BitVec *in;     // of df, one per block
+    BitVec *out;
+};
+
+Liveness* computeLiveness(IRFunc *func);
+void freeLiveness(Liveness *self);
+int liveSlot(Liveness *self, Operand op);   // -1 if op is not tracked
+void liveStep(Liveness *self, IR *code, BitVec *live);  // live after code to live before it
+
+#endif
@@ -1,103 +1,68 @@
-#include <stdarg.h>
+#define _DEFAULT_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <stdbool.h>
-#include "Node.h"
-#include "syntax.tab.h"
-#include "semantic.h"
-#include "ir.h"
-#include "oc.h"
+#include <unistd.h>
+#include "context.h"
+#include "batch.h"
 
 #ifdef YYDEBUG
 int yydebug = 1;
 #endif
 
-extern void yyrestart(FILE*);
-extern int yyparse();
-extern int yylineno;
+static int usage(const char *prog);
+static int batchMain(int argc, char **argv);
 
-Node* root = NULL;
-int errnum = 0;
-int lexerr = 0;
-int semerr = 0;
-int lastline = -1;
-bool output = false;
-char linebuf[4096];
-char filename[128];
-YYLTYPE errloc;
-void synerror(const char*);
-void lexerror(int, const char*, const char*);
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-s] src dst\n", prog);
+    fprintf(stderr, "       %s -b list [-j threads] [-o outdir]\n", prog);
+    fprintf(stderr, "       list: directory of .cmm files, or manifest of \"src [dst]\" lines\n");
+    fprintf(stderr, "       -s: print optimizer statistics to stderr\n");
+    return 1;
+}
 
-int main(int argc, char**argv) {
-    if(argc < 3) {
-        fprintf(stderr, "Usage: %s src dst\n", argv[0]);
-        return 1;
+// compile many files in one process
+static int batchMain(int argc, char **argv) {
+    const char *list = NULL, *outdir = NULL;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            list = argv[++i];
+        } else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outdir = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
     }
-    FILE* f = fopen(argv[1], "r");
-    if(!f) {
-        perror(argv[1]);
-        return 1;
+    if(!list) {
+        return usage(argv[0]);
     }
-    strncpy(filename, argv[1], strlen(argv[1])+1);
-    fgets(linebuf, sizeof(linebuf), f);
-    linebuf[strlen(linebuf)-1] = '\0';
-    fseek(f, 0L, SEEK_SET);
-    yyrestart(f);
-    yyparse();
-    // no lexical error and no syntax error
-    if(errnum == 0 && !lexerr) {
-        semantic_parse(root);
-#ifdef __LAB3__
-        if(!semerr) {
-            generate_ir(root, argv[2]);
-        }
-#ifdef __LAB4__
-        generate_oc(getCodeList(), argv[2]);
-#endif
-#endif
-        /* printf("syntax analyze succeed.\n"); */
-        /* traverseTree(root, 0); */
-    } else if(!output && errnum > 0){ /* synchronized token not found */
-        fprintf(stderr, "\033[31mError type B at line %d: Syntax error.\n\033[0m", 
-                errloc.first_line);
+    int cnt = 0;
+    BatchJob *jobs = loadBatch(list, outdir, &cnt);
+    if(cnt < 0) {
+        return 1;
     }
-    freeTree(root);
-    fclose(f);
+    int failed = runBatch(jobs, cnt, threads);
+    freeBatch(jobs, cnt);
+    return failed ? 1 : 0;
 }
-void synerror(const char* msg) {
-    output = true;
-    /* errnum++; */
-    if(errloc.first_line != lastline){
-        if(errloc.first_line == yylineno) {
-            fprintf(stderr, "\033[31mError type B at line %d: %s.\t\033[33m[%s:%d:%d: %s]\n\033[0m", 
-                    errloc.first_line, msg, filename, errloc.first_line, errloc.first_column, linebuf);
-        } else {
-            fprintf(stderr, "\033[31mError type B at line %d: %s.\n\033[0m", 
-                    errloc.first_line, msg);
-        }
-        /* lastline = yylineno; */
-        lastline = errloc.first_line;
+
+int main(int argc, char**argv) {
+    bool stats = argc > 1 && strcmp(argv[1], "-s") == 0;
+    int i = stats ? 2 : 1;
+    if(!stats && argc > 1 && argv[1][0] == '-') {
+        return batchMain(argc, argv);
     }
-}
-void lexerror(int lineno, const char* desc, const char* text) {
-    lexerr = 1;
-    /* errnum++; */
-    if(text != NULL) {
-        fprintf(stderr, "\033[31mError type A at line %d: %s \"%s\".\t\033[33m[%s:%d:%d: %s]\n\033[0m", 
-                lineno, desc, text, filename, yylineno, yylloc.first_column, linebuf);
-    } else {
-        fprintf(stderr, "\033[31mError type A at line %d: %s.\t\033[33m[%s:%d:%d: %s]\n\033[0m", 
-                lineno, desc, filename, yylineno, yylloc.first_column, linebuf);
+    if(argc < i + 2) {
+        return usage(argv[0]);
     }
-    lastline = yylineno;
-}
-void Log(const char* format, ...) {
-#ifdef DEBUG
-    printf("\033[33mdebug mode> ");
-    va_list ap;
-    va_start(ap, format);
-    vprintf(format, ap);
-    va_end(ap);
-    printf("\033[0m");
-#endif
+    CompilerContext *ctx = newContext();
+    int err = compileFile(ctx, argv[i], argv[i + 1]);
+    if(stats) {
+        printOptStats(ctx, stderr);
+    }
+    freeContext(ctx);
+    return err < 0 ? 1 : 0;
 }
@@ -1,411 +1,558 @@
 #include "oc.h"
+#include "context.h"
+#include "regalloc.h"
 #include <stdarg.h>
 #include <assert.h>
-#define REG_NUM 10
-
-static Reg regs[REG_NUM];
-static FILE* stream = NULL;
-static LVList* lvList = NULL;   // local variable list
-static IRList* codeList = NULL;
-static int param_off = 0;
-static int lv_off = 0;
-
-void init_regs();
-
-void gen_data_seg();
-void gen_globl_seg();
-void gen_text_seg();
-
-void gen_read_func();
-void gen_write_func();
-
-Reg* get_reg(Operand op);
-Reg* alloc_reg(Operand op);
-void spill_reg(Reg *reg);
-void spill_all_reg();
-void free_reg(Reg *reg);
-void free_all_reg();
-
-LocalVar* get_local_var(Operand op);
-LocalVar* add_local_var(Operand op, int size);
-void add_param_var(Operand op);
-void clear_lvList();
-
-void enter_func();
-void gen_prologue();
-void gen_epilogue();
-
-void generate_oc(IRList *irList, const char *filename) {
-    stream = fopen(filename, "w");
-    if(!stream) {
-        perror("fopen");
-        return;
-    }
-    codeList = irList;
-    /* init_regs(); */
-    gen_data_seg();
-    gen_globl_seg();
-    gen_text_seg();
-    fclose(stream);
-    clearIRList();
-    clearSymbolTable();
+
+#define SCRATCH_0 "$t8"     // operands without a register are loaded into
+#define SCRATCH_1 "$t9"     // the scratch registers, which no one keeps
+
+static const char *reg_names[REG_NUM] = {
+    "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7"
+};
+static const char *arg_names[ARG_REG_NUM] = { "$a0", "$a1", "$a2", "$a3" };
+
+void gen_data_seg(CompilerContext *ctx);
+void gen_globl_seg(CompilerContext *ctx);
+void gen_text_seg(CompilerContext *ctx, IRFunc *funcList);
+void gen_func(CompilerContext *ctx, IRFunc *func);
+int max_tail_args(IRFunc *func);
+int tail_call_args(IRFunc *func, IR *call, int max_args);
+void gen_tail_call(CompilerContext *ctx, IR *call, int arg_cnt);
+void gen_call(CompilerContext *ctx, IR *call);
+void gen_param(CompilerContext *ctx, Operand op, int index);
+
+void gen_read_func(CompilerContext *ctx);
+void gen_write_func(CompilerContext *ctx);
+
+const char* op_reg(CompilerContext *ctx, Operand op, int *off);
+int home_of(CompilerContext *ctx, Interval *it);
+const char* src_reg(CompilerContext *ctx, Operand op, const char *scratch);
+const char* dst_reg(CompilerContext *ctx, Operand op, const char *scratch);
+void store_dst(CompilerContext *ctx, Operand op, const char *reg);
+void save_regs(CompilerContext *ctx, bool restore);
+
+LocalVar* get_local_var(CompilerContext *ctx, Operand op);
+LocalVar* add_local_var(CompilerContext *ctx, Operand op, int size);
+void add_param_var(CompilerContext *ctx, Operand op);
+void clear_lvList(CompilerContext *ctx);
+void alloc_frame(CompilerContext *ctx, IRFunc *func);
+void save_callee_regs(CompilerContext *ctx, bool restore);
+
+void enter_func(CompilerContext *ctx, IRFunc *func, int max_args);
+void leave_func(CompilerContext *ctx);
+void gen_prologue(CompilerContext *ctx);
+void gen_epilogue(CompilerContext *ctx);
+
+void generate_oc(CompilerContext *ctx, IRFunc *funcList, FILE *stream) {
+    ctx->ocStream = stream;
+    gen_data_seg(ctx);
+    gen_globl_seg(ctx);
+    gen_text_seg(ctx, funcList);
+    clear_lvList(ctx);
+}
+
+void gen_data_seg(CompilerContext *ctx) {
+    fprintf(ctx->ocStream, ".data\n");
+    fprintf(ctx->ocStream, "_prompt: .asciiz \"Enter an integer:\"\n");
+    fprintf(ctx->ocStream, "_ret: .asciiz \"\\n\"\n");
 }
 
-void gen_data_seg() {
-    fprintf(stream, ".data\n");
-    fprintf(stream, "_prompt: .asciiz \"Enter an integer:\"\n");
-    fprintf(stream, "_ret: .asciiz \"\\n\"\n");
+void gen_globl_seg(CompilerContext *ctx) {
+    fprintf(ctx->ocStream, ".globl main\n");
 }
 
-void gen_globl_seg() {
-    fprintf(stream, ".globl main\n");
+void gen_read_func(CompilerContext *ctx) {
+    fprintf(ctx->ocStream, "\n");
+    fprintf(ctx->ocStream, "read:\n");
+    fprintf(ctx->ocStream, "  li $v0, 4\n");
+    fprintf(ctx->ocStream, "  la $a0, _prompt\n");
+    fprintf(ctx->ocStream, "  syscall\n");
+    fprintf(ctx->ocStream, "  li $v0, 5\n");
+    fprintf(ctx->ocStream, "  syscall\n");
+    fprintf(ctx->ocStream, "  jr $ra\n");
 }
 
-void gen_read_func() {
-    fprintf(stream, "\n");
-    fprintf(stream, "read:\n");
-    fprintf(stream, "  li $v0, 4\n");
-    fprintf(stream, "  la $a0, _prompt\n");
-    fprintf(stream, "  syscall\n");
-    fprintf(stream, "  li $v0, 5\n");
-    fprintf(stream, "  syscall\n");
-    fprintf(stream, "  jr $ra\n");
+void gen_write_func(CompilerContext *ctx) {
+    fprintf(ctx->ocStream, "\n");
+    fprintf(ctx->ocStream, "write:\n");
+    fprintf(ctx->ocStream, "  li $v0, 1\n");
+    fprintf(ctx->ocStream, "  syscall\n");
+    fprintf(ctx->ocStream, "  li $v0, 4\n");
+    fprintf(ctx->ocStream, "  la $a0, _ret\n");
+    fprintf(ctx->ocStream, "  syscall\n");
+    fprintf(ctx->ocStream, "  move $v0, $0\n");
+    fprintf(ctx->ocStream, "  jr $ra\n");
 }
 
-void gen_write_func() {
-    fprintf(stream, "\n");
-    fprintf(stream, "write:\n");
-    fprintf(stream, "  li $v0, 1\n");
-    fprintf(stream, "  syscall\n");
-    fprintf(stream, "  li $v0, 4\n");
-    fprintf(stream, "  la $a0, _ret\n");
-    fprintf(stream, "  syscall\n");
-    fprintf(stream, "  move $v0, $0\n");
-    fprintf(stream, "  jr $ra\n");
+void gen_text_seg(CompilerContext *ctx, IRFunc *funcList) {
+    fprintf(ctx->ocStream, ".text\n");
+    gen_read_func(ctx);
+    gen_write_func(ctx);
+    for(IRFunc *func = funcList; func; func = func->next) {
+        gen_func(ctx, func);
+    }
 }
 
-void gen_text_seg() {
-    init_regs();
-    fprintf(stream, ".text\n");
-    gen_read_func();
-    gen_write_func();
-    IRList *p = codeList;
-    LocalVar *p1 = NULL;
-    Reg *x = NULL;
-    Reg *y = NULL;
-    Reg *z = NULL;
-    do {
-        switch(p->code.kind) {
+void gen_func(CompilerContext *ctx, IRFunc *func) {
+    const char *x = NULL;
+    const char *y = NULL;
+    const char *z = NULL;
+    int max_args = max_tail_args(func);
+    int arg_cnt = 0;
+    int param_cnt = 0;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        switch(p->kind) {
             case IR_FUNC:
-                /* spill_all_reg(); */
-                /* clear_lvList(); */
-                enter_func();
-                fprintf(stream, "\n");
-                fprintf(stream, "%s:\n", p->code.arg1.u.symbol->name);
-                gen_prologue();
+                enter_func(ctx, func, max_args);
+                fprintf(ctx->ocStream, "\n");
+                fprintf(ctx->ocStream, "%s:\n", operandSymbol(ctx, p->arg1)->name);
+                gen_prologue(ctx);
+                alloc_frame(ctx, func);
                 break;
             case IR_LABEL:
-                spill_all_reg();
-                fprintf(stream, "label_%d:\n", p->code.arg1.u.labelId);
+                fprintf(ctx->ocStream, "label_%d:\n", p->arg1.id);
                 break;
             case IR_ASSIGN: // x = y
-                if(p->code.arg1.kind == OP_CONST) {
-                    x = alloc_reg(p->code.result);
-                    x->modified = true;
-                    fprintf(stream, "  li %s, %d\n", x->name, p->code.arg1.u.value);
+                if(p->arg1.kind == OP_CONST) {
+                    x = dst_reg(ctx, p->result, SCRATCH_0);
+                    fprintf(ctx->ocStream, "  li %s, %d\n", x, constValue(ctx, p->arg1));
                 } else {
-                    y = get_reg(p->code.arg1);
-                    x = alloc_reg(p->code.result);
-                    x->modified = true;
-                    fprintf(stream, "  move %s, %s\n", x->name, y->name);
+                    y = src_reg(ctx, p->arg1, SCRATCH_0);
+                    x = dst_reg(ctx, p->result, y);
+                    if(x != y) {
+                        fprintf(ctx->ocStream, "  move %s, %s\n", x, y);
+                    }
                 }
+                store_dst(ctx, p->result, x);
                 break;
             case IR_ADD:    // z = x + y
-                if(p->code.arg1.kind == OP_CONST) {
-                    y = get_reg(p->code.arg2);
-                    z = alloc_reg(p->code.result);
-                    z->modified = true;
-                    fprintf(stream, "  addi %s, %s, %d\n", z->name, y->name, p->code.arg1.u.value);
+                if(p->arg1.kind == OP_CONST && constValue(ctx, p->arg1) >= -32768 && constValue(ctx, p->arg1) <= 32767) {
+                    y = src_reg(ctx, p->arg2, SCRATCH_0);
+                    z = dst_reg(ctx, p->result, SCRATCH_0);
+                    fprintf(ctx->ocStream, "  addi %s, %s, %d\n", z, y, constValue(ctx, p->arg1));
                 } else {
-                    x = get_reg(p->code.arg1);
-                    x->locked = true;
-                    y = get_reg(p->code.arg2);
-                    x->locked =false;
-                    z = alloc_reg(p->code.result);
-                    z->modified = true;
-                    fprintf(stream, "  add %s, %s, %s\n", z->name, x->name, y->name);
+                    x = src_reg(ctx, p->arg1, SCRATCH_0);
+                    y = src_reg(ctx, p->arg2, SCRATCH_1);
+                    z = dst_reg(ctx, p->result, SCRATCH_0);
+                    fprintf(ctx->ocStream, "  add %s, %s, %s\n", z, x, y);
                 }
+                store_dst(ctx, p->result, z);
                 break;
             case IR_SUB:
-                x = get_reg(p->code.arg1);
-                x->locked = true;
-                y = get_reg(p->code.arg2);
-                x->locked =false;
-                z = alloc_reg(p->code.result);
-                z->modified = true;
-                fprintf(stream, "  sub %s, %s, %s\n", z->name, x->name, y->name);
+                x = src_reg(ctx, p->arg1, SCRATCH_0);
+                y = src_reg(ctx, p->arg2, SCRATCH_1);
+                z = dst_reg(ctx, p->result, SCRATCH_0);
+                fprintf(ctx->ocStream, "  sub %s, %s, %s\n", z, x, y);
+                store_dst(ctx, p->result, z);
                 break;
             case IR_MUL:
-                x = get_reg(p->code.arg1);
-                x->locked = true;
-                y = get_reg(p->code.arg2);
-                x->locked =false;
-                z = alloc_reg(p->code.result);
-                z->modified = true;
-                fprintf(stream, "  mul %s, %s, %s\n", z->name, x->name, y->name);
+                x = src_reg(ctx, p->arg1, SCRATCH_0);
+                y = src_reg(ctx, p->arg2, SCRATCH_1);
+                z = dst_reg(ctx, p->result, SCRATCH_0);
+                fprintf(ctx->ocStream, "  mul %s, %s, %s\n", z, x, y);
+                store_dst(ctx, p->result, z);
                 break;
             case IR_DIV:
-                x = get_reg(p->code.arg1);
-                x->locked = true;
-                y = get_reg(p->code.arg2);
-                x->locked =false;
-                z = alloc_reg(p->code.result);
-                z->modified = true;
-                fprintf(stream, "  div %s, %s\n", x->name, y->name);
-                fprintf(stream, "  mflo %s\n", z->name);
+                x = src_reg(ctx, p->arg1, SCRATCH_0);
+                y = src_reg(ctx, p->arg2, SCRATCH_1);
+                z = dst_reg(ctx, p->result, SCRATCH_0);
+                fprintf(ctx->ocStream, "  div %s, %s\n", x, y);
+                fprintf(ctx->ocStream, "  mflo %s\n", z);
+                store_dst(ctx, p->result, z);
                 break;
             case IR_REF:
-                x = alloc_reg(p->code.result);
-                x->modified = true;
-                p1 = get_local_var(p->code.arg1);
-                fprintf(stream, "  la %s, %d($fp)\n", x->name, p1->off);
+                x = dst_reg(ctx, p->result, SCRATCH_0);
+                fprintf(ctx->ocStream, "  la %s, %d($fp)\n", x, get_local_var(ctx, p->arg1)->off);
+                store_dst(ctx, p->result, x);
                 break;
             case IR_DEREF_L:    // *x = y
-                y = get_reg(p->code.arg1);
-                y->locked = true;
-                x = get_reg(p->code.result);
-                y->locked = false;
-                fprintf(stream, "  sw %s, 0(%s)\n", y->name, x->name);
+                y = src_reg(ctx, p->arg1, SCRATCH_0);
+                x = src_reg(ctx, p->result, SCRATCH_1);
+                fprintf(ctx->ocStream, "  sw %s, 0(%s)\n", y, x);
                 break;
             case IR_DEREF_R:    // x = *y
-                y = get_reg(p->code.arg1);
-                /* y->locked = true; */
-                x = alloc_reg(p->code.result);
-                x->modified = true;
-                /* y->locked = false; */
-                fprintf(stream, "  lw %s, 0(%s)\n", x->name, y->name);
+                y = src_reg(ctx, p->arg1, SCRATCH_0);
+                x = dst_reg(ctx, p->result, SCRATCH_0);
+                fprintf(ctx->ocStream, "  lw %s, 0(%s)\n", x, y);
+                store_dst(ctx, p->result, x);
                 break;
             case IR_GOTO:
-                spill_all_reg();
-                fprintf(stream, "  j label_%d\n", p->code.arg1.u.labelId);
+                fprintf(ctx->ocStream, "  j label_%d\n", p->arg1.id);
                 break;
             case IR_RELOP:
-                x = get_reg(p->code.arg1);
-                x->locked = true;
-                y = get_reg(p->code.arg2);
-                x->locked = false;
-                spill_all_reg();
-                switch(p->code.u.relop) {
+                x = src_reg(ctx, p->arg1, SCRATCH_0);
+                y = src_reg(ctx, p->arg2, SCRATCH_1);
+                switch(p->relop) {
                     case RELOP_EQ:
-                        fprintf(stream, "  beq ");
+                        fprintf(ctx->ocStream, "  beq ");
                         break;
                     case RELOP_LE:
-                        fprintf(stream, "  ble ");
+                        fprintf(ctx->ocStream, "  ble ");
                         break;
                     case RELOP_LT:
-                        fprintf(stream, "  blt ");
+                        fprintf(ctx->ocStream, "  blt ");
                         break;
                     case RELOP_GE:
-                        fprintf(stream, "  bge ");
+                        fprintf(ctx->ocStream, "  bge ");
                         break;
                     case RELOP_GT:
-                        fprintf(stream, "  bgt ");
+                        fprintf(ctx->ocStream, "  bgt ");
                         break;
                     case RELOP_NE:
-                        fprintf(stream, "  bne ");
+                        fprintf(ctx->ocStream, "  bne ");
                         break;
                 }
-                fprintf(stream, "%s, %s, label_%d\n", x->name, y->name, p->code.result.u.labelId);
+                fprintf(ctx->ocStream, "%s, %s, label_%d\n", x, y, p->result.id);
                 break;
             case IR_RET:
-                // spill_all_reg();    // no global variables
-                x = get_reg(p->code.arg1);
-                fprintf(stream, "  move $v0, %s\n", x->name);
-                gen_epilogue();
-                fprintf(stream, "  jr $ra\n");
+                x = src_reg(ctx, p->arg1, "$v0");
+                if(strcmp(x, "$v0") != 0) {
+                    fprintf(ctx->ocStream, "  move $v0, %s\n", x);
+                }
+                gen_epilogue(ctx);
+                fprintf(ctx->ocStream, "  jr $ra\n");
                 break;
-            case IR_DEC:
-                add_local_var(p->code.result, p->code.arg1.u.value);
+            case IR_DEC:    // placed by alloc_frame
                 break;
-            case IR_ARG:
-                x = get_reg(p->code.arg1);
-                fprintf(stream, "  addi $sp, $sp, -4\n");
-                fprintf(stream, "  sw %s, 0($sp)\n", x->name);
+            case IR_ARG:    // passed by the CALL
                 break;
             case IR_CALL:
-                spill_all_reg();
-                fprintf(stream, "  addi $sp, $sp, -4\n");
-                fprintf(stream, "  sw $ra, 0($sp)\n");
-                fprintf(stream, "  jal %s\n", p->code.arg1.u.symbol->name);
-                fprintf(stream, "  lw $ra, 0($sp)\n");
-                fprintf(stream, "  addi $sp, $sp, 4\n");
-                x = alloc_reg(p->code.result);
-                x->modified = true;
-                fprintf(stream, "  move %s, $v0\n", x->name);
+                if((arg_cnt = tail_call_args(func, p, max_args)) >= 0) {
+                    gen_tail_call(ctx, p, arg_cnt);
+                    ctx->call_cnt++;
+                    while((++p)->kind != IR_RET);   // the RETURN is done by the callee
+                    break;
+                }
+                gen_call(ctx, p);
+                ctx->call_cnt++;
                 break;
-            case IR_PARM:
-                add_param_var(p->code.arg1);
+            case IR_PARM:   // in its slot, see alloc_frame
+                gen_param(ctx, p->arg1, param_cnt++);
                 break;
-            case IR_READ:
-                x = alloc_reg(p->code.arg1);
-                x->modified = true;
-                fprintf(stream, "  addi $sp, $sp, -4\n");
-                fprintf(stream, "  sw $ra, 0($sp)\n");
-                fprintf(stream, "  jal read\n");
-                fprintf(stream, "  lw $ra, 0($sp)\n");
-                fprintf(stream, "  addi $sp, $sp, 4\n");
-                fprintf(stream, "  move %s, $v0\n", x->name);
+            case IR_READ:   // read and write keep every register but $v0 and $a0
+                fprintf(ctx->ocStream, "  jal read\n");
+                x = dst_reg(ctx, p->arg1, SCRATCH_0);
+                fprintf(ctx->ocStream, "  move %s, $v0\n", x);
+                store_dst(ctx, p->arg1, x);
                 break;
             case IR_WRITE:
-                x = get_reg(p->code.arg1);
-                fprintf(stream, "  move $a0, %s\n", x->name);
-                fprintf(stream, "  addi $sp, $sp, -4\n");
-                fprintf(stream, "  sw $ra, 0($sp)\n");
-                fprintf(stream, "  jal write\n");
-                fprintf(stream, "  lw $ra, 0($sp)\n");
-                fprintf(stream, "  addi $sp, $sp, 4\n");
+                x = src_reg(ctx, p->arg1, "$a0");
+                if(strcmp(x, "$a0") != 0) {
+                    fprintf(ctx->ocStream, "  move $a0, %s\n", x);
+                }
+                fprintf(ctx->ocStream, "  jal write\n");
+                break;
+            case IR_DEAD:
                 break;
         }
-        p = p->next;
-    } while(p != codeList);
+    }
+    leave_func(ctx);
 }
 
-void init_regs() {
-    for(int i = 0; i < REG_NUM; i++) {
-        regs[i].used = false;
-        regs[i].modified = false;
-        regs[i].locked = false;
-        regs[i].var = NULL;
-        sprintf(regs[i].name, "$t%d", i);
+// most arguments of a call which may reuse the frame of func: the callee
+// takes the arguments after $a3 where func has its own, so there must be
+// room for them, and no argument may point into the frame, so func has no
+// DEC. -1 if no call may
+int max_tail_args(IRFunc *func) {
+    int param_cnt = 0;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEC) return -1;
+        param_cnt += p->kind == IR_PARM;
     }
+    return param_cnt > ARG_REG_NUM ? param_cnt : ARG_REG_NUM;
 }
 
-Reg* get_reg(Operand op) {
-    // variable is in the regs
-    for(int i = 0; i < REG_NUM; i++) {
-        if(regs[i].used && isOperandEqual(regs[i].var->op, op)) {
-            return regs + i;
-        }
+// the number of arguments of x := CALL g followed by RETURN x, -1 if call
+// is no such tail call or has more than max_args arguments
+int tail_call_args(IRFunc *func, IR *call, int max_args) {
+    if(call->kind != IR_CALL) return -1;
+    int arg_cnt = 0;
+    while(call[-1 - arg_cnt].kind == IR_ARG) {
+        arg_cnt++;
     }
-    // not in, need to load from the memory
-    Reg *reg = alloc_reg(op);
-    if(op.kind == OP_CONST) {
-        reg->modified = true;
-        fprintf(stream, "  li %s, %d\n", reg->name, op.u.value);
-    } else if(op.kind == OP_TEMP || op.kind == OP_VAR) {
-        fprintf(stream, "  lw %s, %d($fp)\n", reg->name, reg->var->off);
-    } else {
-        assert(0);
+    IR *p = call + 1;
+    while(p < func->codes + func->cnt && p->kind == IR_DEAD) {
+        p++;
     }
-    return reg;
+    if(p == func->codes + func->cnt || p->kind != IR_RET || !isOperandEqual(p->arg1, call->result)) return -1;
+    return arg_cnt <= max_args ? arg_cnt : -1;
 }
 
-Reg* alloc_reg(Operand op) {
-    int i = 0;
-    for(; i < REG_NUM; i++) {
-        if(regs[i].used && isOperandEqual(regs[i].var->op, op)) {
-            return regs + i;
+// the first arguments go to $a0 - $a3 and the others over the parameters
+// this function took on the stack. an argument in the slot of a parameter
+// which an earlier argument goes to is copied below $sp before the stores
+// start. the frame goes as in a RETURN, so the
+// callee returns straight to the caller of this function
+void gen_tail_call(CompilerContext *ctx, IR *call, int arg_cnt) {
+    int off = 0;
+    for(int k = 0; k < arg_cnt && k < ARG_REG_NUM; k++) {
+        const char *x = src_reg(ctx, call[-1 - k].arg1, arg_names[k]);
+        if(x != arg_names[k]) {
+            fprintf(ctx->ocStream, "  move %s, %s\n", arg_names[k], x);
+        }
+    }
+    for(int k = ARG_REG_NUM; k < arg_cnt; k++) {
+        Operand arg = call[-1 - k].arg1;
+        if(arg.kind != OP_CONST && !op_reg(ctx, arg, &off) && off >= 8 && off < 8 + 4 * (k - ARG_REG_NUM)) {
+            fprintf(ctx->ocStream, "  lw %s, %d($fp)\n", SCRATCH_0, off);
+            fprintf(ctx->ocStream, "  sw %s, %d($sp)\n", SCRATCH_0, -4 - 4 * k);
+        }
+    }
+    for(int k = ARG_REG_NUM; k < arg_cnt; k++) {
+        Operand arg = call[-1 - k].arg1;
+        const char *x = SCRATCH_0;
+        if(arg.kind != OP_CONST && !op_reg(ctx, arg, &off) && off >= 8 && off < 8 + 4 * (k - ARG_REG_NUM)) {
+            fprintf(ctx->ocStream, "  lw %s, %d($sp)\n", SCRATCH_0, -4 - 4 * k);
+        } else {
+            x = src_reg(ctx, arg, SCRATCH_0);
         }
+        fprintf(ctx->ocStream, "  sw %s, %d($fp)\n", x, 8 + 4 * (k - ARG_REG_NUM));
     }
-    for(i = 0; i < REG_NUM; i++) {
-        if(!regs[i].used) break;
+    gen_epilogue(ctx);
+    fprintf(ctx->ocStream, "  j %s\n", operandSymbol(ctx, call->arg1)->name);
+    ctx->optStats.tailCalls++;
+}
+
+// the first arguments go in $a0 - $a3, the others to the stack, the one
+// after $a3 lowest, which is given back after the call. the registers a
+// callee may change are kept over the call only if the value in them is
+// live after it
+void gen_call(CompilerContext *ctx, IR *call) {
+    int arg_cnt = 0;
+    while(call[-1 - arg_cnt].kind == IR_ARG) {
+        arg_cnt++;
+    }
+    int stack_size = arg_cnt > ARG_REG_NUM ? 4 * (arg_cnt - ARG_REG_NUM) : 0;
+    save_regs(ctx, false);
+    if(stack_size > 0) {
+        fprintf(ctx->ocStream, "  addi $sp, $sp, %d\n", -stack_size);
+    }
+    for(int k = ARG_REG_NUM; k < arg_cnt; k++) {
+        const char *x = src_reg(ctx, call[-1 - k].arg1, SCRATCH_0);
+        fprintf(ctx->ocStream, "  sw %s, %d($sp)\n", x, 4 * (k - ARG_REG_NUM));
     }
-    if(i == REG_NUM) {
-        for(i = 0; i < REG_NUM; i++) {
-            if(!regs[i].locked) break;
+    for(int k = 0; k < arg_cnt && k < ARG_REG_NUM; k++) {
+        const char *x = src_reg(ctx, call[-1 - k].arg1, arg_names[k]);
+        if(x != arg_names[k]) {
+            fprintf(ctx->ocStream, "  move %s, %s\n", arg_names[k], x);
         }
-        if(i == REG_NUM) assert(0); // all regs is locked
-        if(regs[i].modified) {
-            spill_reg(regs + i);
-            /* fprintf(stream, "  sw %s, %d($fp)\n", regs[i].name, regs[i].var->off); */
+    }
+    fprintf(ctx->ocStream, "  jal %s\n", operandSymbol(ctx, call->arg1)->name);
+    if(stack_size > 0) {
+        fprintf(ctx->ocStream, "  addi $sp, $sp, %d\n", stack_size);
+    }
+    save_regs(ctx, true);
+    const char *x = dst_reg(ctx, call->result, SCRATCH_0);
+    fprintf(ctx->ocStream, "  move %s, $v0\n", x);
+    store_dst(ctx, call->result, x);
+}
+
+// parameter index comes in its register if it is one of the first, or in
+// its slot. it moves to where the allocator put it
+void gen_param(CompilerContext *ctx, Operand op, int index) {
+    Interval *it = opInterval(ctx->alloc, op);
+    int off = 0;
+    const char *reg = op_reg(ctx, op, &off);
+    if(it && it->end == it->start) return;     // never read
+    if(index < ARG_REG_NUM) {
+        if(reg) {
+            fprintf(ctx->ocStream, "  move %s, %s\n", reg, arg_names[index]);
+        } else {
+            fprintf(ctx->ocStream, "  sw %s, %d($fp)\n", arg_names[index], off);
         }
+    } else if(reg) {
+        fprintf(ctx->ocStream, "  lw %s, %d($fp)\n", reg, home_of(ctx, it));
+    }
+}
+
+// where op is: the name of its register, or NULL and its slot in *off
+const char* op_reg(CompilerContext *ctx, Operand op, int *off) {
+    Interval *it = opInterval(ctx->alloc, op);
+    if(it && it->reg >= 0) {
+        return reg_names[it->reg];
+    }
+    *off = it ? home_of(ctx, it) : get_local_var(ctx, op)->off;
+    return NULL;
+}
+
+int home_of(CompilerContext *ctx, Interval *it) {
+    return ctx->homes[it - ctx->alloc->intervals];
+}
+
+// the register holding the value of op, scratch once op is loaded into it
+// if op has none
+const char* src_reg(CompilerContext *ctx, Operand op, const char *scratch) {
+    int off = 0;
+    if(op.kind == OP_CONST) {
+        if(constValue(ctx, op) == 0) return "$0";
+        fprintf(ctx->ocStream, "  li %s, %d\n", scratch, constValue(ctx, op));
+        return scratch;
+    }
+    const char *reg = op_reg(ctx, op, &off);
+    if(reg) return reg;
+    fprintf(ctx->ocStream, "  lw %s, %d($fp)\n", scratch, off);
+    return scratch;
+}
+
+// the register op is computed into, scratch if op has none. store_dst then
+// puts it in the slot of op
+const char* dst_reg(CompilerContext *ctx, Operand op, const char *scratch) {
+    int off = 0;
+    const char *reg = op_reg(ctx, op, &off);
+    return reg ? reg : scratch;
+}
+
+void store_dst(CompilerContext *ctx, Operand op, const char *reg) {
+    int off = 0;
+    if(!op_reg(ctx, op, &off)) {
+        fprintf(ctx->ocStream, "  sw %s, %d($fp)\n", reg, off);
+    }
+}
+
+// the registers the allocator keeps over the current CALL go to their
+// slots before it and come back after it
+void save_regs(CompilerContext *ctx, bool restore) {
+    RegAlloc *alloc = ctx->alloc;
+    for(int i = alloc->saveFirst[ctx->call_cnt]; i < alloc->saveFirst[ctx->call_cnt + 1]; i++) {
+        Interval *it = alloc->intervals + alloc->saves[i];
+        fprintf(ctx->ocStream, "  %s %s, %d($fp)\n", restore ? "lw" : "sw", reg_names[it->reg], home_of(ctx, it));
     }
-    regs[i].used = true;
-    regs[i].modified = false;
-    regs[i].locked = false;
-    regs[i].var = get_local_var(op);
-    return regs + i;
 }
 
 // get local variable from local variable list
-LocalVar* get_local_var(Operand op) {
-    LVList *p = lvList;
+LocalVar* get_local_var(CompilerContext *ctx, Operand op) {
+    LVList *p = ctx->lvList;
     while(p) {
         if(isOperandEqual(p->var.op, op)) break;
         p = p->next;
     }
-    return p == NULL ? add_local_var(op, 4) : &p->var;
+    return p == NULL ? add_local_var(ctx, op, 4) : &p->var;
 }
 
-LocalVar* add_local_var(Operand op, int size) {
+LocalVar* add_local_var(CompilerContext *ctx, Operand op, int size) {
     LVList *p = (LVList*)malloc(sizeof(LVList));
-    p->next = lvList;
-    lvList = p;
+    p->next = ctx->lvList;
+    ctx->lvList = p;
     p->var.op = op;
-    lv_off -= size; // allocate memory for op
-    p->var.off = lv_off;
-    fprintf(stream, "  addi $sp, $sp, -%d\n", size);
+    ctx->lv_off -= size; // allocate memory for op
+    p->var.off = ctx->lv_off;
     return &p->var;
 }
 
-void add_param_var(Operand op) {
+void add_param_var(CompilerContext *ctx, Operand op) {
     LVList *p = (LVList*)malloc(sizeof(LVList));
-    p->next = lvList;
-    lvList = p;
+    p->next = ctx->lvList;
+    ctx->lvList = p;
     p->var.op = op;
-    param_off += 4;
-    p->var.off = param_off;
+    ctx->param_off += 4;
+    p->var.off = ctx->param_off;
 }
 
-void spill_reg(Reg *reg) {
-    if(reg->used && reg->modified) {
-        fprintf(stream, "  sw %s, %d($fp)\n", reg->name, reg->var->off);
+// every local of func gets its slot up front and the frame is reserved at
+// once: a slot reserved where the code first meets it would be missed by
+// a path that jumps over that point. the $s registers the function takes
+// are kept at the top of the frame. an operand the allocator tracks has
+// the slot its caller passed it in or a spill slot below the other locals,
+// the rest live in memory all the time
+void alloc_frame(CompilerContext *ctx, IRFunc *func) {
+    RegAlloc *alloc = ctx->alloc;
+    Interval *it = NULL;
+    for(int reg = TEMP_REG_NUM; reg < REG_NUM; reg++) {
+        ctx->lv_off -= alloc->usedRegs >> reg & 1 ? 4 : 0;
     }
-    free_reg(reg);
-}
-
-void free_reg(Reg *reg) {
-    reg->used = false;
-    reg->modified = false;
-    reg->locked = false;
-    reg->var = NULL;
+    int param_cnt = 0;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEC) {
+            add_local_var(ctx, p->result, constValue(ctx, p->arg1));
+        } else if(p->kind == IR_PARM && param_cnt++ >= ARG_REG_NUM) {
+            add_param_var(ctx, p->arg1);
+            if((it = opInterval(alloc, p->arg1))) {
+                ctx->homes[it - alloc->intervals] = ctx->param_off;
+            }
+        } else if(p->kind == IR_PARM && !opInterval(alloc, p->arg1)) {
+            add_local_var(ctx, p->arg1, 4);     // stored there from its register
+        }
+    }
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEAD || p->kind == IR_DEC || p->kind == IR_PARM) continue;
+        Operand ops[3] = { p->result, p->arg1, p->arg2 };
+        for(int k = 0; k < 3; k++) {
+            if((ops[k].kind == OP_TEMP || ops[k].kind == OP_VAR) && !opInterval(alloc, ops[k])) {
+                get_local_var(ctx, ops[k]);
+            }
+        }
+    }
+    for(int i = 0; i < alloc->liveness->varCnt; i++) {
+        if(alloc->intervals[i].slot >= 0) {
+            ctx->homes[i] = ctx->lv_off - 4 * (alloc->intervals[i].slot + 1);
+        }
+    }
+    ctx->lv_off -= 4 * alloc->slotCnt;
+    if(ctx->lv_off < 0) {
+        fprintf(ctx->ocStream, "  addi $sp, $sp, %d\n", ctx->lv_off);
+    }
+    save_callee_regs(ctx, false);
 }
 
-void free_all_reg() {
-    for(int i = 0; i < REG_NUM; i++) {
-        free_reg(regs+i);
+void save_callee_regs(CompilerContext *ctx, bool restore) {
+    int off = 0;
+    for(int reg = TEMP_REG_NUM; reg < REG_NUM; reg++) {
+        if(ctx->alloc->usedRegs >> reg & 1) {
+            off -= 4;
+            fprintf(ctx->ocStream, "  %s %s, %d($fp)\n", restore ? "lw" : "sw", reg_names[reg], off);
+        }
     }
 }
 
-void spill_all_reg() {
-    for(int i = 0; i < REG_NUM; i++) {
-        spill_reg(regs + i);
+void clear_lvList(CompilerContext *ctx) {
+    while(ctx->lvList) {
+        LVList *p = ctx->lvList;
+        ctx->lvList = p->next;
+        free(p);
     }
 }
 
-void clear_lvList() {
-    while(lvList) {
-        LVList *p = lvList;
-        lvList = p->next;
-        free(p);
+// a function keeps $ra if it calls anything but as a tail call
+void enter_func(CompilerContext *ctx, IRFunc *func, int max_args) {
+    clear_lvList(ctx);
+    ctx->lv_off = 0;
+    ctx->param_off = 4;
+    ctx->alloc = allocRegs(func, REG_NUM, TEMP_REG_NUM, ARG_REG_NUM);
+    ctx->homes = (int*)malloc(sizeof(int) * (ctx->alloc->liveness->varCnt + 1));
+    ctx->call_cnt = 0;
+    ctx->save_ra = false;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_READ || p->kind == IR_WRITE || (p->kind == IR_CALL && tail_call_args(func, p, max_args) < 0)) {
+            ctx->save_ra = true;
+        }
     }
 }
 
-void enter_func() {
-    free_all_reg();
-    clear_lvList();
-    lv_off = 0;
-    param_off = 4;
+void leave_func(CompilerContext *ctx) {
+    freeRegAlloc(ctx->alloc);
+    free(ctx->homes);
+    ctx->alloc = NULL;
+    ctx->homes = NULL;
 }
 
-void gen_prologue() {
-    fprintf(stream, "  addi $sp, $sp, -4\n");
-    fprintf(stream, "  sw $fp, 0($sp)\n");
-    fprintf(stream, "  move $fp, $sp\n");
+// $fp at 0($fp) and $ra at 4($fp), the arguments from 8($fp) on
+void gen_prologue(CompilerContext *ctx) {
+    fprintf(ctx->ocStream, "  addi $sp, $sp, -8\n");
+    fprintf(ctx->ocStream, "  sw $fp, 0($sp)\n");
+    if(ctx->save_ra) {
+        fprintf(ctx->ocStream, "  sw $ra, 4($sp)\n");
+    }
+    fprintf(ctx->ocStream, "  move $fp, $sp\n");
 }
 
-void gen_epilogue() {
-    fprintf(stream, "  move $sp, $fp\n");
-    fprintf(stream, "  lw $fp, 0($sp)\n");
-    fprintf(stream, "  addi $sp, $sp, 4\n");
+void gen_epilogue(CompilerContext *ctx) {
+    save_callee_regs(ctx, true);
+    fprintf(ctx->ocStream, "  move $sp, $fp\n");
+    if(ctx->save_ra) {
+        fprintf(ctx->ocStream, "  lw $ra, 4($sp)\n");
+    }
+    fprintf(ctx->ocStream, "  lw $fp, 0($sp)\n");
+    fprintf(ctx->ocStream, "  addi $sp, $sp, 8\n");
 }
@@ -1,27 +1,21 @@
 #ifndef __OC_H__
 #define __OC_H__
 #include "ir.h"
-#define REG_NAME_LEN 8
+#define REG_NUM 16  // $t0 - $t7 and $s0 - $s7 for the register allocator, see regalloc.h
+#define TEMP_REG_NUM 8  // the $t ones, which a callee may change
+#define ARG_REG_NUM 4   // arguments passed in $a0 - $a3
 
 typedef struct LocalVar LocalVar;
-typedef struct Reg Reg;
 typedef struct LVList LVList;
 
 struct LocalVar {
     Operand op;
     int off;
 };
-struct Reg {
-    char name[REG_NAME_LEN];
-    bool used;
-    bool modified;
-    bool locked;
-    LocalVar *var;
-};
 struct LVList {
     LocalVar var;
     LVList *next;
 };
 
-void generate_oc(IRList *codeList, const char *filename);
+void generate_oc(CompilerContext *ctx, IRFunc *funcList, FILE *stream);
 #endif
@@ -0,0 +1,108 @@
+#include "operand_table.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static unsigned hashInt(unsigned v);
+static unsigned hashPtr(const void *p);
+static void growConsts(OperandTable *self);
+static void growSyms(OperandTable *self);
+
+OperandTable* newOperandTable() {
+    OperandTable *self = (OperandTable*)malloc(sizeof(OperandTable));
+    memset(self, 0, sizeof(OperandTable));
+    return self;
+}
+
+static unsigned hashInt(unsigned v) {
+    v = (v ^ (v >> 16)) * 0x45d9f3bu;
+    v = (v ^ (v >> 16)) * 0x45d9f3bu;
+    return v ^ (v >> 16);
+}
+
+static unsigned hashPtr(const void *p) {
+    uintptr_t v = (uintptr_t)p >> 3;
+    return hashInt((unsigned)(v ^ (v >> 29)));
+}
+
+// the slots are rebuilt from the dense array, which keeps the indices
+static void growConsts(OperandTable *self) {
+    unsigned capacity = self->constSlotCap ? self->constSlotCap * 2 : OT_INIT_SIZE;
+    unsigned *slots = (unsigned*)calloc(capacity, sizeof(unsigned));
+    for(unsigned k = 0; k < self->constCnt; k++) {
+        unsigned i = hashInt((unsigned)self->consts[k]) & (capacity - 1);
+        while(slots[i]) {
+            i = (i + 1) & (capacity - 1);
+        }
+        slots[i] = k + 1;
+    }
+    free(self->constSlots);
+    self->constSlots = slots;
+    self->constSlotCap = capacity;
+}
+
+static void growSyms(OperandTable *self) {
+    unsigned capacity = self->symSlotCap ? self->symSlotCap * 2 : OT_INIT_SIZE;
+    unsigned *slots = (unsigned*)calloc(capacity, sizeof(unsigned));
+    for(unsigned k = 0; k < self->symCnt; k++) {
+        unsigned i = hashPtr(self->syms[k]) & (capacity - 1);
+        while(slots[i]) {
+            i = (i + 1) & (capacity - 1);
+        }
+        slots[i] = k + 1;
+    }
+    free(self->symSlots);
+    self->symSlots = slots;
+    self->symSlotCap = capacity;
+}
+
+// index of value, added if it is new
+unsigned OT_const(OperandTable *self, int value) {
+    if(2 * (self->constCnt + 1) > self->constSlotCap) {
+        growConsts(self);
+    }
+    unsigned mask = self->constSlotCap - 1;
+    unsigned i = hashInt((unsigned)value) & mask;
+    while(self->constSlots[i]) {
+        unsigned k = self->constSlots[i] - 1;
+        if(self->consts[k] == value) return k;
+        i = (i + 1) & mask;
+    }
+    if(self->constCnt == self->constCap) {
+        self->constCap = self->constCap ? self->constCap * 2 : OT_INIT_SIZE;
+        self->consts = (int*)realloc(self->consts, sizeof(int) * self->constCap);
+    }
+    self->consts[self->constCnt] = value;
+    self->constSlots[i] = ++self->constCnt;
+    return self->constCnt - 1;
+}
+
+// index of sym, added if it is new
+unsigned OT_symbol(OperandTable *self, Symbol *sym) {
+    if(2 * (self->symCnt + 1) > self->symSlotCap) {
+        growSyms(self);
+    }
+    unsigned mask = self->symSlotCap - 1;
+    unsigned i = hashPtr(sym) & mask;
+    while(self->symSlots[i]) {
+        unsigned k = self->symSlots[i] - 1;
+        if(self->syms[k] == sym) return k;
+        i = (i + 1) & mask;
+    }
+    if(self->symCnt == self->symCap) {
+        self->symCap = self->symCap ? self->symCap * 2 : OT_INIT_SIZE;
+        self->syms = (Symbol**)realloc(self->syms, sizeof(Symbol*) * self->symCap);
+    }
+    self->syms[self->symCnt] = sym;
+    self->symSlots[i] = ++self->symCnt;
+    return self->symCnt - 1;
+}
+
+// free the table, the symbols belong to the symbol table
+void OT_clear(OperandTable *self) {
+    free(self->consts);
+    free(self->constSlots);
+    free(self->syms);
+    free(self->symSlots);
+    free(self);
+}
@@ -0,0 +1,30 @@
+#ifndef __OPERAND_TABLE_H__
+#define __OPERAND_TABLE_H__
+
+#include "semantic.h"
+#define OT_INIT_SIZE 0x100  // 256 slots, power of two
+
+// dense tables behind the packed IR operands: an OP_CONST operand holds the
+// index of its value, OP_VAR and OP_FUNC operands the index of their symbol.
+// a value or a symbol is added once, so equal operands have equal indices.
+typedef struct OperandTable OperandTable;
+
+struct OperandTable {
+    int *consts;
+    unsigned constCnt;
+    unsigned constCap;
+    unsigned *constSlots;   // index + 1 of a constant, 0 for an empty slot
+    unsigned constSlotCap;
+    Symbol **syms;
+    unsigned symCnt;
+    unsigned symCap;
+    unsigned *symSlots;     // index + 1 of a symbol, 0 for an empty slot
+    unsigned symSlotCap;
+};
+
+OperandTable* newOperandTable();
+unsigned OT_const(OperandTable *self, int value);
+unsigned OT_symbol(OperandTable *self, Symbol *sym);
+void OT_clear(OperandTable *self);
+
+#endif
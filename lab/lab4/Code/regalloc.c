@@ -0,0 +1,293 @@
+#include "regalloc.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COST_MAX_DEPTH 4    // loops nested deeper weigh no more
+
+static void buildIntervals(RegAlloc *self, IRFunc *func, int argRegCnt);
+static void extend(Interval *it, int pos);
+static int sortByStart(RegAlloc *self, int posCnt, int *order);
+static void findCalls(RegAlloc *self, IRFunc *func, int **first, int **lives, bool *crossing);
+static void liveOverCalls(RegAlloc *self, IRFunc *func, int *callNo, int *first, int *lives);
+static void scan(RegAlloc *self, int *order, int cnt, bool *crossing);
+static int pickReg(RegAlloc *self, bool *busy, bool crossing);
+static void findSaves(RegAlloc *self, int *first, int *lives, bool *saved);
+static void assignSlots(RegAlloc *self, int *order, int cnt, bool *saved);
+
+// intervals are made from the liveness at the bounds of the blocks and the
+// operands of the codes, so an operand is live at most where its interval
+// runs. the scan, the saves over calls and the spill slots go through the
+// intervals in order of start
+RegAlloc* allocRegs(IRFunc *func, int regCnt, int tempCnt, int argRegCnt) {
+    RegAlloc *self = (RegAlloc*)malloc(sizeof(RegAlloc));
+    memset(self, 0, sizeof(RegAlloc));
+    self->liveness = computeLiveness(func);
+    self->regCnt = regCnt;
+    self->tempCnt = tempCnt;
+    int n = self->liveness->varCnt;
+    self->intervals = (Interval*)malloc(sizeof(Interval) * (n > 0 ? n : 1));
+    for(int i = 0; i < n; i++) {
+        Interval *it = self->intervals + i;
+        it->start = it->end = -1;
+        it->cost = 0;
+        it->reg = it->slot = -1;
+        it->param = false;
+    }
+    buildIntervals(self, func, argRegCnt);
+    int *order = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));
+    bool *flags = (bool*)malloc(sizeof(bool) * (n > 0 ? n : 1));
+    int *first = NULL, *lives = NULL;
+    int cnt = sortByStart(self, 2 * func->cnt, order);
+    findCalls(self, func, &first, &lives, flags);
+    scan(self, order, cnt, flags);
+    findSaves(self, first, lives, flags);
+    assignSlots(self, order, cnt, flags);
+    free(order);
+    free(flags);
+    free(first);
+    free(lives);
+    return self;
+}
+
+void freeRegAlloc(RegAlloc *self) {
+    if(!self) return;
+    freeLiveness(self->liveness);
+    free(self->intervals);
+    free(self->saveFirst);
+    free(self->saves);
+    free(self);
+}
+
+Interval* opInterval(RegAlloc *self, Operand op) {
+    int slot = liveSlot(self->liveness, op);
+    return slot >= 0 ? self->intervals + slot : NULL;
+}
+
+static void buildIntervals(RegAlloc *self, IRFunc *func, int argRegCnt) {
+    Liveness *liveness = self->liveness;
+    CFG *cfg = liveness->cfg;
+    int n = liveness->varCnt, paramCnt = 0;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        int weight = 1, depth = CFG_loopDepth(cfg, b);
+        for(int d = 0; d < depth && d < COST_MAX_DEPTH; d++) {
+            weight *= 10;
+        }
+        for(int v = BV_next(liveness->in + b, 0); v >= 0 && v < n; v = BV_next(liveness->in + b, v + 1)) {
+            extend(self->intervals + v, 2 * block->first);
+        }
+        for(int v = BV_next(liveness->out + b, 0); v >= 0 && v < n; v = BV_next(liveness->out + b, v + 1)) {
+            extend(self->intervals + v, 2 * block->last - 1);
+        }
+        for(int i = block->first; i < block->last; i++) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            Operand *uses[2], *def;
+            int cnt = useOperands(p, uses), slot;
+            for(int k = 0; k < cnt; k++) {
+                if((slot = liveSlot(liveness, *uses[k])) >= 0) {
+                    extend(self->intervals + slot, 2 * i);
+                    self->intervals[slot].cost += weight;
+                }
+            }
+            if((def = defOperand(p)) && (slot = liveSlot(liveness, *def)) >= 0) {
+                extend(self->intervals + slot, 2 * i + 1);
+                self->intervals[slot].cost += weight;
+                self->intervals[slot].param |= p->kind == IR_PARM && paramCnt >= argRegCnt;
+            }
+            paramCnt += p->kind == IR_PARM;
+        }
+    }
+}
+
+static void extend(Interval *it, int pos) {
+    if(it->start < 0 || pos < it->start) {
+        it->start = pos;
+    }
+    if(pos > it->end) {
+        it->end = pos;
+    }
+}
+
+// counting sort over the positions, intervals never seen are left out
+static int sortByStart(RegAlloc *self, int posCnt, int *order) {
+    int n = self->liveness->varCnt, cnt = 0;
+    int *first = (int*)malloc(sizeof(int) * (posCnt + 1));
+    memset(first, 0, sizeof(int) * (posCnt + 1));
+    for(int i = 0; i < n; i++) {
+        if(self->intervals[i].start >= 0) {
+            first[self->intervals[i].start + 1]++;
+            cnt++;
+        }
+    }
+    for(int pos = 0; pos < posCnt; pos++) {
+        first[pos + 1] += first[pos];
+    }
+    for(int i = 0; i < n; i++) {
+        if(self->intervals[i].start >= 0) {
+            order[first[self->intervals[i].start]++] = i;
+        }
+    }
+    free(first);
+    return cnt;
+}
+
+// an interval takes a free register as it starts. with none free, the
+// cheapest of it and the active ones is spilled, of equal ones the one
+// which ends last. intervals are never split: a spilled interval lives in
+// its slot from start to end, also where it had a register, which oc.c
+// relies on. its register goes to the new interval
+static void scan(RegAlloc *self, int *order, int cnt, bool *crossing) {
+    int *active = (int*)malloc(sizeof(int) * (self->regCnt > 0 ? self->regCnt : 1));
+    bool *busy = (bool*)malloc(sizeof(bool) * (self->regCnt > 0 ? self->regCnt : 1));
+    int activeCnt = 0;
+    memset(busy, 0, sizeof(bool) * self->regCnt);
+    for(int i = 0; i < cnt; i++) {
+        Interval *it = self->intervals + order[i];
+        int kept = 0;
+        for(int k = 0; k < activeCnt; k++) {
+            Interval *a = self->intervals + active[k];
+            if(a->end < it->start) {
+                busy[a->reg] = false;
+            } else {
+                active[kept++] = active[k];
+            }
+        }
+        activeCnt = kept;
+        if(activeCnt < self->regCnt) {
+            it->reg = pickReg(self, busy, crossing[order[i]]);
+            busy[it->reg] = true;
+            self->usedRegs |= 1u << it->reg;
+            active[activeCnt++] = order[i];
+            continue;
+        }
+        int victim = -1;
+        Interval *cheapest = it;
+        for(int k = 0; k < activeCnt; k++) {
+            Interval *a = self->intervals + active[k];
+            if(a->cost < cheapest->cost || (a->cost == cheapest->cost && a->end > cheapest->end)) {
+                cheapest = a;
+                victim = k;
+            }
+        }
+        if(victim >= 0) {
+            it->reg = cheapest->reg;
+            cheapest->reg = -1;
+            active[victim] = order[i];
+        }
+    }
+    free(active);
+    free(busy);
+}
+
+// the operands live over each CALL, in code order, go to lives from
+// first[c] to first[c + 1]. an interval is crossing if it is live over any
+static void findCalls(RegAlloc *self, IRFunc *func, int **first, int **lives, bool *crossing) {
+    int n = self->liveness->varCnt;
+    int *callNo = (int*)malloc(sizeof(int) * func->cnt);
+    for(int i = 0; i < func->cnt; i++) {
+        callNo[i] = self->callCnt;
+        self->callCnt += func->codes[i].kind == IR_CALL;
+    }
+    *first = (int*)malloc(sizeof(int) * (self->callCnt + 1));
+    memset(*first, 0, sizeof(int) * (self->callCnt + 1));
+    liveOverCalls(self, func, callNo, *first, NULL);
+    for(int c = 0; c < self->callCnt; c++) {
+        (*first)[c + 1] += (*first)[c];
+    }
+    int *next = (int*)malloc(sizeof(int) * (self->callCnt + 1));
+    memcpy(next, *first, sizeof(int) * (self->callCnt + 1));
+    *lives = (int*)malloc(sizeof(int) * ((*first)[self->callCnt] + 1));
+    liveOverCalls(self, func, callNo, next, *lives);
+    memset(crossing, 0, sizeof(bool) * n);
+    for(int k = 0; k < (*first)[self->callCnt]; k++) {
+        crossing[(*lives)[k]] = true;
+    }
+    free(next);
+    free(callNo);
+}
+
+// a walk back through each block from its live out finds what is live
+// after each CALL, its result aside. with lives NULL the operands are
+// counted in first[c + 1], else put at first[c] on
+static void liveOverCalls(RegAlloc *self, IRFunc *func, int *callNo, int *first, int *lives) {
+    Liveness *liveness = self->liveness;
+    CFG *cfg = liveness->cfg;
+    int n = liveness->varCnt;
+    BitVec *live = newBitVecs(1, n);
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        BV_copy(live, liveness->out + b);
+        for(int i = block->last - 1; i >= block->first; i--) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            if(p->kind == IR_CALL) {
+                int result = liveSlot(liveness, p->result);
+                for(int v = BV_next(live, 0); v >= 0 && v < n; v = BV_next(live, v + 1)) {
+                    if(v == result) continue;
+                    if(lives) {
+                        lives[first[callNo[i]]++] = v;
+                    } else {
+                        first[callNo[i] + 1]++;
+                    }
+                }
+            }
+            liveStep(liveness, p, live);
+        }
+    }
+    freeBitVecs(live);
+}
+
+// an interval live over a call would rather have a register the callee
+// keeps, any other one a register which costs no save in the prologue
+static int pickReg(RegAlloc *self, bool *busy, bool crossing) {
+    int first = crossing ? self->tempCnt : 0;
+    for(int k = 0; k < self->regCnt; k++) {
+        int reg = (first + k) % self->regCnt;
+        if(!busy[reg]) return reg;
+    }
+    assert(0);  // the caller saw a free one
+    return -1;
+}
+
+// an interval in a register a call changes is saved over the calls it is
+// live over
+static void findSaves(RegAlloc *self, int *first, int *lives, bool *saved) {
+    int n = self->liveness->varCnt;
+    self->saveFirst = (int*)malloc(sizeof(int) * (self->callCnt + 1));
+    self->saves = (int*)malloc(sizeof(int) * (first[self->callCnt] + 1));
+    memset(saved, 0, sizeof(bool) * n);
+    int cnt = 0;
+    for(int c = 0; c < self->callCnt; c++) {
+        self->saveFirst[c] = cnt;
+        for(int k = first[c]; k < first[c + 1]; k++) {
+            Interval *it = self->intervals + lives[k];
+            if(it->reg >= 0 && it->reg < self->tempCnt) {
+                self->saves[cnt++] = lives[k];
+                saved[lives[k]] = true;
+            }
+        }
+    }
+    self->saveFirst[self->callCnt] = cnt;
+}
+
+// a spilled interval, or one saved over a call, takes the first slot whose
+// intervals have all ended. a parameter has the slot its caller passed it in
+static void assignSlots(RegAlloc *self, int *order, int cnt, bool *saved) {
+    int *slotEnd = (int*)malloc(sizeof(int) * (cnt > 0 ? cnt : 1));
+    for(int i = 0; i < cnt; i++) {
+        Interval *it = self->intervals + order[i];
+        if(it->param || (it->reg >= 0 && !saved[order[i]])) continue;
+        int slot = 0;
+        while(slot < self->slotCnt && slotEnd[slot] >= it->start) {
+            slot++;
+        }
+        if(slot == self->slotCnt) {
+            self->slotCnt++;
+        }
+        slotEnd[slot] = it->end;
+        it->slot = slot;
+    }
+    free(slotEnd);
+}
@@ -0,0 +1,44 @@
+#ifndef __REGALLOC_H__
+#define __REGALLOC_H__
+
+#include "ir.h"
+#include "liveness.h"
+
+typedef struct Interval Interval;
+typedef struct RegAlloc RegAlloc;
+
+// code i reads its operands at position 2i and writes its result at 2i + 1.
+// an interval runs from the first position its operand is live or seen to
+// the last one, over the codes in their order
+struct Interval {
+    int start;
+    int end;
+    int cost;   // reads and writes, each loop around them weighs ten times
+    int reg;    // -1 if spilled, the operand then lives in its slot
+    int slot;   // spill slot, or where reg is kept over a call, -1 if none
+    bool param; // lives in the slot its caller passed it in, not a spill slot
+};
+
+// linear scan register allocation over a whole function. every tracked
+// operand of the liveness (see liveness.h) has one interval, which keeps
+// one register or none from its start to its end. intervals which never
+// overlap share a spill slot. registers below tempCnt are changed by a
+// call, the others are kept by the callee. the first argRegCnt parameters
+// come in registers and need a spill slot like any other operand
+struct RegAlloc {
+    Liveness *liveness;
+    Interval *intervals;    // one per liveness slot
+    int regCnt;
+    int tempCnt;
+    unsigned usedRegs;  // bit per register any interval took
+    int slotCnt;
+    int callCnt;
+    int *saveFirst;     // per CALL in code order, its intervals in saves
+    int *saves;         // intervals with a register below tempCnt over each CALL
+};
+
+RegAlloc* allocRegs(IRFunc *func, int regCnt, int tempCnt, int argRegCnt);
+void freeRegAlloc(RegAlloc *self);
+Interval* opInterval(RegAlloc *self, Operand op);   // NULL if op is not tracked
+
+#endif
@@ -0,0 +1,337 @@
+#include "ssa.h"
+#include "context.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Lattice Lattice;
+typedef struct Propagation Propagation;
+
+typedef enum {
+    LAT_TOP,    // no value seen yet
+    LAT_CONST,
+    LAT_BOTTOM  // more than one value, or unknown
+} LatticeKind;
+
+struct Lattice {
+    LatticeKind kind;
+    int value;  // for LAT_CONST
+};
+
+// Wegman and Zadeck: values only flow along edges found executable, and
+// an edge is found executable once a branch can take it
+struct Propagation {
+    CompilerContext *ctx;
+    SSA *ssa;
+    Lattice *vals;  // of each SSA name
+    bool *blockExec;
+    bool *edgeExec;     // two per block, as BasicBlock.succ
+    int *useStart;  // codes reading name i are uses[useStart[i] .. useStart[i + 1])
+    int *uses;
+    int *edgeWork;  // block * 2 + k
+    int edgeCnt;
+    int *nameWork;
+    int nameCnt;
+};
+
+static void findUses(Propagation *self);
+static Lattice valueOf(Propagation *self, Operand op);
+static Lattice evalCode(Propagation *self, IR *code);
+static void lower(Propagation *self, Operand name, Lattice val);
+static void markEdge(Propagation *self, int b, int k);
+static bool edgeTaken(Propagation *self, int from, int to);
+static void visitCode(Propagation *self, int i);
+static void visitBlock(Propagation *self, int b);
+static void visitPhis(Propagation *self, int b);
+static void rewrite(Propagation *self);
+
+// sparse conditional constant propagation: names found constant replace
+// their uses and their defs go, branches decided by constants become jumps,
+// and blocks never reached go
+void SCCP(CompilerContext *ctx, SSA *ssa) {
+    Propagation self;
+    CFG *cfg = ssa->cfg;
+    int n = cfg->blockCnt;
+    memset(&self, 0, sizeof(Propagation));
+    self.ctx = ctx;
+    self.ssa = ssa;
+    self.vals = (Lattice*)calloc(ssa->nameCnt + 1, sizeof(Lattice));
+    self.blockExec = (bool*)calloc(n, sizeof(bool));
+    self.edgeExec = (bool*)calloc(n * 2, sizeof(bool));
+    self.edgeWork = (int*)malloc(sizeof(int) * n * 2);
+    self.nameWork = (int*)malloc(sizeof(int) * (ssa->nameCnt * 2 + 1));   // a name is lowered at most twice
+    findUses(&self);
+    self.blockExec[0] = true;
+    visitBlock(&self, 0);
+    while(self.edgeCnt > 0 || self.nameCnt > 0) {
+        if(self.edgeCnt > 0) {
+            int e = self.edgeWork[--self.edgeCnt];
+            int s = cfg->blocks[e / 2].succ[e % 2];
+            if(!self.blockExec[s]) {
+                self.blockExec[s] = true;
+                visitBlock(&self, s);
+            } else {
+                visitPhis(&self, s);
+            }
+            continue;
+        }
+        int name = self.nameWork[--self.nameCnt];
+        for(int k = self.useStart[name]; k < self.useStart[name + 1]; k++) {
+            int i = self.uses[k];
+            if(self.blockExec[cfg->codeBlock[i]]) {
+                visitCode(&self, i);
+            }
+        }
+    }
+    rewrite(&self);
+    free(self.vals);
+    free(self.blockExec);
+    free(self.edgeExec);
+    free(self.edgeWork);
+    free(self.nameWork);
+    free(self.useStart);
+    free(self.uses);
+}
+
+// the phi arguments count as uses by the PHI
+static void findUses(Propagation *self) {
+    SSA *ssa = self->ssa;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    self->useStart = (int*)calloc(ssa->nameCnt + 2, sizeof(int));
+    for(int pass = 0; pass < 2; pass++) {
+        for(int i = 0; i < func->cnt; i++) {
+            IR *p = func->codes + i;
+            Operand *ops[2];
+            int cnt = 0;
+            if(p->kind == IR_PHI) {
+                Operand *args = phiArgs(ssa, p);
+                int argCnt = cfg->blocks[cfg->codeBlock[i]].predCnt;
+                for(int k = 0; k < argCnt; k++) {
+                    if(!isSSAName(ssa, args[k])) continue;
+                    int name = args[k].id - ssa->nameBase;
+                    if(pass == 0) {
+                        self->useStart[name + 1]++;
+                    } else {
+                        self->uses[self->useStart[name]++] = i;
+                    }
+                }
+                continue;
+            } else if(p->kind != IR_DEAD) {
+                cnt = useOperands(p, ops);
+            }
+            for(int k = 0; k < cnt; k++) {
+                if(!isSSAName(ssa, *ops[k])) continue;
+                int name = ops[k]->id - ssa->nameBase;
+                if(pass == 0) {
+                    self->useStart[name + 1]++;
+                } else {
+                    self->uses[self->useStart[name]++] = i;
+                }
+            }
+        }
+        if(pass == 0) {
+            for(int v = 0; v < ssa->nameCnt; v++) {
+                self->useStart[v + 1] += self->useStart[v];
+            }
+            int total = self->useStart[ssa->nameCnt];
+            self->uses = (int*)malloc(sizeof(int) * (total > 0 ? total : 1));
+        }
+    }
+    memmove(self->useStart + 1, self->useStart, sizeof(int) * ssa->nameCnt);
+    self->useStart[0] = 0;
+}
+
+// an operand which is no SSA name is a parameter or has no def: unknown
+static Lattice valueOf(Propagation *self, Operand op) {
+    Lattice val;
+    if(op.kind == OP_CONST) {
+        val.kind = LAT_CONST;
+        val.value = constValue(self->ctx, op);
+    } else if(isSSAName(self->ssa, op)) {
+        val = self->vals[op.id - self->ssa->nameBase];
+    } else {
+        val.kind = LAT_BOTTOM;
+        val.value = 0;
+    }
+    return val;
+}
+
+// memory, calls and input are never constant
+static Lattice evalCode(Propagation *self, IR *code) {
+    Lattice val, a, b;
+    val.kind = LAT_BOTTOM;
+    val.value = 0;
+    switch(code->kind) {
+        case IR_ASSIGN:
+            return valueOf(self, code->arg1);
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+            a = valueOf(self, code->arg1);
+            b = valueOf(self, code->arg2);
+            if(a.kind == LAT_BOTTOM || b.kind == LAT_BOTTOM) {
+                return val;
+            } else if(a.kind == LAT_TOP || b.kind == LAT_TOP) {
+                val.kind = LAT_TOP;
+            } else if(foldArith(code->kind, a.value, b.value, &val.value)) {
+                val.kind = LAT_CONST;
+            }
+            return val;
+        default:
+            return val;
+    }
+}
+
+static void lower(Propagation *self, Operand name, Lattice val) {
+    int i = name.id - self->ssa->nameBase;
+    Lattice *cur = self->vals + i;
+    if(cur->kind == LAT_BOTTOM || val.kind == LAT_TOP) return;
+    if(cur->kind == LAT_CONST && (val.kind == LAT_CONST && val.value == cur->value)) return;
+    if(cur->kind == LAT_CONST) {
+        val.kind = LAT_BOTTOM;
+    }
+    *cur = val;
+    self->nameWork[self->nameCnt++] = i;
+}
+
+static void markEdge(Propagation *self, int b, int k) {
+    if(self->edgeExec[b * 2 + k]) return;
+    self->edgeExec[b * 2 + k] = true;
+    self->edgeWork[self->edgeCnt++] = b * 2 + k;
+}
+
+static bool edgeTaken(Propagation *self, int from, int to) {
+    BasicBlock *block = self->ssa->cfg->blocks + from;
+    for(int k = 0; k < block->succCnt; k++) {
+        if(block->succ[k] == to && self->edgeExec[from * 2 + k]) return true;
+    }
+    return false;
+}
+
+static void visitCode(Propagation *self, int i) {
+    SSA *ssa = self->ssa;
+    CFG *cfg = ssa->cfg;
+    IR *p = ssa->func->codes + i;
+    int b = cfg->codeBlock[i];
+    BasicBlock *block = cfg->blocks + b;
+    if(p->kind == IR_PHI) {
+        Lattice val;
+        val.kind = LAT_TOP;
+        val.value = 0;
+        Operand *args = phiArgs(ssa, p);
+        for(int k = 0; k < block->predCnt && val.kind != LAT_BOTTOM; k++) {
+            if(!edgeTaken(self, block->preds[k], b)) continue;
+            Lattice arg = valueOf(self, args[k]);
+            if(arg.kind == LAT_TOP) continue;
+            if(val.kind == LAT_TOP) {
+                val = arg;
+            } else if(arg.kind == LAT_BOTTOM || arg.value != val.value) {
+                val.kind = LAT_BOTTOM;
+            }
+        }
+        lower(self, p->result, val);
+    } else if(p->kind == IR_RELOP) {
+        if(block->succCnt < 2) {
+            markEdge(self, b, 0);
+            return;
+        }
+        Lattice a = valueOf(self, p->arg1), c = valueOf(self, p->arg2);
+        if(a.kind == LAT_TOP || c.kind == LAT_TOP) return;
+        if(a.kind == LAT_CONST && c.kind == LAT_CONST) {
+            markEdge(self, b, relopHolds(p->relop, a.value, c.value) ? 1 : 0);
+        } else {
+            markEdge(self, b, 0);
+            markEdge(self, b, 1);
+        }
+    } else if(p->kind != IR_DEAD) {
+        Operand *def = defOperand(p);
+        if(def && isSSAName(ssa, *def)) {
+            lower(self, *def, evalCode(self, p));
+        }
+    }
+}
+
+// a block ending in a RELOP takes the edges its visit decides
+static void visitBlock(Propagation *self, int b) {
+    SSA *ssa = self->ssa;
+    BasicBlock *block = ssa->cfg->blocks + b;
+    IR *last = NULL;
+    for(int i = block->first; i < block->last; i++) {
+        if(ssa->func->codes[i].kind == IR_DEAD) continue;
+        visitCode(self, i);
+        last = ssa->func->codes + i;
+    }
+    if(!last || last->kind != IR_RELOP) {
+        for(int k = 0; k < block->succCnt; k++) {
+            markEdge(self, b, k);
+        }
+    }
+}
+
+static void visitPhis(Propagation *self, int b) {
+    SSA *ssa = self->ssa;
+    BasicBlock *block = ssa->cfg->blocks + b;
+    for(int i = block->first + 1; i < block->last; i++) {
+        IR *p = ssa->func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        if(p->kind != IR_PHI) break;
+        visitCode(self, i);
+    }
+}
+
+static void rewrite(Propagation *self) {
+    SSA *ssa = self->ssa;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    OptStats *stats = &self->ctx->optStats;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        if(!self->blockExec[b]) {
+            for(int i = block->first; i < block->last; i++) {
+                if(func->codes[i].kind != IR_DEAD) {
+                    removeCode(func, func->codes + i);
+                }
+            }
+            stats->deadBlocks++;
+            continue;
+        }
+        for(int i = block->first; i < block->last; i++) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            Operand *def = defOperand(p);
+            if(def && isSSAName(ssa, *def) && self->vals[def->id - ssa->nameBase].kind == LAT_CONST) {
+                removeCode(func, p);
+                stats->constDefs++;
+                continue;
+            }
+            Operand *uses[2];
+            int cnt = 0;
+            if(p->kind == IR_PHI) {
+                Operand *args = phiArgs(ssa, p);
+                for(int k = 0; k < block->predCnt; k++) {
+                    if(!edgeTaken(self, block->preds[k], b)) {
+                        args[k].kind = OP_INV;
+                        args[k].id = 0;
+                    } else if(isSSAName(ssa, args[k]) && self->vals[args[k].id - ssa->nameBase].kind == LAT_CONST) {
+                        args[k] = constOperand(self->ctx, self->vals[args[k].id - ssa->nameBase].value);
+                        stats->constUses++;
+                    }
+                }
+            } else {
+                cnt = useOperands(p, uses);
+            }
+            for(int k = 0; k < cnt; k++) {
+                if(isSSAName(ssa, *uses[k]) && self->vals[uses[k]->id - ssa->nameBase].kind == LAT_CONST) {
+                    *uses[k] = constOperand(self->ctx, self->vals[uses[k]->id - ssa->nameBase].value);
+                    stats->constUses++;
+                }
+            }
+            if(p->kind == IR_RELOP && block->succCnt == 2 && self->edgeExec[b * 2] != self->edgeExec[b * 2 + 1]) {
+                resolveRelop(func, p, self->edgeExec[b * 2 + 1]);
+                stats->branches++;
+            }
+        }
+    }
+}
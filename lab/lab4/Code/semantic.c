@@ -1,148 +1,160 @@
 #include "semantic.h"
+#include "context.h"
+#include <stdint.h>
 #include <assert.h>
 
-static RB_Tree *symbolTable = NULL;
-static Symbol *func = NULL; // current function: for check return type
-/* static Type *retType = NULL; */
-static Type *intType = NULL;
-static Type *floatType = NULL;
-static int alloc_id = 1;    // for anonymous structure, simulate java anonymous class
-static void semantic_error(int errType, int lineno, const char *desc, const char *text);    // output semantic error
+static void semantic_error(CompilerContext *ctx, int errType, int lineno, const char *desc, const char *text);    // output semantic error
 
 // build symbol table
-static void initSymbolTable();
-static int symbolCmp(Symbol*, Symbol*);
+static void initSymbolTable(CompilerContext *ctx);
 
 // high level semantic parse
-static void parse(Node *node);
-static void parseExtDef(Node *extDef);
-static void parseDef(Node *def);
-static void checkStmt(Node *stmt);
+static void parse(CompilerContext *ctx, Node *node);
+static void parseExtDef(CompilerContext *ctx, Node *extDef);
+static void parseCompSt(CompilerContext *ctx, Node *compSt);
+static void parseDef(CompilerContext *ctx, Node *def);
+static void checkStmt(CompilerContext *ctx, Node *stmt);
 
 // low level semantic parse
-static void parseFunDec(Type *type, Node *funDec);
-static void parseExtDecList(Type *type, Node *extDecList);
-static void parseDecList(Type *type, Node *decList);
+static void parseFunDec(CompilerContext *ctx, Type *type, Node *funDec);
+static void parseExtDecList(CompilerContext *ctx, Type *type, Node *extDecList);
+static void parseDecList(CompilerContext *ctx, Type *type, Node *decList);
 
 // utilities
-static Type* parseSpecifier(Node *specifier);
-static Type* parseStructSpecifier(Node *structSpecifier);
+static Type* parseSpecifier(CompilerContext *ctx, Node *specifier);
+static Type* parseStructSpecifier(CompilerContext *ctx, Node *structSpecifier);
 /* static FieldList* buildFields(Node *defList); */
-static FieldList* buildFields(FieldList *fieldList, Node *defList);
-static ArgList* buildArgs(Node *varList);
-static Symbol* getVarSymbol(Type *type, Node *varDec);  // type is inherited attribute
-static Symbol* getFunSymbol(Type *retType, Node *funDec);   // return type is inherited attribute
+static FieldList* buildFields(CompilerContext *ctx, FieldList *fieldList, Node *defList);
+static ArgList* buildArgs(CompilerContext *ctx, Node *varList);
+static Symbol* getVarSymbol(CompilerContext *ctx, Type *type, Node *varDec);  // type is inherited attribute
+static Symbol* getFunSymbol(CompilerContext *ctx, Type *retType, Node *funDec);   // return type is inherited attribute
 /* static Type* getExpType(Node *exp); // parse expression */
-static Type* getComplexExpType(Node *exp);
+static Type* getComplexExpType(CompilerContext *ctx, Node *exp);
+static Type* evalExpType(CompilerContext *ctx, Node *exp);
 
-static bool structEqual(FieldList*,FieldList*);
+static Type* newType(CompilerContext *ctx, TypeKind kind);
+static void completeType(CompilerContext *ctx, Type *type);
 static bool typeEqual(Type*, Type*);
-static FieldList* getField(FieldList *structure, const char *name);
+static void buildFieldIndex(CompilerContext *ctx, Type *structure);
 
 static bool addField(FieldList *structure, FieldList *field);
-static bool checkArgs(ArgList *argsList, Node *args);
+static bool checkArgs(CompilerContext *ctx, ArgList *argsList, Node *args);
 static bool isLeftVal(Node *exp);
-static void printSymbolTable();
+static void printSymbolTable(CompilerContext *ctx);
 
 // for memory dealloc
 static void freeSymbol(Symbol *sym);
-static void freeVar(Symbol *var);
 static void freeFun(Symbol *fun);
-static void freeStruct(Symbol *structure);
 
 // for lab3(add read and write functions)
-static void addBuiltInFuns();
+static void addBuiltInFuns(CompilerContext *ctx);
 
-void semantic_parse(Node *root) {
-    initSymbolTable();
+void semantic_parse(CompilerContext *ctx, Node *root) {
+    initSymbolTable(ctx);
 #ifdef __LAB3__
-    addBuiltInFuns();
+    addBuiltInFuns(ctx);
 #endif
-    parse(root);
+    parse(ctx, root);
     /* RB_check(symbolTable); */
     /* printSymbolTable(); */
 #ifndef __LAB3__
-    clearSymbolTable();
+    clearSymbolTable(ctx);
 #endif
 }
 
-static void parse(Node *node) {
+static void parse(CompilerContext *ctx, Node *node) {
     if(node == NULL) return;
     /* if(node->type > NODE_Program && node->childno == 0) return; */
     switch(node->type) {
         case NODE_ExtDef:
-            parseExtDef(node);
+            parseExtDef(ctx, node);
             return;
         case NODE_Stmt:
-            checkStmt(node);
+            checkStmt(ctx, node);
             return;
         case NODE_Def:
-            parseDef(node);
+            parseDef(ctx, node);
+            return;
+        case NODE_CompSt:
+            ST_pushScope(ctx->symbolTable);
+            parseCompSt(ctx, node);
+            ST_popScope(ctx->symbolTable);
             return;
         default:
             break;
     }
     for(Node *p = node->child; p; p = p->sib) {
-        parse(p);
+        parse(ctx, p);
     }
 }
 
-static void parseExtDef(Node *extDef) {
-    Type *type = parseSpecifier(extDef->child);
+// deflist and stmtlist of compst, in the scope opened by the caller
+static void parseCompSt(CompilerContext *ctx, Node *compSt) {
+    assert(compSt->type == NODE_CompSt);
+    for(Node *p = compSt->child; p; p = p->sib) {
+        parse(ctx, p);
+    }
+}
+
+static void parseExtDef(CompilerContext *ctx, Node *extDef) {
+    Type *type = parseSpecifier(ctx, extDef->child);
     if(!type) {
         // TODO: report error (undefined structure)
         /* fprintf(stderr, "test"); */
-        semantic_error(17, extDef->lineno, "Undefined structure", extDef->child->child->child->sib->child->val.name);
+        semantic_error(ctx, 17, extDef->lineno, "Undefined structure", extDef->child->child->child->sib->child->val.name);
         if(extDef->child->sib->type == NODE_FunDec) {
-            parse(extDef->child->sib->sib);
+            parse(ctx, extDef->child->sib->sib);
         }
     } else if(extDef->child->sib->type == NODE_ExtDecList) {
-        parseExtDecList(type,extDef->child->sib); 
+        parseExtDecList(ctx, type,extDef->child->sib); 
     } else if(extDef->child->sib->type == NODE_FunDec) {
-        parseFunDec(type,extDef->child->sib); 
-        parse(extDef->child->sib->sib);
+        // parameters live in the same scope as the function body
+        ST_pushScope(ctx->symbolTable);
+        parseFunDec(ctx, type,extDef->child->sib); 
+        parseCompSt(ctx, extDef->child->sib->sib);
+        ST_popScope(ctx->symbolTable);
     }
 }
 
-static void parseDef(Node *def) {
-    Type *type = parseSpecifier(def->child);
+static void parseDef(CompilerContext *ctx, Node *def) {
+    Type *type = parseSpecifier(ctx, def->child);
     if(!type) {
-        semantic_error(17, def->lineno, "Undefined structure", def->child->child->child->sib->child->val.name);
+        semantic_error(ctx, 17, def->lineno, "Undefined structure", def->child->child->child->sib->child->val.name);
         /* assert(0); */
         // TODO: report error (undefined structure)
     }
     else {
-        parseDecList(type, def->child->sib);
+        parseDecList(ctx, type, def->child->sib);
     }
 }
 
-static void checkStmt(Node *stmt) {
+static void checkStmt(CompilerContext *ctx, Node *stmt) {
     Type *type = NULL;
     switch(stmt->child->type) {
         case NODE_Exp:
-            getExpType(stmt->child);
+            getExpType(ctx, stmt->child);
             break;
         case NODE_CompSt:
-            parse(stmt->child);
+            parse(ctx, stmt->child);
             break;
         case NODE_RETURN:
-            if(func && !typeEqual(getExpType(stmt->child->sib), func->u.func->retType)) {
+            if(ctx->func && !typeEqual(getExpType(ctx, stmt->child->sib), ctx->func->u.func->retType)) {
                 // TODO: return type mismatch
                 /* fprintf(stderr, "Type mismatched for return.\n"); */
-                semantic_error(8, stmt->lineno, "Type mismatched for return", NULL);
+                semantic_error(ctx, 8, stmt->lineno, "Type mismatched for return", NULL);
             }
             break;
         case NODE_IF:
         case NODE_WHILE:
-            type = getExpType(stmt->child->sib->sib);
+            type = getExpType(ctx, stmt->child->sib->sib);
             if(type && (type->kind != BASIC || type->u.basic != TYPE_INT)) {
                 // TODO: logical type error
-                semantic_error(7, stmt->child->sib->sib->lineno, "Type mismatched for operands", NULL);
+                semantic_error(ctx, 7, stmt->child->sib->sib->lineno, "Type mismatched for operands", NULL);
                 /* fprintf(stderr, "Type mismatched for logical operation.\n"); */
             }
-            checkStmt(stmt->child->sib->sib->sib->sib);
+            checkStmt(ctx, stmt->child->sib->sib->sib->sib);
             if(stmt->childno == 7) {
-                checkStmt(stmt->child->sib->sib->sib->sib->sib->sib);
+                checkStmt(ctx, stmt->child->sib->sib->sib->sib->sib->sib);
             }
             break;
         default:
@@ -150,106 +162,102 @@ static void checkStmt(Node *stmt) {
     }
 }
 
-static void initSymbolTable() {
-    assert(symbolTable == NULL);
-    symbolTable = createRB_Tree(symbolCmp);
+static void initSymbolTable(CompilerContext *ctx) {
+    assert(ctx->symbolTable == NULL);
+    ctx->symbolTable = newSymTable();
     // create primitive type node
-    intType = (Type*)malloc(sizeof(Type));
-    floatType = (Type*)malloc(sizeof(Type));
-    intType->kind = BASIC;
-    floatType->kind = BASIC;
-    intType->u.basic = TYPE_INT;
-    floatType->u.basic = TYPE_FLOAT;
+    ctx->typeArena = newArena();
+    ctx->types = newTypeTable();
+    ctx->intType = newType(ctx, BASIC);
+    ctx->floatType = newType(ctx, BASIC);
+    ctx->intType->u.basic = TYPE_INT;
+    ctx->floatType->u.basic = TYPE_FLOAT;
+    completeType(ctx, ctx->intType);
+    completeType(ctx, ctx->floatType);
     /* return createRB_Tree(symbolCmp); */
 }
 
-static int symbolCmp(Symbol *symbol1, Symbol *symbol2) {
-    int r = strcmp(symbol1->name, symbol2->name);
-    if(r == 0) {
-        r = symbol1->kind - symbol2->kind;
-    }
-    /* printf("compare %s : %s, result = %d\n", symbol1->name, symbol2->name, r); */
-    return r;
-}
-
-void clearSymbolTable() {
+void clearSymbolTable(CompilerContext *ctx) {
     /* printf("symbol table size = %d\n", symbolTable->size); */
-    clearRB_Tree(symbolTable, freeSymbol);
-    free(symbolTable);
-    symbolTable = NULL;
-    free(intType);
-    free(floatType);
-    intType = NULL;
-    floatType = NULL;
-}
-
-Symbol* lookupSymbol(const char *name, SymbolKind kind) {
+    ST_clear(ctx->symbolTable, freeSymbol);
+    ctx->symbolTable = NULL;
+    ctx->intType = NULL;
+    ctx->floatType = NULL;
+    AR_clear(ctx->typeArena);
+    free(ctx->typeArena);
+    ctx->typeArena = NULL;
+    TT_clear(ctx->types);
+    ctx->types = NULL;
+}
+
+Symbol* lookupSymbol(CompilerContext *ctx, Atom name, SymbolKind kind) {
     /* printf("lookup symbol: %s, kind: %d\n", name, kind); */
-    Symbol symbol = { .kind = kind };
-    strcpy(symbol.name, name);
-    return RB_find(symbolTable, &symbol);
+    return ST_find(ctx->symbolTable, name, kind);
 }
 
-static bool insertSymbol(Symbol *symbol) {
+static bool insertSymbol(CompilerContext *ctx, Symbol *symbol) {
     /* printf("insert symbol: %s, kind: %d\n", symbol->name, symbol->kind); */
-    return RB_insert(symbolTable, symbol);
+    // variables belong to the current scope, functions and structures are global
+    return ST_insert(ctx->symbolTable, symbol, symbol->kind != SYM_VAR);
 }
 
-static Type* parseSpecifier(Node *specifier) {
+static Type* parseSpecifier(CompilerContext *ctx, Node *specifier) {
     assert(specifier->type == NODE_Specifier);
     // basic type
     if(specifier->child->type == NODE_TYPE) {
         if(strcmp(specifier->child->val.name, "int") == 0) {
-            return intType;
+            return ctx->intType;
         } else if(strcmp(specifier->child->val.name, "float") == 0) {
-            return floatType;
+            return ctx->floatType;
         } else {
             assert(0);
         }
     }
     assert(specifier->child->type == NODE_StructSpecifier);
-    return parseStructSpecifier(specifier->child);
+    return parseStructSpecifier(ctx, specifier->child);
 }
 
-static Type* parseStructSpecifier(Node *structSpecifier) {
+static Type* parseStructSpecifier(CompilerContext *ctx, Node *structSpecifier) {
     assert(structSpecifier->type == NODE_StructSpecifier);
     // struct tag
     if(structSpecifier->childno == 2) {
         Node *tag = structSpecifier->child->sib;
-        Symbol *symbol = lookupSymbol(tag->child->val.name, SYM_STRUCT);
+        Symbol *symbol = lookupSymbol(ctx, tag->child->val.name, SYM_STRUCT);
         return symbol == NULL ? NULL : symbol->u.type;
     }
     // struct opttag lc deflist rc
     assert(structSpecifier->childno == 5);
-    Type *type = (Type*)malloc(sizeof(Type));
-    type->kind = STRUCTURE;
+    Type *type = newType(ctx, STRUCTURE);
     Node *optTag = structSpecifier->child->sib;
     Node *defList = optTag->sib->sib;
     assert(optTag->type == NODE_OptTag);
     assert(defList->type == NODE_DefList);
     /* type->u.structure = buildFields(defList); */
     type->u.structure = NULL;
-    type->u.structure = buildFields(type->u.structure, defList);
+    type->u.structure = buildFields(ctx, type->u.structure, defList);
+    completeType(ctx, type);
     // non anonymous structure
     Symbol *symbol = (Symbol*)malloc(sizeof(Symbol));
     symbol->kind = SYM_STRUCT;
     if(optTag->child != NULL) {
-        strcpy(symbol->name, optTag->child->val.name);
+        symbol->name = optTag->child->val.name;
     } else {
-        sprintf(symbol->name, "%d", alloc_id++);
+        char name[16];
+        sprintf(name, "%d", ctx->alloc_id++);
+        symbol->name = AT_internStr(ctx->atoms, name);
     }
     symbol->u.type = type;
     // insert failed
-    if(!insertSymbol(symbol)) {
-        semantic_error(16, optTag->lineno, "Duplicated name", symbol->name);
+    if(!insertSymbol(ctx, symbol)) {
+        semantic_error(ctx, 16, optTag->lineno, "Duplicated name", symbol->name);
         free(symbol);
-    } else if(lookupSymbol(symbol->name, SYM_VAR)) {    // check id
-        semantic_error(16, optTag->lineno, "Struct id duplicated with normal id", symbol->name);
+    } else if(lookupSymbol(ctx, symbol->name, SYM_VAR)) {    // check id
+        semantic_error(ctx, 16, optTag->lineno, "Struct id duplicated with normal id", symbol->name);
     }
     return type;
 }
 
-static FieldList* buildFields(FieldList *fieldList, Node *defList) {
+static FieldList* buildFields(CompilerContext *ctx, FieldList *fieldList, Node *defList) {
     assert(defList->type == NODE_DefList);
     // empty production
     if(!defList->child) {
@@ -258,25 +266,25 @@ static FieldList* buildFields(FieldList *fieldList, Node *defList) {
     Node *def = defList->child;
     Node *specifier = def->child;
     Node *decList = specifier->sib;
-    Type *type = parseSpecifier(specifier);
+    Type *type = parseSpecifier(ctx, specifier);
     if(type) {
         while(true) {
            Node *dec = decList->child;
 
-           Symbol *symbol = getVarSymbol(type, dec->child);
-           FieldList *field = (FieldList*)malloc(sizeof(FieldList));
+           Symbol *symbol = getVarSymbol(ctx, type, dec->child);
+           FieldList *field = (FieldList*)AR_alloc(ctx->typeArena, sizeof(FieldList));
            field->next = NULL;
-           strcpy(field->name, symbol->name);
+           field->name = symbol->name;
            field->type = symbol->u.type;
            // tail insert
            if(!fieldList) {
                 fieldList = field;
            } else if(!addField(fieldList, field)){
                 // TODO: field duplicated with other variables
-               semantic_error(15, dec->child->lineno, "Redefined field", symbol->name);
+               semantic_error(ctx, 15, dec->child->lineno, "Redefined field", symbol->name);
            }
            if(dec->childno == 3) {
-               semantic_error(15, dec->child->lineno, "Illegal initialization of structure field", NULL);
+               semantic_error(ctx, 15, dec->child->lineno, "Illegal initialization of structure field", NULL);
            }
            free(symbol);
 
@@ -305,9 +313,9 @@ static FieldList* buildFields(FieldList *fieldList, Node *defList) {
            decList = dec->sib->sib; // dec comma declist
         }
     } else {
-        semantic_error(17, specifier->lineno, "Undefined structure", specifier->child->child->sib->child->val.name);
+        semantic_error(ctx, 17, specifier->lineno, "Undefined structure", specifier->child->child->sib->child->val.name);
     }
-    return buildFields(fieldList, def->sib);
+    return buildFields(ctx, fieldList, def->sib);
 }
 
 bool addField(FieldList *structure, FieldList *field) {
@@ -315,7 +323,7 @@ bool addField(FieldList *structure, FieldList *field) {
     assert(!field->next);
     FieldList *iter = structure;
     while(true) {
-        if(strcmp(iter->name, field->name) == 0) {
+        if(iter->name == field->name) {
             return false;
         }
         if(!iter->next) {
@@ -328,7 +336,7 @@ bool addField(FieldList *structure, FieldList *field) {
     return true;
 }
 
-static ArgList* buildArgs(Node *varList) {
+static ArgList* buildArgs(CompilerContext *ctx, Node *varList) {
     assert(varList->type == NODE_VarList);
     ArgList *argList = NULL;
     ArgList *tail = NULL;
@@ -336,17 +344,20 @@ static ArgList* buildArgs(Node *varList) {
         Node *paramDec = varList->child;
         Node *specifier = paramDec->child;
         Node *varDec = specifier->sib;
-        Type *type = parseSpecifier(specifier);
+        Type *type = parseSpecifier(ctx, specifier);
         if(type) {
-            Symbol *symbol = getVarSymbol(type, varDec);
-            if(!insertSymbol(symbol)) {
+            Symbol *symbol = getVarSymbol(ctx, type, varDec);
+            if(!insertSymbol(ctx, symbol)) {
                 // TODO: report error
-                semantic_error(3, varDec->lineno, "Redefined variable", symbol->name);
+                semantic_error(ctx, 3, varDec->lineno, "Redefined variable", symbol->name);
                 free(symbol);
                 /* assert(0); */
                 // function parameter duplicated with other global vars
-            } else if(lookupSymbol(symbol->name, SYM_STRUCT)) {
-                semantic_error(3, varDec->lineno, "Variable duplicated with struct id", symbol->name);
+            } else {
+                varDec->val.sym = symbol;
+                if(lookupSymbol(ctx, symbol->name, SYM_STRUCT)) {
+                    semantic_error(ctx, 3, varDec->lineno, "Variable duplicated with struct id", symbol->name);
+                }
             }
             ArgList *arg = (ArgList*)malloc(sizeof(ArgList));
             arg->next = NULL;
@@ -359,7 +370,7 @@ static ArgList* buildArgs(Node *varList) {
                 tail = arg;
             }
         } else {
-            semantic_error(17, specifier->lineno, "Undefined structure", specifier->child->child->sib->child->val.name);
+            semantic_error(ctx, 17, specifier->lineno, "Undefined structure", specifier->child->child->sib->child->val.name);
         }
         if(!paramDec->sib) break;
         varList = paramDec->sib->sib;
@@ -367,53 +378,96 @@ static ArgList* buildArgs(Node *varList) {
     return argList;
 }
 
-static Symbol* getVarSymbol(Type *type, Node *varDec) {
+static Symbol* getVarSymbol(CompilerContext *ctx, Type *type, Node *varDec) {
     /* printf("test\n"); */
     Symbol *symbol = (Symbol*)malloc(sizeof(Symbol));
     symbol->kind = SYM_VAR;
     // primitive type
     if(varDec->childno == 1) {
-        strcpy(symbol->name, varDec->child->val.name); 
+        symbol->name = varDec->child->val.name;
         symbol->u.type = type;
     } else {    // array
         Type *prev = type;
         while(varDec->childno == 4) {
-            Type *cur = (Type*)malloc(sizeof(Type));
-            cur->kind = ARRAY;
+            Type *cur = newType(ctx, ARRAY);
             cur->u.array.elem = prev;
             cur->u.array.size = varDec->child->sib->sib->val.intVal;
+            completeType(ctx, cur);
             prev = cur;
             varDec = varDec->child;
         }
-        strcpy(symbol->name, varDec->child->val.name);
+        symbol->name = varDec->child->val.name;
         symbol->u.type = prev;
     }
     return symbol;
 }
 
-static Symbol* getFunSymbol(Type *retType, Node *funDec) {
+static Symbol* getFunSymbol(CompilerContext *ctx, Type *retType, Node *funDec) {
     Symbol* symbol = (Symbol*)malloc(sizeof(Symbol));
     symbol->kind = SYM_FUNC;
-    strcpy(symbol->name, funDec->child->val.name);
+    symbol->name = funDec->child->val.name;
     symbol->u.func = (Func*)malloc(sizeof(Func));
     symbol->u.func->retType = retType;
     symbol->u.func->argList = NULL;
     if(funDec->childno == 4) {
-        symbol->u.func->argList = buildArgs(funDec->child->sib->sib);
+        symbol->u.func->argList = buildArgs(ctx, funDec->child->sib->sib);
     }
     return symbol;
 }
 
-static FieldList* getField(FieldList *structure, const char *name) {
-    FieldList *iter = structure;
-    while(iter) {
-        if(strcmp(iter->name, name) == 0) break;
-        iter = iter->next;
+// open addressing on the field atom, at most half full
+static void buildFieldIndex(CompilerContext *ctx, Type *structure) {
+    unsigned capacity = 4;
+    int cnt = 0;
+    for(FieldList *field = structure->u.structure; field; field = field->next) {
+        field->index = cnt++;
     }
-    return iter;
+    while(capacity < 2 * (unsigned)cnt) {
+        capacity *= 2;
+    }
+    structure->fieldMask = capacity - 1;
+    structure->fieldIndex = (FieldList**)AR_alloc(ctx->typeArena, sizeof(FieldList*) * capacity);
+    memset(structure->fieldIndex, 0, sizeof(FieldList*) * capacity);
+    for(FieldList *field = structure->u.structure; field; field = field->next) {
+        unsigned i = ((uintptr_t)field->name >> 3) & structure->fieldMask;
+        while(structure->fieldIndex[i]) {
+            i = (i + 1) & structure->fieldMask;
+        }
+        structure->fieldIndex[i] = field;
+    }
+}
+
+FieldList* getField(Type *structure, Atom name) {
+    assert(structure->kind == STRUCTURE);
+    unsigned i = ((uintptr_t)name >> 3) & structure->fieldMask;
+    FieldList *field;
+    while((field = structure->fieldIndex[i])) {
+        if(field->name == name) break;
+        i = (i + 1) & structure->fieldMask;
+    }
+    return field;
+}
+
+// types are only cached on success, a failed expression is checked
+// (and reported) again like before
+Type* getExpType(CompilerContext *ctx, Node *exp) {
+    Type *type = NULL;
+    if(exp->child->type == NODE_ID) {
+        Symbol *symbol = exp->val.sym;
+        if(symbol) {
+            return exp->childno == 1 ? symbol->u.type : symbol->u.func->retType;
+        }
+        return evalExpType(ctx, exp);
+    }
+    if(exp->val.type) {
+        return exp->val.type;
+    }
+    type = evalExpType(ctx, exp);
+    exp->val.type = type;
+    return type;
 }
 
-Type* getExpType(Node *exp) {
+static Type* evalExpType(CompilerContext *ctx, Node *exp) {
     Node *first = exp->child;
     Type *subType = NULL;
     Symbol *symbol = NULL;
@@ -421,79 +475,81 @@ Type* getExpType(Node *exp) {
     if(exp->childno == 1) {
         switch(first->type) {
             case NODE_ID:
-                symbol = lookupSymbol(first->val.name, SYM_VAR);
+                symbol = lookupSymbol(ctx, first->val.name, SYM_VAR);
                 if(!symbol) {
                     // TODO: undefined id 
                     /* assert(0); */
-                    semantic_error(1, first->lineno, "Undefined variable", first->val.name);
+                    semantic_error(ctx, 1, first->lineno, "Undefined variable", first->val.name);
                     return NULL;
                 }
+                exp->val.sym = symbol;
                 return symbol->u.type;
             case NODE_INT:
-                return intType;
+                return ctx->intType;
             case NODE_FLOAT:
-                return floatType;
+                return ctx->floatType;
             default:
                 assert(0);
         }
     }
     switch(first->type) {
         case NODE_LP:
-            return getExpType(first->sib);
+            return getExpType(ctx, first->sib);
             break;
         case NODE_MINUS:
             /* assert(exp->childno == 2); */
-            subType = getExpType(first->sib);
+            subType = getExpType(ctx, first->sib);
             if(subType && subType->kind != BASIC) {
-                semantic_error(7, exp->lineno, "Type mismatched for operands", NULL);
+                semantic_error(ctx, 7, exp->lineno, "Type mismatched for operands", NULL);
                 /* assert(0); */
                 return NULL;
             }
             return subType;
             break;
         case NODE_NOT:
-            subType = getExpType(first->sib);
+            subType = getExpType(ctx, first->sib);
             if(subType && (subType->kind != BASIC || subType->u.basic != TYPE_INT)) {
                 // TODO: type miss match for logical operator
-                semantic_error(7, exp->lineno, "Type mismatched for operands", NULL);
+                semantic_error(ctx, 7, exp->lineno, "Type mismatched for operands", NULL);
                 return NULL;
             }
             return subType;
             break;
         case NODE_ID:   // function call
             /* printf("%s\n", first->val.name); */
-            symbol = lookupSymbol(first->val.name, SYM_FUNC);
+            symbol = lookupSymbol(ctx, first->val.name, SYM_FUNC);
             if(!symbol) {
                 // TODO: undefined function name
                 /* assert(0); */
-                if(lookupSymbol(first->val.name, SYM_VAR)) {
-                    semantic_error(11, first->lineno, "It is not a function", first->val.name);
+                if(lookupSymbol(ctx, first->val.name, SYM_VAR)) {
+                    semantic_error(ctx, 11, first->lineno, "It is not a function", first->val.name);
                     return NULL;
                 }
-                semantic_error(2, first->lineno, "Undefined function", first->val.name);
+                semantic_error(ctx, 2, first->lineno, "Undefined function", first->val.name);
                 return NULL;
             }
             if(exp->childno == 3) {
-                if(!checkArgs(symbol->u.func->argList, NULL)) {
+                if(!checkArgs(ctx, symbol->u.func->argList, NULL)) {
                     // TODO: arguments mismatch
                     /* assert(0); */
-                    semantic_error(9, exp->lineno, "Function arguments not applicable", NULL);
+                    semantic_error(ctx, 9, exp->lineno, "Function arguments not applicable", NULL);
                     return NULL;
                 }
             } else if(exp->childno == 4) {
-                if(!checkArgs(symbol->u.func->argList, first->sib->sib)) {
+                if(!checkArgs(ctx, symbol->u.func->argList, first->sib->sib)) {
                     // TODO: arguments mismatch
                     /* assert(0); */
-                    semantic_error(9, exp->lineno, "Function arguments not applicable", NULL);
+                    semantic_error(ctx, 9, exp->lineno, "Function arguments not applicable", NULL);
                     return NULL;
                 }
             } else {
                 assert(0);
             }
+            exp->val.sym = symbol;
             return symbol->u.func->retType;
             break;
         case NODE_Exp:
-            return getComplexExpType(exp);
+            return getComplexExpType(ctx, exp);
             break;
         default:
             assert(0);
@@ -501,7 +557,7 @@ Type* getExpType(Node *exp) {
     return NULL;
 }
 
-static Type* getComplexExpType(Node *exp) {
+static Type* getComplexExpType(CompilerContext *ctx, Node *exp) {
     assert(exp->child->type == NODE_Exp);
     FieldList *field = NULL;
     Type *type = NULL;
@@ -509,14 +565,14 @@ static Type* getComplexExpType(Node *exp) {
     Type *second = NULL;
     switch(exp->child->sib->type) {
         case NODE_ASSIGNOP:
-            first = getExpType(exp->child);
-            second = getExpType(exp->child->sib->sib);
+            first = getExpType(ctx, exp->child);
+            second = getExpType(ctx, exp->child->sib->sib);
             if(!isLeftVal(exp->child)) {
                 /* assert(0); */
-                semantic_error(6, exp->lineno, "The left-hand side of an assignment must be a variable", NULL);
+                semantic_error(ctx, 6, exp->lineno, "The left-hand side of an assignment must be a variable", NULL);
                 return NULL;
             } else if(!typeEqual(first, second)) {
-                semantic_error(5, exp->lineno, "Type mismatched for assignment", NULL);
+                semantic_error(ctx, 5, exp->lineno, "Type mismatched for assignment", NULL);
                 /* assert(0); */
                 return NULL;
             }
@@ -524,66 +580,66 @@ static Type* getComplexExpType(Node *exp) {
             break;
         case NODE_AND:  // int
         case NODE_OR:
-            first = getExpType(exp->child);
-            second = getExpType(exp->child->sib->sib);
+            first = getExpType(ctx, exp->child);
+            second = getExpType(ctx, exp->child->sib->sib);
             if(!first || !second) {
                 return NULL;
             }
             if(!typeEqual(first, second) || first->kind != BASIC || first->u.basic != TYPE_INT) {
             /* if(first->kind != second->kind || first->kind != BASIC || first->u.basic != second->u.basic || first->u.basic != TYPE_INT) { */
                 // TODO: logical operand error: not int
-                semantic_error(7, exp->lineno, "Type mismatched for operands", NULL);
+                semantic_error(ctx, 7, exp->lineno, "Type mismatched for operands", NULL);
                 /* assert(0); */
                 return NULL;
             }
             return first;
             break;
         case NODE_RELOP:    // primitive types, return int
-            first = getExpType(exp->child);
-            second = getExpType(exp->child->sib->sib);
+            first = getExpType(ctx, exp->child);
+            second = getExpType(ctx, exp->child->sib->sib);
             if(!first || !second) {
                 return NULL;
             }
             if(!typeEqual(first, second) || first->kind != BASIC) {
-                semantic_error(7, exp->lineno, "Type mismatched for operands", NULL);
+                semantic_error(ctx, 7, exp->lineno, "Type mismatched for operands", NULL);
                 /* assert(0); */
                 return NULL;
             }
-            return intType;
+            return ctx->intType;
             break;
         case NODE_PLUS: // primitive types
         case NODE_MINUS:
         case NODE_STAR:
         case NODE_DIV:
-            first = getExpType(exp->child);
-            second = getExpType(exp->child->sib->sib);
+            first = getExpType(ctx, exp->child);
+            second = getExpType(ctx, exp->child->sib->sib);
             if(!first || !second) {
                 return NULL;
             }
             if(!typeEqual(first, second) || first->kind != BASIC) {
-                semantic_error(7, exp->lineno, "Type mismatched for operands", NULL);
+                semantic_error(ctx, 7, exp->lineno, "Type mismatched for operands", NULL);
                 /* assert(0); */
                 return NULL;
             }
             return first;
             break;
         case NODE_LB:   // array use
-            first = getExpType(exp->child);
-            second = getExpType(exp->child->sib->sib);
+            first = getExpType(ctx, exp->child);
+            second = getExpType(ctx, exp->child->sib->sib);
             if(!first || !second) {
                 return NULL;
             }
             if(first->kind != ARRAY) {
                 // TODO: not an array
-                semantic_error(10, exp->child->lineno, "It is not an array", NULL);
+                semantic_error(ctx, 10, exp->child->lineno, "It is not an array", NULL);
                 /* fprintf(stderr, "%d, %d\n", second->kind, second->u.basic); */
                 if(second->kind != BASIC || second->u.basic != TYPE_INT) {
-                    semantic_error(12, exp->child->sib->sib->lineno, "Array index is not an integer", NULL);
+                    semantic_error(ctx, 12, exp->child->sib->sib->lineno, "Array index is not an integer", NULL);
                 }
                 return NULL;
             }
             if(second->kind != BASIC || second->u.basic != TYPE_INT) {
-                semantic_error(12, exp->child->sib->sib->lineno, "Array index is not an integer", NULL);
+                semantic_error(ctx, 12, exp->child->sib->sib->lineno, "Array index is not an integer", NULL);
                 // TODO: not a integer
                 /* assert(0); */
                 return NULL;
@@ -591,21 +647,21 @@ static Type* getComplexExpType(Node *exp) {
             return first->u.array.elem;
             break;
         case NODE_DOT:  // structure use
-            first = getExpType(exp->child);
+            first = getExpType(ctx, exp->child);
             if(!first) {
                 return NULL;
             }
             if(first->kind != STRUCTURE) {
                 // TODO: not a struture
                 /* assert(0); */
-                semantic_error(13, exp->lineno, "Illegal use of \".\"", NULL);
+                semantic_error(ctx, 13, exp->lineno, "Illegal use of \".\"", NULL);
                 return NULL;
             }
-            field = getField(first->u.structure, exp->child->sib->sib->val.name);
+            field = getField(first, exp->child->sib->sib->val.name);
             if(!field) {
                 // TODO: field not found
                 /* assert(0); */
-                semantic_error(14, exp->lineno, "Non-existent field", exp->child->sib->sib->val.name);
+                semantic_error(ctx, 14, exp->lineno, "Non-existent field", exp->child->sib->sib->val.name);
                 return NULL;
             }
             return field->type;
@@ -615,82 +671,112 @@ static Type* getComplexExpType(Node *exp) {
     return type;
 }
 
-static void parseExtDecList(Type *type, Node *extDecList) {
-    Symbol *symbol = getVarSymbol(type, extDecList->child);
-    if(!insertSymbol(symbol)) {
-        semantic_error(3, extDecList->lineno, "Redefined variable", symbol->name);
+static void parseExtDecList(CompilerContext *ctx, Type *type, Node *extDecList) {
+    Symbol *symbol = getVarSymbol(ctx, type, extDecList->child);
+    if(!insertSymbol(ctx, symbol)) {
+        semantic_error(ctx, 3, extDecList->lineno, "Redefined variable", symbol->name);
         free(symbol);
         /* free(symbol); */
         // TODO: report error
         // global variable redefined
-    } else if(lookupSymbol(symbol->name, SYM_STRUCT)) {
-        semantic_error(3, extDecList->lineno, "Variable duplicated with struct id", symbol->name);
+    } else {
+        extDecList->child->val.sym = symbol;
+        if(lookupSymbol(ctx, symbol->name, SYM_STRUCT)) {
+            semantic_error(ctx, 3, extDecList->lineno, "Variable duplicated with struct id", symbol->name);
+        }
     }
-    if(extDecList->childno == 3) parseExtDecList(type, extDecList->child->sib->sib);
+    if(extDecList->childno == 3) parseExtDecList(ctx, type, extDecList->child->sib->sib);
 }
 
-static void parseDecList(Type *type, Node *decList) {
+static void parseDecList(CompilerContext *ctx, Type *type, Node *decList) {
     Node *dec = decList->child;
-    Symbol *symbol = getVarSymbol(type, dec->child);
+    Symbol *symbol = getVarSymbol(ctx, type, dec->child);
     /* printf("%s\n", symbol->name); */
-    if(dec->childno == 3 && !typeEqual(symbol->u.type, getExpType(dec->child->sib->sib))) {
-        semantic_error(5, dec->lineno, "Type mismatched for assignment", symbol->name);
+    if(dec->childno == 3 && !typeEqual(symbol->u.type, getExpType(ctx, dec->child->sib->sib))) {
+        semantic_error(ctx, 5, dec->lineno, "Type mismatched for assignment", symbol->name);
         // TODO: report error
         // type dismatch
-    } else if(!insertSymbol(symbol)) {
-        semantic_error(3, decList->lineno, "Redefined variable", symbol->name);
+    } else if(!insertSymbol(ctx, symbol)) {
+        semantic_error(ctx, 3, decList->lineno, "Redefined variable", symbol->name);
         free(symbol);
         /* free(symbol); */
         /* assert(0); */
         // TODO: report error
         // local variable redefined
-    } else if(lookupSymbol(symbol->name, SYM_STRUCT)) {
-        semantic_error(3, decList->lineno, "Variable duplicated with struct id", symbol->name);
+    } else {
+        dec->child->val.sym = symbol;
+        if(lookupSymbol(ctx, symbol->name, SYM_STRUCT)) {
+            semantic_error(ctx, 3, decList->lineno, "Variable duplicated with struct id", symbol->name);
+        }
     }
-    if(decList->childno == 3) parseDecList(type, dec->sib->sib);
+    if(decList->childno == 3) parseDecList(ctx, type, dec->sib->sib);
 }
 
-static void parseFunDec(Type *type, Node *funDec) {
-    Symbol *symbol = getFunSymbol(type, funDec);
+static void parseFunDec(CompilerContext *ctx, Type *type, Node *funDec) {
+    Symbol *symbol = getFunSymbol(ctx, type, funDec);
     /* printf("%s\n", symbol->name); */
-    if(!insertSymbol(symbol)) {
-        semantic_error(4, funDec->lineno, "Redefined function", symbol->name);
+    if(!insertSymbol(ctx, symbol)) {
+        semantic_error(ctx, 4, funDec->lineno, "Redefined function", symbol->name);
         /* free(symbol); */
         /* assert(0); */
         // TODO: report error
         // function name redefined
         /* func = NULL; */
+    } else {
+        funDec->val.sym = symbol;
     }
-    func = symbol;
+    ctx->func = symbol;
 }
-static bool structEqual(FieldList *st1, FieldList *st2) {
-    if(st1 == NULL && st2 == NULL) return true;
-    if(st1 == NULL || st2 == NULL) return false;
-    if(!typeEqual(st1->type, st2->type)) return false;
-    return structEqual(st1->next, st2->next);
+// types live until clearSymbolTable, they are shared between symbols
+static Type* newType(CompilerContext *ctx, TypeKind kind) {
+    Type *type = (Type*)AR_alloc(ctx->typeArena, sizeof(Type));
+    memset(type, 0, sizeof(Type));
+    type->kind = kind;
+    return type;
+}
+
+// layout and equivalence class, the components must be complete already
+static void completeType(CompilerContext *ctx, Type *type) {
+    switch(type->kind) {
+        case BASIC:
+            type->size = type->align = 4;
+            break;
+        case ARRAY:
+            type->size = type->u.array.size * type->u.array.elem->size;
+            type->align = type->u.array.elem->align;
+            break;
+        case STRUCTURE:
+            type->size = 0;
+            type->align = 1;
+            for(FieldList *field = type->u.structure; field; field = field->next) {
+                int align = field->type->align;
+                field->offset = (type->size + align - 1) / align * align;
+                type->size = field->offset + field->type->size;
+                if(align > type->align) type->align = align;
+            }
+            type->size = (type->size + type->align - 1) / type->align * type->align;
+            buildFieldIndex(ctx, type);
+            break;
+    }
+    type->canon = TT_canon(ctx->types, type);
 }
 
 static bool typeEqual(Type *t1, Type *t2) {
     /* if(t1 == NULL && t2 == NULL) return true; */
     /* if(t1 == NULL || t2 == NULL) return false; */
     if(t1 == NULL || t2 == NULL) return true;   // avoid chain errors
-    if(t1->kind != t2->kind) return false;
-    if(t1->kind == BASIC) return t1->u.basic == t2->u.basic;
-    if(t1->kind == STRUCTURE) return structEqual(t1->u.structure, t2->u.structure);
-    if(t1->kind == ARRAY) return typeEqual(t1->u.array.elem, t2->u.array.elem);
-    assert(0);
-    return true;
+    return t1->canon == t2->canon;
 }
 
-static bool checkArgs(ArgList *argList, Node *args) {
+static bool checkArgs(CompilerContext *ctx, ArgList *argList, Node *args) {
     if(argList == NULL && args == NULL) return true;
     if(argList == NULL || args == NULL) return false;
-    if(typeEqual(argList->type, getExpType(args->child))) {
+    if(typeEqual(argList->type, getExpType(ctx, args->child))) {
         if(args->childno == 1) {
             return argList->next == NULL;
         }
         assert(args->childno == 3);
-        return checkArgs(argList->next, args->child->sib->sib);
+        return checkArgs(ctx, argList->next, args->child->sib->sib);
     }
     return false;
 }
@@ -707,83 +793,65 @@ static bool isLeftVal(Node *exp) {
     }
 }
 
-static void printSymbolTable() {
-    assert(symbolTable != NULL);
-    RB_Iterator *iter = iterator(symbolTable);
-    while(hasNext(iter)) {
-        Symbol *symbol = nextNode(iter);
+static void printSymbolTable(CompilerContext *ctx) {
+    assert(ctx->symbolTable != NULL);
+    for(int i = 0; i < ctx->symbolTable->capacity; i++) {
+        Symbol *symbol = ctx->symbolTable->slots[i].sym;
+        if(!symbol || !symbol->name) continue;  // empty or deleted
         printf("kind = %d, name = %s\n", symbol->kind, symbol->name);
     }
 }
 
-static void semantic_error(int errType, int lineno, const char* desc, const char* text) {
-    semerr++;
+static void semantic_error(CompilerContext *ctx, int errType, int lineno, const char* desc, const char* text) {
+    ctx->semerr++;
+    addDiagnostic(ctx, CMM_SEMANTIC, errType, lineno, 0, desc, text);
+    if(!ctx->errStream) {
+        return;
+    }
     if(text) {
-        fprintf(stderr, "\033[31mError type %d at line %d: %s \"%s\".\n\033[0m", 
+        fprintf(ctx->errStream, "\033[31mError type %d at line %d: %s \"%s\".\n\033[0m", 
                errType, lineno, desc, text);
     } else {
-        fprintf(stderr, "\033[31mError type %d at line %d: %s.\n\033[0m", 
+        fprintf(ctx->errStream, "\033[31mError type %d at line %d: %s.\n\033[0m", 
                errType, lineno, desc);
     }
 }
 
-static void addBuiltInFuns() {
+static void addBuiltInFuns(CompilerContext *ctx) {
     // generate read function : return type is int, argument list is null
     Symbol *read = (Symbol*)malloc(sizeof(Symbol));
     read->kind = SYM_FUNC;
-    strcpy(read->name, "read");
+    read->name = AT_internStr(ctx->atoms, "read");
     read->u.func = (Func*)malloc(sizeof(Func));
-    read->u.func->retType = intType;
+    read->u.func->retType = ctx->intType;
     read->u.func->argList = NULL;
     
     // generate write function : return type is int, argument list is single int
     Symbol *write = (Symbol*)malloc(sizeof(Symbol));
     write->kind = SYM_FUNC;
-    strcpy(write->name, "write");
+    write->name = AT_internStr(ctx->atoms, "write");
     write->u.func = (Func*)malloc(sizeof(Func));
-    write->u.func->retType = intType;
+    write->u.func->retType = ctx->intType;
     ArgList *argList = (ArgList*)malloc(sizeof(ArgList));
     argList->next = NULL;
-    argList->type = intType;
+    argList->type = ctx->intType;
     write->u.func->argList = argList;
 
     // insert read and write into symbol table
-    assert(insertSymbol(read));
-    assert(insertSymbol(write));
+    assert(insertSymbol(ctx, read));
+    assert(insertSymbol(ctx, write));
 }
 
 
 static void freeSymbol(Symbol *sym) {
     if(!sym) return;
-    switch(sym->kind) {
-        case SYM_VAR:
-            freeVar(sym);
-            break;
-        case SYM_FUNC:
-            freeFun(sym);
-            break;
-        case SYM_STRUCT:
-            freeStruct(sym);
-            break;
+    // types of variables and structures belong to typeArena
+    if(sym->kind == SYM_FUNC) {
+        freeFun(sym);
     }
     free(sym);
 }
 
-// free arraylist(linked list) if type is array
-static void freeVar(Symbol *var) {
-    /* printf("free var\n"); */
-    assert(var);
-    assert(var->kind == SYM_VAR);
-    Type *type = var->u.type;
-    while(type->kind == ARRAY) {
-        Type *p = type;
-        type = type->u.array.elem;
-        free(p);
-    }
-    /* free(type); */
-    return;
-}
-
 // free arglist(linked list) and func struct
 static void freeFun(Symbol *fun) {
     /* printf("free func\n"); */
@@ -798,24 +866,3 @@ static void freeFun(Symbol *fun) {
     }
     free(func);
 }
-
-// free struture list(linked list)
-static void freeStruct(Symbol *structure) {
-    /* printf("free struct\n"); */
-    assert(structure);
-    assert(structure->kind == SYM_STRUCT);
-    Type *type = structure->u.type;
-    assert(type->kind == STRUCTURE);
-    FieldList *field = type->u.structure;
-    while(field) {
-        FieldList *p = field;
-        field = field->next;
-        while(p->type->kind == ARRAY) {
-            type = p->type;
-            p->type = type->u.array.elem;
-            free(type);
-        }
-        free(p);
-    }
-    free(structure->u.type);
-}
@@ -2,13 +2,9 @@
 #define __SEMANTIC_H__
 
 #include "Node.h"
-#include "rb_tree.h"
 #include <string.h>
 #include "common.h"
 
-#define MAX_NAME_SIZE 256
-extern int semerr;
-
 typedef struct Type Type;
 typedef struct FieldList FieldList;
 typedef struct ArgList ArgList;
@@ -32,11 +28,18 @@ struct Type {
         } array;
         FieldList *structure;
     } u;
+    int size;   // bytes, computed once the type is complete
+    int align;
+    Type *canon;    // hash-consed equivalence class, typeEqual compares these
+    FieldList **fieldIndex; // structure: fields hashed by name, see getField
+    unsigned fieldMask;
 };
 
 struct FieldList {  // structure field
     Type *type;
-    char name[MAX_NAME_SIZE];
+    Atom name;
+    int index;  // position in the structure
+    int offset; // byte offset in the structure
     FieldList *next;
 };
 
@@ -52,15 +55,16 @@ struct Func {
 
 struct Symbol {
     SymbolKind kind;    // variable / function / structure
-    char name[MAX_NAME_SIZE];
+    Atom name;
     union {
         Type *type; // variable and structure
         Func *func; // function
     } u;
 };
 
-void semantic_parse(Node *root);
-Symbol* lookupSymbol(const char*name, SymbolKind kind);
-Type* getExpType(Node *exp);    // for struct and array use
-void clearSymbolTable();
+void semantic_parse(CompilerContext *ctx, Node *root);
+Symbol* lookupSymbol(CompilerContext *ctx, Atom name, SymbolKind kind);
+Type* getExpType(CompilerContext *ctx, Node *exp);
+FieldList* getField(Type *structure, Atom name);    // cached on the node once semantic_parse has seen it
+void clearSymbolTable(CompilerContext *ctx);
 #endif
@@ -0,0 +1,132 @@
+#define _DEFAULT_SOURCE
+#include "source.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static bool mapSource(Source *self, int fd);
+static bool readSource(Source *self, int fd);
+static void buildLineIndex(Source *self);
+
+Source* openSource(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+    Source *src = (Source*)malloc(sizeof(Source));
+    memset(src, 0, sizeof(Source));
+    if(!mapSource(src, fd) && !readSource(src, fd)) {
+        free(src);
+        src = NULL;
+    }
+    close(fd);
+    return src;
+}
+
+// reserve size+2 zeroed bytes and map the file over the front of them,
+// the bytes behind the end of file are the two '\0' flex needs
+static bool mapSource(Source *self, int fd) {
+    struct stat st;
+    if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        return false;
+    }
+    size_t size = st.st_size;
+    size_t mapped = size + 2;
+    char *base = (char*)mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) {
+        return false;
+    }
+    if(mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped);
+        return false;
+    }
+    self->buf = base;
+    self->size = size;
+    self->mapped = mapped;
+    return true;
+}
+
+// fallback for pipes and empty files
+static bool readSource(Source *self, int fd) {
+    size_t cap = 4096, size = 0;
+    char *buf = (char*)malloc(cap);
+    ssize_t n;
+    while((n = read(fd, buf + size, cap - size - 2)) > 0) {
+        size += n;
+        if(cap - size - 2 == 0) {
+            cap *= 2;
+            buf = (char*)realloc(buf, cap);
+        }
+    }
+    if(n < 0) {
+        free(buf);
+        return false;
+    }
+    buf[size] = buf[size+1] = '\0';
+    self->buf = buf;
+    self->size = size;
+    self->mapped = 0;
+    return true;
+}
+
+// a private copy of text, for sources that are not files
+Source* newSource(const char *text, size_t len) {
+    Source *src = (Source*)malloc(sizeof(Source));
+    memset(src, 0, sizeof(Source));
+    src->buf = (char*)malloc(len + 2);
+    memcpy(src->buf, text, len);
+    src->buf[len] = src->buf[len+1] = '\0';
+    src->size = len;
+    return src;
+}
+
+static void buildLineIndex(Source *self) {
+    int cap = 1024;
+    self->lines = (int*)malloc(sizeof(int) * cap);
+    self->lineCnt = 0;
+    const char *p = self->buf, *end = self->buf + self->size;
+    while(true) {
+        if(self->lineCnt == cap) {
+            cap *= 2;
+            self->lines = (int*)realloc(self->lines, sizeof(int) * cap);
+        }
+        self->lines[self->lineCnt++] = p - self->buf;
+        const char *nl = (const char*)memchr(p, '\n', end - p);
+        if(!nl) break;
+        p = nl + 1;
+    }
+}
+
+// text of line lineno (1-based) without its line break, not '\0' terminated
+const char* SRC_line(Source *self, int lineno, int *len) {
+    if(!self->lines) {
+        buildLineIndex(self);
+    }
+    if(lineno < 1 || lineno > self->lineCnt) {
+        *len = 0;
+        return "";
+    }
+    int begin = self->lines[lineno-1];
+    int end = lineno < self->lineCnt ? self->lines[lineno] - 1 : (int)self->size;
+    if(end > begin && self->buf[end-1] == '\r') {
+        end--;
+    }
+    *len = end - begin;
+    return self->buf + begin;
+}
+
+void closeSource(Source *self) {
+    if(self->mapped) {
+        munmap(self->buf, self->mapped);
+    } else {
+        free(self->buf);
+    }
+    free(self->lines);
+    free(self);
+}
@@ -0,0 +1,23 @@
+#ifndef __SOURCE_H__
+#define __SOURCE_H__
+
+#include <stddef.h>
+
+typedef struct Source Source;
+
+// the whole source file, mapped read-write (private) so the lexer can scan
+// it in place. buf[size] and buf[size+1] are always '\0', as flex requires.
+struct Source {
+    char *buf;
+    size_t size;
+    size_t mapped;  // length of the mapping, 0 if buf is on the heap
+    int *lines;     // lines[i] is the offset of line i+1, built on demand
+    int lineCnt;
+};
+
+Source* openSource(const char *path);
+Source* newSource(const char *text, size_t len);
+const char* SRC_line(Source *self, int lineno, int *len);
+void closeSource(Source *self);
+
+#endif
@@ -0,0 +1,595 @@
+#include "ssa.h"
+#include "liveness.h"
+#include "context.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Renamer Renamer;
+
+// stacks of the current name of every slot, all in one array: an entry
+// links to the one it hides, and is popped when its block is left
+struct Renamer {
+    CompilerContext *ctx;
+    SSA *ssa;
+    Liveness *liveness;
+    Operand *slotOp;    // the operand of each slot
+    int *top;   // entry of the current name of each slot, -1 if none
+    Operand *names;
+    int *prev;
+    int *slots;
+    int cnt;
+    int cap;
+    int defCap;     // of ssa->defCode
+};
+
+static int* dominanceFrontiers(CFG *cfg, int **start);
+static int placePhis(IRFunc *func, Liveness *liveness, int **phiBlock, int **phiSlot);
+static void insertPhis(SSA *self, CFG *cfg, int phiCnt, int *phiBlock, int *phiSlot, Operand *slotOp);
+static void renameAll(Renamer *self, CFG *cfg);
+static void renameBlock(Renamer *self, CFG *cfg, int b);
+static Operand newName(Renamer *self, int slot, Operand op, int code);
+static void findAssigned(SSA *self);
+static void emitCopies(SSA *self, int b, Operand *copyOf, IR *codes, int *cnt);
+static void emitInserted(SSA *self, int *start, int *order, int place, IR *codes, int *cnt);
+
+bool isSSAName(SSA *self, Operand op) {
+    return op.kind == OP_TEMP && (int)op.id >= self->nameBase && (int)op.id < self->nameBase + self->nameCnt;
+}
+
+Operand* phiArgs(SSA *self, IR *phi) {
+    assert(phi->kind == IR_PHI);
+    return self->phiArgs + phi->arg1.id;
+}
+
+// an operand whose value is fixed once it is defined
+bool isFixed(SSA *self, Operand op) {
+    if(op.kind == OP_CONST || isSSAName(self, op)) return true;
+    return (op.kind == OP_TEMP || op.kind == OP_VAR) && !HT_find(self->assigned, op);
+}
+
+int defBlock(SSA *self, Operand name) {
+    int code = self->defCode[name.id - self->nameBase];
+    return code >= 0 ? self->cfg->codeBlock[code] : insertedBlock(self, -1 - code);
+}
+
+// a code inserted at the top of a block counts as one of the block before
+int insertedBlock(SSA *self, int k) {
+    int at = self->insertedAt[k];
+    return at & 1 ? at >> 1 : (at >> 1) - 1;
+}
+
+// the code goes at the top of the block, before its first code, or at its
+// end, before a jump ending it. a code at the top runs only when the block
+// before falls through into it
+void insertCode(SSA *self, int block, bool atEnd, IR *code) {
+    if(self->insertedCnt == self->insertedCap) {
+        self->insertedCap = self->insertedCap ? self->insertedCap * 2 : 16;
+        self->inserted = (IR*)realloc(self->inserted, sizeof(IR) * self->insertedCap);
+        self->insertedAt = (int*)realloc(self->insertedAt, sizeof(int) * self->insertedCap);
+    }
+    self->inserted[self->insertedCnt] = *code;
+    self->insertedAt[self->insertedCnt] = block * 2 + atEnd;
+    self->insertedCnt++;
+    Operand *def = defOperand(code);
+    if(def && isSSAName(self, *def)) {
+        self->defCode[def->id - self->nameBase] = -self->insertedCnt;
+    } else if(def) {
+        HT_insert(self->assigned, *def, self->inserted + self->insertedCnt - 1);
+    }
+}
+
+// the block before the header, when it is the only way into the loop and
+// falls through into the header. codes at the top of the header run once
+// each time the loop is entered
+int loopEntry(SSA *self, Loop *loop) {
+    IRFunc *func = self->func;
+    CFG *cfg = self->cfg;
+    BasicBlock *header = cfg->blocks + loop->header;
+    int entry = loop->header - 1;
+    bool entered = false;
+    if(entry < 0 || CFG_inLoop(cfg, entry, loop)) return -1;
+    for(int k = 0; k < header->predCnt; k++) {
+        int pred = header->preds[k];
+        if(pred == entry) {
+            entered = true;
+        } else if(!CFG_inLoop(cfg, pred, loop)) {
+            return -1;
+        }
+    }
+    BasicBlock *block = cfg->blocks + entry;
+    for(int i = block->last - 1; i >= block->first; i--) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        // a jump to the header would go over its top
+        if(p->kind == IR_GOTO) return -1;
+        if(p->kind == IR_RELOP && CFG_labelBlock(cfg, p->result.id) == loop->header) return -1;
+        break;
+    }
+    return entered ? entry : -1;
+}
+
+bool isInvariant(SSA *self, Loop *loop, Operand op) {
+    if(!isFixed(self, op)) return false;
+    return !isSSAName(self, op) || !CFG_inLoop(self->cfg, defBlock(self, op), loop);
+}
+
+// the passes which need SSA form run between building and leaving it
+void ssaOptimize(CompilerContext *ctx, IRFunc *func) {
+    SSA *ssa = buildSSA(ctx, func);
+    SCCP(ctx, ssa);
+    GVN(ctx, ssa);
+    LICM(ctx, ssa);
+    reduceStrength(ctx, ssa);
+    leaveSSA(ctx, ssa);
+}
+
+// Cytron et al. with phis pruned by liveness: a variable gets a phi only
+// where it is live in. names are given in a walk of the dominator tree
+SSA* buildSSA(CompilerContext *ctx, IRFunc *func) {
+    SSA *self = (SSA*)malloc(sizeof(SSA));
+    memset(self, 0, sizeof(SSA));
+    self->func = func;
+    invalidateCFG(func);    // a kept graph may have blocks whose first code was removed
+    Liveness *liveness = computeLiveness(func);
+    CFG *cfg = liveness->cfg;
+    Operand *slotOp = (Operand*)malloc(sizeof(Operand) * (liveness->varCnt + 1));
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        if(p->kind == IR_DEAD) continue;
+        Operand ops[3] = { p->result, p->arg1, p->arg2 };
+        for(int k = 0; k < 3; k++) {
+            int slot = liveSlot(liveness, ops[k]);
+            if(slot >= 0) {
+                slotOp[slot] = ops[k];
+            }
+        }
+    }
+    int *phiBlock, *phiSlot;
+    int phiCnt = placePhis(func, liveness, &phiBlock, &phiSlot);
+    insertPhis(self, cfg, phiCnt, phiBlock, phiSlot, slotOp);
+    free(phiBlock);
+    free(phiSlot);
+
+    // same leaders, so the same blocks in the same order
+    int blockCnt = cfg->blockCnt;
+    cfg = getCFG(func);
+    assert(cfg->blockCnt == blockCnt);
+    self->cfg = cfg;
+    func->cfg = NULL;
+    Renamer renamer;
+    memset(&renamer, 0, sizeof(Renamer));
+    renamer.ctx = ctx;
+    renamer.ssa = self;
+    renamer.liveness = liveness;
+    renamer.slotOp = slotOp;
+    self->nameBase = ctx->tmpId;
+    renameAll(&renamer, cfg);
+    free(slotOp);
+    freeLiveness(liveness);
+    self->assigned = newHashTable();
+    findAssigned(self);
+    return self;
+}
+
+// frontier of block b is df[start[b] .. start[b + 1]), unreachable blocks
+// have none. runners go from the preds of a join up to its idom
+static int* dominanceFrontiers(CFG *cfg, int **start) {
+    int n = cfg->blockCnt;
+    int *last = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));   // join last added to a frontier
+    int *pos = (int*)calloc(n + 1, sizeof(int));
+    int *df = NULL;
+    for(int pass = 0; pass < 2; pass++) {
+        memset(last, -1, sizeof(int) * n);
+        for(int b = 0; b < n; b++) {
+            BasicBlock *block = cfg->blocks + b;
+            if(block->rpo < 0 || block->predCnt < 2) continue;
+            for(int k = 0; k < block->predCnt; k++) {
+                int runner = block->preds[k];
+                if(cfg->blocks[runner].rpo < 0) continue;
+                while(runner != block->idom && last[runner] != b) {
+                    last[runner] = b;
+                    if(pass == 0) {
+                        pos[runner + 1]++;
+                    } else {
+                        df[pos[runner]++] = b;
+                    }
+                    runner = cfg->blocks[runner].idom;
+                }
+            }
+        }
+        if(pass == 0) {
+            for(int b = 0; b < n; b++) {
+                pos[b + 1] += pos[b];
+            }
+            df = (int*)malloc(sizeof(int) * (pos[n] > 0 ? pos[n] : 1));
+        }
+    }
+    // filling moved every start to the next one
+    memmove(pos + 1, pos, sizeof(int) * n);
+    pos[0] = 0;
+    free(last);
+    *start = pos;
+    return df;
+}
+
+// phis go to the iterated frontier of the blocks defining a slot, where the
+// slot is live in. returns their count, in no order
+static int placePhis(IRFunc *func, Liveness *liveness, int **phiBlock, int **phiSlot) {
+    CFG *cfg = liveness->cfg;
+    int n = cfg->blockCnt, varCnt = liveness->varCnt;
+    int *dfStart;
+    int *df = dominanceFrontiers(cfg, &dfStart);
+    // blocks defining each slot, a block once per def
+    int *defStart = (int*)calloc(varCnt + 1, sizeof(int));
+    int *defBlocks = NULL;
+    for(int pass = 0; pass < 2; pass++) {
+        for(int b = 0; b < n; b++) {
+            BasicBlock *block = cfg->blocks + b;
+            if(block->rpo < 0) continue;
+            for(int i = block->first; i < block->last; i++) {
+                IR *p = func->codes + i;
+                Operand *def;
+                if(p->kind == IR_DEAD || !(def = defOperand(p))) continue;
+                int slot = liveSlot(liveness, *def);
+                if(slot < 0) continue;
+                if(pass == 0) {
+                    defStart[slot + 1]++;
+                } else {
+                    defBlocks[defStart[slot]++] = b;
+                }
+            }
+        }
+        if(pass == 0) {
+            for(int v = 0; v < varCnt; v++) {
+                defStart[v + 1] += defStart[v];
+            }
+            defBlocks = (int*)malloc(sizeof(int) * (defStart[varCnt] > 0 ? defStart[varCnt] : 1));
+        }
+    }
+    memmove(defStart + 1, defStart, sizeof(int) * varCnt);
+    defStart[0] = 0;
+
+    int *hasPhi = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));     // last slot + 1 given a phi in the block
+    int *queued = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));     // last slot + 1 which queued the block
+    int *work = (int*)malloc(sizeof(int) * (n > 0 ? n : 1));
+    memset(hasPhi, 0, sizeof(int) * n);
+    memset(queued, 0, sizeof(int) * n);
+    int cnt = 0, cap = 16;
+    *phiBlock = (int*)malloc(sizeof(int) * cap);
+    *phiSlot = (int*)malloc(sizeof(int) * cap);
+    for(int v = 0; v < varCnt; v++) {
+        int top = 0;
+        for(int i = defStart[v]; i < defStart[v + 1]; i++) {
+            int b = defBlocks[i];
+            if(queued[b] != v + 1) {
+                queued[b] = v + 1;
+                work[top++] = b;
+            }
+        }
+        while(top > 0) {
+            int x = work[--top];
+            for(int i = dfStart[x]; i < dfStart[x + 1]; i++) {
+                int y = df[i];
+                if(hasPhi[y] == v + 1 || !BV_test(liveness->in + y, v)) continue;
+                hasPhi[y] = v + 1;
+                if(cnt == cap) {
+                    cap *= 2;
+                    *phiBlock = (int*)realloc(*phiBlock, sizeof(int) * cap);
+                    *phiSlot = (int*)realloc(*phiSlot, sizeof(int) * cap);
+                }
+                (*phiBlock)[cnt] = y;
+                (*phiSlot)[cnt] = v;
+                cnt++;
+                if(queued[y] != v + 1) {
+                    queued[y] = v + 1;
+                    work[top++] = y;
+                }
+            }
+        }
+    }
+    free(hasPhi);
+    free(queued);
+    free(work);
+    free(defStart);
+    free(defBlocks);
+    free(df);
+    free(dfStart);
+    return cnt;
+}
+
+// the phis of a block follow its first code. a PHI keeps its slot in arg2
+// until it is named
+static void insertPhis(SSA *self, CFG *cfg, int phiCnt, int *phiBlock, int *phiSlot, Operand *slotOp) {
+    IRFunc *func = self->func;
+    int n = cfg->blockCnt;
+    int *start = (int*)calloc(n + 1, sizeof(int));
+    int *order = (int*)malloc(sizeof(int) * (phiCnt > 0 ? phiCnt : 1));
+    for(int i = 0; i < phiCnt; i++) {
+        start[phiBlock[i] + 1]++;
+    }
+    for(int b = 0; b < n; b++) {
+        start[b + 1] += start[b];
+    }
+    for(int i = 0; i < phiCnt; i++) {
+        order[start[phiBlock[i]]++] = i;
+    }
+    memmove(start + 1, start, sizeof(int) * n);
+    start[0] = 0;
+    for(int i = 0; i < phiCnt; i++) {
+        self->phiArgCnt += cfg->blocks[phiBlock[i]].predCnt;
+    }
+    self->phiArgs = (Operand*)malloc(sizeof(Operand) * (self->phiArgCnt > 0 ? self->phiArgCnt : 1));
+    for(int i = 0; i < self->phiArgCnt; i++) {
+        self->phiArgs[i].kind = OP_INV;
+        self->phiArgs[i].id = 0;
+    }
+
+    int cap = func->cnt - func->dead + phiCnt;
+    IR *codes = (IR*)malloc(sizeof(IR) * (cap > 0 ? cap : 1));
+    int cnt = 0, argCnt = 0;
+    for(int b = 0; b < n; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        for(int i = block->first; i < block->last; i++) {
+            if(func->codes[i].kind == IR_DEAD) continue;
+            codes[cnt++] = func->codes[i];
+            if(i != block->first) continue;
+            for(int k = start[b]; k < start[b + 1]; k++) {
+                IR *phi = codes + cnt++;
+                memset(phi, 0, sizeof(IR));
+                phi->kind = IR_PHI;
+                phi->result = slotOp[phiSlot[order[k]]];
+                phi->arg1.kind = OP_INV;
+                phi->arg1.id = argCnt;
+                phi->arg2.kind = OP_INV;
+                phi->arg2.id = phiSlot[order[k]];
+                argCnt += block->predCnt;
+            }
+        }
+    }
+    assert(cnt == cap);
+    setCodes(func, codes, cnt, cap);
+    free(start);
+    free(order);
+}
+
+// preorder walk of the dominator tree, a block's names are popped once
+// the walk leaves the blocks it dominates
+static void renameAll(Renamer *self, CFG *cfg) {
+    int varCnt = self->liveness->varCnt;
+    self->top = (int*)malloc(sizeof(int) * (varCnt > 0 ? varCnt : 1));
+    memset(self->top, -1, sizeof(int) * varCnt);
+    self->cap = 64;
+    self->names = (Operand*)malloc(sizeof(Operand) * self->cap);
+    self->prev = (int*)malloc(sizeof(int) * self->cap);
+    self->slots = (int*)malloc(sizeof(int) * self->cap);
+    int *open = (int*)malloc(sizeof(int) * cfg->orderCnt);
+    int *mark = (int*)malloc(sizeof(int) * cfg->orderCnt);     // names pushed before each open block
+    int depth = 0;
+    for(int i = 0; i < cfg->orderCnt; i++) {
+        int b = cfg->domOrder[i];
+        while(depth > 0 && !CFG_dominates(cfg, open[depth - 1], b)) {
+            depth--;
+            while(self->cnt > mark[depth]) {
+                self->cnt--;
+                self->top[self->slots[self->cnt]] = self->prev[self->cnt];
+            }
+        }
+        open[depth] = b;
+        mark[depth++] = self->cnt;
+        renameBlock(self, cfg, b);
+    }
+    self->ssa->nameCnt = self->ctx->tmpId - self->ssa->nameBase;
+    free(open);
+    free(mark);
+    free(self->top);
+    free(self->names);
+    free(self->prev);
+    free(self->slots);
+}
+
+// uses take the current names, defs push new ones, then the phis of the
+// successors take their argument for the edge from b
+static void renameBlock(Renamer *self, CFG *cfg, int b) {
+    IRFunc *func = self->ssa->func;
+    BasicBlock *block = cfg->blocks + b;
+    for(int i = block->first; i < block->last; i++) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        if(p->kind == IR_PHI) {
+            p->result = newName(self, p->arg2.id, tempOperand(self->ctx), i);
+            continue;
+        }
+        Operand *uses[2], *def;
+        int cnt = useOperands(p, uses);
+        for(int k = 0; k < cnt; k++) {
+            int slot = liveSlot(self->liveness, *uses[k]);
+            if(slot >= 0 && self->top[slot] >= 0) {
+                *uses[k] = self->names[self->top[slot]];
+            }
+        }
+        if((def = defOperand(p))) {
+            int slot = liveSlot(self->liveness, *def);
+            if(slot >= 0) {
+                *def = newName(self, slot, p->kind == IR_PARM ? *def : tempOperand(self->ctx), i);
+            }
+        }
+    }
+    for(int k = 0; k < block->succCnt; k++) {
+        BasicBlock *succ = cfg->blocks + block->succ[k];
+        int j = 0;
+        while(succ->preds[j] != b) {
+            j++;
+        }
+        for(int i = succ->first + 1; i < succ->last && func->codes[i].kind == IR_PHI; i++) {
+            int slot = func->codes[i].arg2.id;
+            Operand *args = phiArgs(self->ssa, func->codes + i);
+            args[j] = self->top[slot] >= 0 ? self->names[self->top[slot]] : self->slotOp[slot];
+        }
+    }
+}
+
+// variables assigned by codes, and those whose address is taken. the rest
+// of the operands which are no SSA names are parameters and variables read
+// before any def, which keep their value through the function
+static void findAssigned(SSA *self) {
+    IRFunc *func = self->func;
+    for(IR *p = func->codes; p < func->codes + func->cnt; p++) {
+        Operand *def;
+        if(p->kind == IR_DEAD || p->kind == IR_PARM) continue;
+        if(p->kind == IR_DEC) {
+            HT_insert(self->assigned, p->result, p);
+        } else if(p->kind == IR_REF) {
+            HT_insert(self->assigned, p->arg1, p);
+        }
+        if((def = defOperand(p)) && !isSSAName(self, *def)) {
+            HT_insert(self->assigned, *def, p);
+        }
+    }
+}
+
+// a parameter keeps its operand, any other def gets a fresh temp
+static Operand newName(Renamer *self, int slot, Operand name, int code) {
+    SSA *ssa = self->ssa;
+    if(self->cnt == self->cap) {
+        self->cap *= 2;
+        self->names = (Operand*)realloc(self->names, sizeof(Operand) * self->cap);
+        self->prev = (int*)realloc(self->prev, sizeof(int) * self->cap);
+        self->slots = (int*)realloc(self->slots, sizeof(int) * self->cap);
+    }
+    self->names[self->cnt] = name;
+    self->prev[self->cnt] = self->top[slot];
+    self->slots[self->cnt] = slot;
+    self->top[slot] = self->cnt++;
+    if(name.kind == OP_TEMP && (int)name.id >= ssa->nameBase) {
+        int i = name.id - ssa->nameBase;
+        if(i >= self->defCap) {
+            self->defCap = self->defCap ? self->defCap * 2 : 64;
+            while(self->defCap <= i) {
+                self->defCap *= 2;
+            }
+            ssa->defCode = (int*)realloc(ssa->defCode, sizeof(int) * self->defCap);
+        }
+        ssa->defCode[i] = code;
+    }
+    return name;
+}
+
+// Sreedhar's method I: x := phi(a1, .., an) becomes x' := ai at the end of
+// each pred and x := x' at the top of the block. through the fresh x' no
+// copy clobbers a value another copy or a branch still reads, so edges need
+// no splitting
+void leaveSSA(CompilerContext *ctx, SSA *self) {
+    IRFunc *func = self->func;
+    CFG *cfg = self->cfg;
+    Operand *copyOf = (Operand*)malloc(sizeof(Operand) * (func->cnt > 0 ? func->cnt : 1));
+    int cap = func->cnt - func->dead + self->insertedCnt;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        for(int i = block->first; i < block->last; i++) {
+            IR *p = func->codes + i;
+            if(p->kind != IR_PHI) continue;
+            copyOf[i] = tempOperand(ctx);
+            Operand *args = phiArgs(self, p);
+            for(int k = 0; k < block->predCnt; k++) {
+                cap += args[k].kind != OP_INV;
+            }
+        }
+    }
+    // inserted codes by place, in the order they came
+    int places = cfg->blockCnt * 2;
+    int *start = (int*)calloc(places + 1, sizeof(int));
+    int *order = (int*)malloc(sizeof(int) * (self->insertedCnt > 0 ? self->insertedCnt : 1));
+    for(int i = 0; i < self->insertedCnt; i++) {
+        start[self->insertedAt[i] + 1]++;
+    }
+    for(int i = 0; i < places; i++) {
+        start[i + 1] += start[i];
+    }
+    for(int i = 0; i < self->insertedCnt; i++) {
+        order[start[self->insertedAt[i]]++] = i;
+    }
+    memmove(start + 1, start, sizeof(int) * places);
+    start[0] = 0;
+
+    IR *codes = (IR*)malloc(sizeof(IR) * (cap > 0 ? cap : 1));
+    int cnt = 0;
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        emitInserted(self, start, order, b * 2, codes, &cnt);
+        int jump = -1;  // copies go before a jump ending the block
+        for(int i = block->last - 1; i >= block->first; i--) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            if(p->kind == IR_GOTO || p->kind == IR_RELOP) {
+                jump = i;
+            }
+            break;
+        }
+        for(int i = block->first; i < block->last; i++) {
+            IR *p = func->codes + i;
+            if(i == jump) {
+                emitCopies(self, b, copyOf, codes, &cnt);
+                emitInserted(self, start, order, b * 2 + 1, codes, &cnt);
+            }
+            if(p->kind == IR_DEAD) continue;
+            if(p->kind == IR_PHI) {
+                IR *copy = codes + cnt++;
+                memset(copy, 0, sizeof(IR));
+                copy->kind = IR_ASSIGN;
+                copy->result = p->result;
+                copy->arg1 = copyOf[i];
+            } else {
+                codes[cnt++] = *p;
+            }
+        }
+        if(jump < 0) {
+            emitCopies(self, b, copyOf, codes, &cnt);
+            emitInserted(self, start, order, b * 2 + 1, codes, &cnt);
+        }
+    }
+    assert(cnt <= cap);
+    setCodes(func, codes, cnt, cap);
+    free(copyOf);
+    free(start);
+    free(order);
+    freeCFG(self->cfg);
+    free(self->defCode);
+    free(self->phiArgs);
+    free(self->inserted);
+    free(self->insertedAt);
+    HT_clear(self->assigned);
+    free(self->assigned);
+    free(self);
+}
+
+// x' := ai for the phis of the successors of b
+static void emitCopies(SSA *self, int b, Operand *copyOf, IR *codes, int *cnt) {
+    IRFunc *func = self->func;
+    CFG *cfg = self->cfg;
+    BasicBlock *block = cfg->blocks + b;
+    for(int k = 0; k < block->succCnt; k++) {
+        BasicBlock *succ = cfg->blocks + block->succ[k];
+        int j = 0;
+        while(succ->preds[j] != b) {
+            j++;
+        }
+        for(int i = succ->first + 1; i < succ->last; i++) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            if(p->kind != IR_PHI) break;
+            Operand arg = phiArgs(self, p)[j];
+            if(arg.kind == OP_INV) continue;
+            IR *copy = codes + (*cnt)++;
+            memset(copy, 0, sizeof(IR));
+            copy->kind = IR_ASSIGN;
+            copy->result = copyOf[i];
+            copy->arg1 = arg;
+        }
+    }
+}
+
+static void emitInserted(SSA *self, int *start, int *order, int place, IR *codes, int *cnt) {
+    for(int k = start[place]; k < start[place + 1]; k++) {
+        codes[(*cnt)++] = self->inserted[order[k]];
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef __SSA_H__
+#define __SSA_H__
+
+#include "ir.h"
+#include "cfg.h"
+#include "hash_table.h"
+
+typedef struct SSA SSA;
+
+// a function in SSA form: every tracked temp and variable (see liveness.h)
+// is assigned once, by a fresh temp, except a parameter which keeps its
+// name. a use no definition reaches keeps the old operand.
+// a PHI at the top of a block takes one argument per predecessor, in the
+// order of the block's preds; arg1.id is the offset of its arguments in
+// phiArgs. an argument of OP_INV comes by an edge which is never taken.
+// passes in SSA form may remove codes and resolve RELOPs, but not add a
+// block or an edge; the graph stays the one the form was built on. codes
+// they add are kept aside by insertCode until the form is left
+struct SSA {
+    IRFunc *func;
+    CFG *cfg;       // owned by the form, func->cfg is not kept while in it
+    int nameBase;   // the fresh temps are nameBase .. nameBase + nameCnt - 1
+    int nameCnt;
+    int *defCode;   // the code which defines fresh temp nameBase + i, -1 - k for inserted code k
+    Operand *phiArgs;
+    int phiArgCnt;
+    HashTable *assigned;    // operands which may change outside SSA form
+    IR *inserted;
+    int *insertedAt;    // block * 2, plus 1 for the end of the block
+    int insertedCnt;
+    int insertedCap;
+};
+
+SSA* buildSSA(CompilerContext *ctx, IRFunc *func);
+void leaveSSA(CompilerContext *ctx, SSA *self);     // back to copies, frees self
+bool isSSAName(SSA *self, Operand op);
+Operand* phiArgs(SSA *self, IR *phi);   // one per pred of the PHI's block
+bool isFixed(SSA *self, Operand op);
+int defBlock(SSA *self, Operand name);
+void insertCode(SSA *self, int block, bool atEnd, IR *code);
+int insertedBlock(SSA *self, int k);
+int loopEntry(SSA *self, Loop *loop);   // -1 if the loop has no single entry
+bool isInvariant(SSA *self, Loop *loop, Operand op);
+void SCCP(CompilerContext *ctx, SSA *self);
+void GVN(CompilerContext *ctx, SSA *self);
+void LICM(CompilerContext *ctx, SSA *self);
+void reduceStrength(CompilerContext *ctx, SSA *self);
+void ssaOptimize(CompilerContext *ctx, IRFunc *func);
+
+#endif
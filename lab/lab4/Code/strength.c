@@ -0,0 +1,307 @@
+#include "ssa.h"
+#include "context.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Induction Induction;
+typedef struct Linear Linear;
+typedef struct Reduction Reduction;
+
+// i := phi(init, next) at a header, where next := i + step on every way
+// back into the header
+struct Induction {
+    Operand name;
+    Operand init;
+    int step;
+};
+
+// a name which is scale * i + base for an induction variable i, base OP_INV
+// when there is none
+struct Linear {
+    int code;   // in func->codes, -1 - k for inserted code k
+    int iv;
+    int scale;
+    Operand base;
+    int derived;    // linear names computed from this one
+};
+
+struct Reduction {
+    CompilerContext *ctx;
+    SSA *ssa;
+    int *useCnt;    // of each SSA name
+    int *ivOf;      // induction of each SSA name, -1 if none
+    int *linOf;     // linear name of each SSA name, -1 if none
+    Induction *ivs;
+    int ivCnt;
+    Linear *lins;
+    int linCnt;
+};
+
+static void countUses(Reduction *self);
+static int findInductions(Reduction *self, Loop *loop, int entry);
+static void findLinears(Reduction *self, Loop *loop);
+static void addLinear(Reduction *self, Loop *loop, int code);
+static void reduceLinear(Reduction *self, Loop *loop, int entry, Linear *lin);
+static void setCode(IR *code, IRKind kind, Operand result, Operand arg1, Operand arg2);
+static IR* codeAt(Reduction *self, int code);
+static int nameIndex(Reduction *self, Operand op);
+
+// strength reduction of the addresses of array scans: t := i * c, and
+// base + t over it, become a variable of their own set once where the loop
+// is entered and bumped by step * c where i is, so the loop keeps no
+// multiply. the variable is no SSA name, so this runs last in the form
+void reduceStrength(CompilerContext *ctx, SSA *ssa) {
+    Reduction self;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    memset(&self, 0, sizeof(Reduction));
+    self.ctx = ctx;
+    self.ssa = ssa;
+    int n = ssa->nameCnt > 0 ? ssa->nameCnt : 1;
+    self.useCnt = (int*)calloc(n, sizeof(int));
+    self.ivOf = (int*)malloc(sizeof(int) * n);
+    self.linOf = (int*)malloc(sizeof(int) * n);
+    memset(self.ivOf, -1, sizeof(int) * n);
+    memset(self.linOf, -1, sizeof(int) * n);
+    self.ivs = (Induction*)malloc(sizeof(Induction) * (func->cnt + 1));
+    self.lins = (Linear*)malloc(sizeof(Linear) * (func->cnt + ssa->insertedCnt + 1));
+    countUses(&self);
+    for(int l = 0; l < cfg->loopCnt; l++) {
+        Loop *loop = cfg->loops + l;
+        int entry = loopEntry(ssa, loop);
+        if(entry < 0 || !findInductions(&self, loop, entry)) continue;
+        findLinears(&self, loop);
+        for(int i = 0; i < self.linCnt; i++) {
+            Linear *lin = self.lins + i;
+            if(lin->base.kind == OP_INV && self.useCnt[nameIndex(&self, codeAt(&self, lin->code)->result)] == lin->derived) continue;
+            reduceLinear(&self, loop, entry, lin);
+        }
+        for(int i = 0; i < self.ivCnt; i++) {
+            self.ivOf[nameIndex(&self, self.ivs[i].name)] = -1;
+        }
+        for(int i = 0; i < self.linCnt; i++) {
+            self.linOf[nameIndex(&self, codeAt(&self, self.lins[i].code)->result)] = -1;
+        }
+        self.ivCnt = 0;
+        self.linCnt = 0;
+    }
+    free(self.useCnt);
+    free(self.ivOf);
+    free(self.linOf);
+    free(self.ivs);
+    free(self.lins);
+}
+
+// uses by codes, inserted ones too, and by phi arguments
+static void countUses(Reduction *self) {
+    SSA *ssa = self->ssa;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    Operand *uses[2];
+    for(int i = 0; i < ssa->insertedCnt; i++) {
+        int cnt = useOperands(ssa->inserted + i, uses);
+        for(int k = 0; k < cnt; k++) {
+            if(isSSAName(ssa, *uses[k])) {
+                self->useCnt[nameIndex(self, *uses[k])]++;
+            }
+        }
+    }
+    for(int b = 0; b < cfg->blockCnt; b++) {
+        BasicBlock *block = cfg->blocks + b;
+        for(int i = block->first; i < block->last; i++) {
+            IR *p = func->codes + i;
+            if(p->kind == IR_DEAD) continue;
+            if(p->kind == IR_PHI) {
+                Operand *args = phiArgs(ssa, p);
+                for(int k = 0; k < block->predCnt; k++) {
+                    if(isSSAName(ssa, args[k])) {
+                        self->useCnt[nameIndex(self, args[k])]++;
+                    }
+                }
+                continue;
+            }
+            int cnt = useOperands(p, uses);
+            for(int k = 0; k < cnt; k++) {
+                if(isSSAName(ssa, *uses[k])) {
+                    self->useCnt[nameIndex(self, *uses[k])]++;
+                }
+            }
+        }
+    }
+}
+
+// the phis of the header whose arguments on the back edges are all one
+// i + step. every back edge must leave its block for the header or the
+// loop, or the bumps put at the ends of those blocks would run inside it
+static int findInductions(Reduction *self, Loop *loop, int entry) {
+    SSA *ssa = self->ssa;
+    IRFunc *func = ssa->func;
+    CFG *cfg = ssa->cfg;
+    BasicBlock *header = cfg->blocks + loop->header;
+    int j = 0;
+    while(header->preds[j] != entry) {
+        j++;
+    }
+    for(int k = 0; k < header->predCnt; k++) {
+        BasicBlock *latch = cfg->blocks + header->preds[k];
+        if(k == j) continue;
+        for(int s = 0; s < latch->succCnt; s++) {
+            if(latch->succ[s] != loop->header && CFG_inLoop(cfg, latch->succ[s], loop)) return 0;
+        }
+    }
+    for(int i = header->first + 1; i < header->last; i++) {
+        IR *phi = func->codes + i;
+        if(phi->kind == IR_DEAD) continue;
+        if(phi->kind != IR_PHI) break;
+        Operand *args = phiArgs(ssa, phi);
+        Operand next;
+        next.kind = OP_INV;
+        next.id = 0;
+        bool same = true;
+        for(int k = 0; k < header->predCnt; k++) {
+            if(k == j || args[k].kind == OP_INV) continue;
+            if(next.kind == OP_INV) {
+                next = args[k];
+            } else if(!isOperandEqual(next, args[k])) {
+                same = false;
+            }
+        }
+        if(!same || args[j].kind == OP_INV || !isSSAName(ssa, next)) continue;
+        int def = ssa->defCode[nameIndex(self, next)];
+        if(def < 0 || !CFG_inLoop(cfg, cfg->codeBlock[def], loop)) continue;
+        IR *p = func->codes + def;
+        Operand step;
+        if(p->kind == IR_ADD && p->arg1.kind == OP_CONST && isOperandEqual(p->arg2, phi->result)) {
+            step = p->arg1;
+        } else if(p->kind == IR_ADD && p->arg2.kind == OP_CONST && isOperandEqual(p->arg1, phi->result)) {
+            step = p->arg2;
+        } else if(p->kind == IR_SUB && p->arg2.kind == OP_CONST && isOperandEqual(p->arg1, phi->result)) {
+            step = p->arg2;
+        } else {
+            continue;
+        }
+        Induction *iv = self->ivs + self->ivCnt;
+        iv->name = phi->result;
+        iv->init = args[j];
+        iv->step = constValue(self->ctx, step);
+        if(p->kind == IR_SUB) {
+            foldArith(IR_SUB, 0, iv->step, &iv->step);
+        }
+        self->ivOf[nameIndex(self, phi->result)] = self->ivCnt++;
+    }
+    return self->ivCnt;
+}
+
+// codes moved out of inner loops come first, being computed before the
+// codes left in the loop
+static void findLinears(Reduction *self, Loop *loop) {
+    SSA *ssa = self->ssa;
+    CFG *cfg = ssa->cfg;
+    for(int k = 0; k < ssa->insertedCnt; k++) {
+        if(CFG_inLoop(cfg, insertedBlock(ssa, k), loop)) {
+            addLinear(self, loop, -1 - k);
+        }
+    }
+    for(int i = 0; i < cfg->orderCnt; i++) {
+        int b = cfg->order[i];
+        if(!CFG_inLoop(cfg, b, loop)) continue;
+        BasicBlock *block = cfg->blocks + b;
+        for(int k = block->first; k < block->last; k++) {
+            addLinear(self, loop, k);
+        }
+    }
+}
+
+// t := i * c or c * i, and u := t + base or base + t for an invariant base
+static void addLinear(Reduction *self, Loop *loop, int code) {
+    SSA *ssa = self->ssa;
+    IR *p = codeAt(self, code);
+    if((p->kind != IR_MUL && p->kind != IR_ADD) || !isSSAName(ssa, p->result)) return;
+    Operand ops[2] = { p->arg1, p->arg2 };
+    for(int k = 0; k < 2; k++) {
+        Operand op = ops[k], other = ops[1 - k];
+        if(!isSSAName(ssa, op)) continue;
+        Linear *lin = self->lins + self->linCnt;
+        if(p->kind == IR_MUL && self->ivOf[nameIndex(self, op)] >= 0 && other.kind == OP_CONST) {
+            lin->iv = self->ivOf[nameIndex(self, op)];
+            lin->scale = constValue(self->ctx, other);
+            lin->base.kind = OP_INV;
+            lin->base.id = 0;
+        } else if(p->kind == IR_ADD && self->linOf[nameIndex(self, op)] >= 0
+                && self->lins[self->linOf[nameIndex(self, op)]].base.kind == OP_INV
+                && isInvariant(ssa, loop, other)) {
+            Linear *from = self->lins + self->linOf[nameIndex(self, op)];
+            from->derived++;
+            lin->iv = from->iv;
+            lin->scale = from->scale;
+            lin->base = other;
+        } else {
+            continue;
+        }
+        lin->code = code;
+        lin->derived = 0;
+        self->linOf[nameIndex(self, p->result)] = self->linCnt++;
+        return;
+    }
+}
+
+// v := init * scale + base at the top of the header, v := step * scale + v
+// at the end of every block going back to it, and the code becomes a copy
+// of v
+static void reduceLinear(Reduction *self, Loop *loop, int entry, Linear *lin) {
+    SSA *ssa = self->ssa;
+    CFG *cfg = ssa->cfg;
+    CompilerContext *ctx = self->ctx;
+    Induction *iv = self->ivs + lin->iv;
+    Operand v = tempOperand(ctx), none;
+    none.kind = OP_INV;
+    none.id = 0;
+    IR code;
+    if(iv->init.kind == OP_CONST) {
+        int start;
+        foldArith(IR_MUL, constValue(ctx, iv->init), lin->scale, &start);
+        Operand first = constOperand(ctx, start);
+        if(lin->base.kind == OP_INV) {
+            setCode(&code, IR_ASSIGN, v, first, none);
+        } else if(start == 0) {
+            setCode(&code, IR_ASSIGN, v, lin->base, none);
+        } else {
+            setCode(&code, IR_ADD, v, first, lin->base);
+        }
+        insertCode(ssa, loop->header, false, &code);
+    } else {
+        setCode(&code, IR_MUL, v, iv->init, constOperand(ctx, lin->scale));
+        insertCode(ssa, loop->header, false, &code);
+        if(lin->base.kind != OP_INV) {
+            setCode(&code, IR_ADD, v, lin->base, v);
+            insertCode(ssa, loop->header, false, &code);
+        }
+    }
+    int bump;
+    foldArith(IR_MUL, iv->step, lin->scale, &bump);
+    BasicBlock *header = cfg->blocks + loop->header;
+    for(int k = 0; k < header->predCnt; k++) {
+        if(header->preds[k] == entry) continue;
+        setCode(&code, IR_ADD, v, constOperand(ctx, bump), v);
+        insertCode(ssa, header->preds[k], true, &code);
+    }
+    IR *p = codeAt(self, lin->code);
+    setCode(p, IR_ASSIGN, p->result, v, none);
+    ctx->optStats.reduced++;
+}
+
+static void setCode(IR *code, IRKind kind, Operand result, Operand arg1, Operand arg2) {
+    memset(code, 0, sizeof(IR));
+    code->kind = kind;
+    code->result = result;
+    code->arg1 = arg1;
+    code->arg2 = arg2;
+}
+
+static IR* codeAt(Reduction *self, int code) {
+    return code >= 0 ? self->ssa->func->codes + code : self->ssa->inserted + (-1 - code);
+}
+
+static int nameIndex(Reduction *self, Operand op) {
+    return op.id - self->ssa->nameBase;
+}
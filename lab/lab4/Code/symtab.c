@@ -0,0 +1,165 @@
+#include "symtab.h"
+#include "semantic.h"
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+static Symbol deleted;
+#define ST_DELETED (&deleted)
+
+static unsigned hash(Atom name, int kind);
+static int probe(SymTable *self, Atom name, int kind, bool *found);
+static void rehash(SymTable *self);
+static void pushUndo(SymTable *self, Symbol *sym, Symbol *prev, int prevDepth);
+
+SymTable* newSymTable() {
+    SymTable *table = (SymTable*)malloc(sizeof(SymTable));
+    memset(table, 0, sizeof(SymTable));
+    table->capacity = ST_INIT_SIZE;
+    table->slots = (ST_Slot*)calloc(table->capacity, sizeof(ST_Slot));
+    table->scopeCap = 16;
+    table->scopes = (int*)malloc(sizeof(int) * table->scopeCap);
+    table->scopes[0] = 0;
+    return table;
+}
+
+// atoms are unique, so the address identifies the name
+static unsigned hash(Atom name, int kind) {
+    uintptr_t p = (uintptr_t)name >> 3;
+    return (unsigned)((p ^ (p >> 17)) * 2654435761u) ^ (unsigned)kind;
+}
+
+// slot of the key if found, otherwise the slot to insert it into
+static int probe(SymTable *self, Atom name, int kind, bool *found) {
+    unsigned mask = self->capacity - 1;
+    unsigned i = hash(name, kind) & mask;
+    int avail = -1;
+    while(self->slots[i].sym) {
+        Symbol *sym = self->slots[i].sym;
+        if(sym == ST_DELETED) {
+            if(avail < 0) avail = i;
+        } else if(sym->name == name && (int)sym->kind == kind) {
+            *found = true;
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    *found = false;
+    return avail >= 0 ? avail : (int)i;
+}
+
+// drop deleted slots, and grow if live slots need the room
+static void rehash(SymTable *self) {
+    ST_Slot *old = self->slots;
+    int oldCapacity = self->capacity;
+    if(self->live * 4 >= self->capacity) {
+        self->capacity *= 2;
+    }
+    self->slots = (ST_Slot*)calloc(self->capacity, sizeof(ST_Slot));
+    self->used = self->live;
+    for(int i = 0; i < oldCapacity; i++) {
+        if(!old[i].sym || old[i].sym == ST_DELETED) continue;
+        bool found;
+        int j = probe(self, old[i].sym->name, old[i].sym->kind, &found);
+        self->slots[j] = old[i];
+    }
+    free(old);
+}
+
+static void pushUndo(SymTable *self, Symbol *sym, Symbol *prev, int prevDepth) {
+    if(self->undoCnt == self->undoCap) {
+        self->undoCap = self->undoCap ? self->undoCap * 2 : 256;
+        self->undo = (ST_Undo*)realloc(self->undo, sizeof(ST_Undo) * self->undoCap);
+    }
+    ST_Undo *u = &self->undo[self->undoCnt++];
+    u->sym = sym;
+    u->prev = prev;
+    u->prevDepth = prevDepth;
+}
+
+// insert into the current scope, or into the global scope if global is set.
+// fails if the key is already defined in that scope.
+bool ST_insert(SymTable *self, Symbol *sym, bool global) {
+    if(2 * (self->used + 1) > self->capacity) {
+        rehash(self);
+    }
+    int depth = global ? 0 : self->depth;
+    bool found;
+    int i = probe(self, sym->name, sym->kind, &found);
+    ST_Slot *slot = &self->slots[i];
+    if(found) {
+        if(slot->depth == depth) return false;
+        // global symbols never shadow, only a local can hide an outer one
+        assert(slot->depth < depth);
+        pushUndo(self, sym, slot->sym, slot->depth);
+    } else {
+        if(!slot->sym) self->used++;
+        self->live++;
+        if(depth > 0) {
+            pushUndo(self, sym, NULL, 0);
+        }
+    }
+    slot->sym = sym;
+    slot->depth = depth;
+    return true;
+}
+
+Symbol* ST_find(SymTable *self, Atom name, int kind) {
+    bool found;
+    int i = probe(self, name, kind, &found);
+    return found ? self->slots[i].sym : NULL;
+}
+
+void ST_pushScope(SymTable *self) {
+    if(++self->depth == self->scopeCap) {
+        self->scopeCap *= 2;
+        self->scopes = (int*)realloc(self->scopes, sizeof(int) * self->scopeCap);
+    }
+    self->scopes[self->depth] = self->undoCnt;
+}
+
+// unwind the undo log of the scope, all its symbols leave the table at once
+void ST_popScope(SymTable *self) {
+    assert(self->depth > 0);
+    int base = self->scopes[self->depth];
+    while(self->undoCnt > base) {
+        ST_Undo *u = &self->undo[--self->undoCnt];
+        bool found;
+        int i = probe(self, u->sym->name, u->sym->kind, &found);
+        assert(found && self->slots[i].sym == u->sym);
+        if(u->prev) {
+            self->slots[i].sym = u->prev;
+            self->slots[i].depth = u->prevDepth;
+        } else {
+            self->slots[i].sym = ST_DELETED;
+            self->live--;
+        }
+        if(self->retiredCnt == self->retiredCap) {
+            self->retiredCap = self->retiredCap ? self->retiredCap * 2 : 256;
+            self->retired = (Symbol**)realloc(self->retired, sizeof(Symbol*) * self->retiredCap);
+        }
+        self->retired[self->retiredCnt++] = u->sym;
+    }
+    self->depth--;
+}
+
+// free every symbol ever inserted, and the table itself
+void ST_clear(SymTable *self, FreeSymbol freeSymbol) {
+    while(self->depth > 0) {
+        ST_popScope(self);
+    }
+    for(int i = 0; i < self->capacity; i++) {
+        Symbol *sym = self->slots[i].sym;
+        if(sym && sym != ST_DELETED) {
+            freeSymbol(sym);
+        }
+    }
+    for(int i = 0; i < self->retiredCnt; i++) {
+        freeSymbol(self->retired[i]);
+    }
+    free(self->slots);
+    free(self->undo);
+    free(self->scopes);
+    free(self->retired);
+    free(self);
+}
@@ -0,0 +1,48 @@
+#ifndef __SYMTAB_H__
+#define __SYMTAB_H__
+#include <stdlib.h>
+#include "common.h"
+#include "atom.h"
+
+#define ST_INIT_SIZE 0x400  // 1024 slots, power of two
+
+typedef struct Symbol Symbol;
+typedef struct ST_Slot ST_Slot;
+typedef struct ST_Undo ST_Undo;
+typedef struct SymTable SymTable;
+typedef void (*FreeSymbol)(Symbol *sym);
+
+// open addressing on (name, kind). a slot always holds the innermost
+// visible symbol of its key, the symbols it shadows are kept in the undo log.
+struct ST_Slot {
+    Symbol *sym;    // NULL: empty, ST_DELETED: removed by a scope pop
+    int depth;
+};
+
+struct ST_Undo {
+    Symbol *sym;    // inserted symbol
+    Symbol *prev;   // symbol it shadowed, NULL if none
+    int prevDepth;
+};
+
+struct SymTable {
+    ST_Slot *slots;
+    int capacity;
+    int live;   // slots holding a symbol
+    int used;   // live and deleted slots
+    ST_Undo *undo;
+    int undoCnt, undoCap;
+    int *scopes;    // first undo entry of each scope, scopes[0] is global
+    int depth, scopeCap;
+    Symbol **retired;   // symbols of popped scopes, AST nodes still refer to them
+    int retiredCnt, retiredCap;
+};
+
+SymTable* newSymTable();
+bool ST_insert(SymTable *self, Symbol *sym, bool global);
+Symbol* ST_find(SymTable *self, Atom name, int kind);
+void ST_pushScope(SymTable *self);
+void ST_popScope(SymTable *self);
+void ST_clear(SymTable *self, FreeSymbol freeSymbol);
+
+#endif
@@ -0,0 +1,90 @@
+#include "ir.h"
+#include "context.h"
+#include <assert.h>
+
+static bool isSelfTailCall(IRFunc *func, int i);
+
+// tail recursion elimination: a call of the function itself whose result
+// is returned right away becomes a jump back to a label after the
+// PARAMs, once the parameters take the arguments. the arguments are read
+// into fresh temps first, as one may read a parameter assigned before it.
+// a function with a DEC keeps its calls, an argument may be the address of
+// a local which every level of the recursion has apart
+void eliminateTailRecursion(CompilerContext *ctx, IRFunc *func) {
+    int paramCnt = 0, siteCnt = 0;
+    while(paramCnt + 1 < func->cnt && func->codes[paramCnt + 1].kind == IR_PARM) {
+        paramCnt++;
+    }
+    for(int i = 0; i < func->cnt; i++) {
+        if(func->codes[i].kind == IR_DEC) return;
+        siteCnt += isSelfTailCall(func, i);
+    }
+    if(siteCnt == 0) return;
+    int cap = func->cnt + 1 + siteCnt * (paramCnt + 1);
+    IR *codes = (IR*)malloc(sizeof(IR) * cap);
+    Operand start = labelOperand(ctx);
+    int cnt = 0;
+    for(int i = 0; i < func->cnt; i++) {
+        IR *p = func->codes + i;
+        if(p->kind == IR_DEAD) continue;
+        if(p->kind == IR_ARG) {
+            int k = i + 1;
+            while(func->codes[k].kind == IR_ARG) {
+                k++;
+            }
+            if(isSelfTailCall(func, k)) continue;
+        }
+        if(!isSelfTailCall(func, i)) {
+            codes[cnt++] = *p;
+            if(i == paramCnt) {
+                memset(codes + cnt, 0, sizeof(IR));
+                codes[cnt].kind = IR_LABEL;
+                codes[cnt++].arg1 = start;
+            }
+            continue;
+        }
+        // the ARG next to the CALL goes to the first PARAM
+        int first = cnt;
+        for(int k = 0; k < paramCnt; k++) {
+            IR *arg = p - 1 - k;
+            assert(arg->kind == IR_ARG);
+            memset(codes + cnt, 0, sizeof(IR));
+            codes[cnt].kind = IR_ASSIGN;
+            codes[cnt].result = tempOperand(ctx);
+            codes[cnt++].arg1 = arg->arg1;
+        }
+        for(int k = 0; k < paramCnt; k++) {
+            memset(codes + cnt, 0, sizeof(IR));
+            codes[cnt].kind = IR_ASSIGN;
+            codes[cnt].result = func->codes[1 + k].arg1;
+            codes[cnt++].arg1 = codes[first + k].result;
+        }
+        memset(codes + cnt, 0, sizeof(IR));
+        codes[cnt].kind = IR_GOTO;
+        codes[cnt++].arg1 = start;
+        // the RETURN after it is left in, no path reaches it
+        ctx->optStats.tailRecursions++;
+    }
+    assert(cnt <= cap);
+    relabelCodes(ctx, func, codes, cnt, cap);
+}
+
+// x := CALL f in f, with exactly one ARG per PARAM before it and RETURN x
+// after it
+static bool isSelfTailCall(IRFunc *func, int i) {
+    IR *p = func->codes + i;
+    if(p->kind != IR_CALL || p->arg1.id != func->codes[0].arg1.id) return false;
+    int argCnt = 0, paramCnt = 0;
+    while(argCnt < i && p[-1 - argCnt].kind == IR_ARG) {
+        argCnt++;
+    }
+    while(paramCnt + 1 < func->cnt && func->codes[paramCnt + 1].kind == IR_PARM) {
+        paramCnt++;
+    }
+    if(argCnt != paramCnt) return false;
+    int k = i + 1;
+    while(k < func->cnt && func->codes[k].kind == IR_DEAD) {
+        k++;
+    }
+    return k < func->cnt && func->codes[k].kind == IR_RET && isOperandEqual(func->codes[k].arg1, p->result);
+}
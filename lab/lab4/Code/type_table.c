@@ -0,0 +1,136 @@
+#include "type_table.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+static unsigned mix(unsigned h, const void *p);
+static unsigned hashType(Type *type);
+static bool sameClass(Type *canon, Type *type);
+static Type* newCanon(Type *type);
+static void grow(TypeTable *self);
+
+TypeTable* newTypeTable() {
+    TypeTable *self = (TypeTable*)malloc(sizeof(TypeTable));
+    memset(self, 0, sizeof(TypeTable));
+    return self;
+}
+
+static unsigned mix(unsigned h, const void *p) {
+    uintptr_t v = (uintptr_t)p >> 3;
+    return (h ^ (unsigned)(v ^ (v >> 29))) * 16777619u;
+}
+
+// computed from the canonical components, so equal classes hash equally
+static unsigned hashType(Type *type) {
+    unsigned h = 2166136261u ^ type->kind;
+    switch(type->kind) {
+        case BASIC:
+            h = (h ^ type->u.basic) * 16777619u;
+            break;
+        case ARRAY:
+            h = mix(h, type->u.array.elem->canon);
+            break;
+        case STRUCTURE:
+            for(FieldList *f = type->u.structure; f; f = f->next) {
+                h = mix(h, f->type->canon);
+            }
+            break;
+    }
+    return h;
+}
+
+static bool sameClass(Type *canon, Type *type) {
+    if(canon->kind != type->kind) return false;
+    switch(type->kind) {
+        case BASIC:
+            return canon->u.basic == type->u.basic;
+        case ARRAY:
+            return canon->u.array.elem == type->u.array.elem->canon;
+        case STRUCTURE: {
+            FieldList *f1 = canon->u.structure, *f2 = type->u.structure;
+            while(f1 && f2 && f1->type == f2->type->canon) {
+                f1 = f1->next;
+                f2 = f2->next;
+            }
+            return !f1 && !f2;
+        }
+    }
+    return false;
+}
+
+// a private copy made of canonical components, types of the program
+// may be freed before the table is
+static Type* newCanon(Type *type) {
+    Type *canon = (Type*)malloc(sizeof(Type));
+    *canon = *type;
+    canon->canon = canon;
+    canon->fieldIndex = NULL;   // classes are only compared, never searched
+    if(type->kind == ARRAY) {
+        canon->u.array.elem = type->u.array.elem->canon;
+    } else if(type->kind == STRUCTURE) {
+        FieldList **tail = &canon->u.structure;
+        for(FieldList *f = type->u.structure; f; f = f->next) {
+            FieldList *field = (FieldList*)malloc(sizeof(FieldList));
+            *field = *f;
+            field->type = f->type->canon;
+            *tail = field;
+            tail = &field->next;
+        }
+        *tail = NULL;
+    }
+    return canon;
+}
+
+static void grow(TypeTable *self) {
+    Type **old = self->slots;
+    unsigned oldCapacity = self->capacity;
+    unsigned capacity = oldCapacity ? oldCapacity * 2 : TT_INIT_SIZE;
+    Type **slots = (Type**)calloc(capacity, sizeof(Type*));
+    for(unsigned i = 0; i < oldCapacity; i++) {
+        if(!old[i]) continue;
+        unsigned j = hashType(old[i]) & (capacity - 1);
+        while(slots[j]) {
+            j = (j + 1) & (capacity - 1);
+        }
+        slots[j] = old[i];
+    }
+    free(old);
+    self->slots = slots;
+    self->capacity = capacity;
+}
+
+// components of type (element, field types) must already be canonicalized
+Type* TT_canon(TypeTable *self, Type *type) {
+    if(2 * (self->count + 1) > self->capacity) {
+        grow(self);
+    }
+    Type **slots = self->slots;
+    unsigned i = hashType(type) & (self->capacity - 1);
+    while(slots[i]) {
+        if(sameClass(slots[i], type)) {
+            return slots[i];
+        }
+        i = (i + 1) & (self->capacity - 1);
+    }
+    slots[i] = newCanon(type);
+    self->count++;
+    return slots[i];
+}
+
+// free the table and every canonical type
+void TT_clear(TypeTable *self) {
+    Type **slots = self->slots;
+    for(unsigned i = 0; i < self->capacity; i++) {
+        if(!slots[i]) continue;
+        FieldList *field = slots[i]->kind == STRUCTURE ? slots[i]->u.structure : NULL;
+        while(field) {
+            FieldList *p = field;
+            field = field->next;
+            free(p);
+        }
+        free(slots[i]);
+    }
+    free(slots);
+    free(self);
+}
@@ -0,0 +1,22 @@
+#ifndef __TYPE_TABLE_H__
+#define __TYPE_TABLE_H__
+
+#include "semantic.h"
+#define TT_INIT_SIZE 0x100  // 256 slots, power of two
+
+// hash-consing of type equivalence classes. types that typeEqual considers
+// equal (same kind, same basic type, arrays of equal element types, structures
+// whose field types are equal in order) share one canonical Type owned here.
+typedef struct TypeTable TypeTable;
+
+struct TypeTable {
+    Type **slots;
+    unsigned capacity;
+    unsigned count;
+};
+
+TypeTable* newTypeTable();
+Type* TT_canon(TypeTable *self, Type *type);
+void TT_clear(TypeTable *self);
+
+#endif
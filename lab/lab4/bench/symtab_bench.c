@@ -0,0 +1,95 @@
+#define _DEFAULT_SOURCE
+// lookups in the scoped symbol table against the RB tree it replaced, on
+// globals and locals with distinct names. build with make symtab_bench in
+// ../Code, then run ./symtab_bench [globals locals lookups]
+#include "symtab.h"
+#include "semantic.h"
+#include "rb_tree.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NAME_LEN 16
+
+static int symbolCmp(Symbol *symbol1, Symbol *symbol2);
+static void keepSymbol(Symbol *sym);
+static double now();
+
+int main(int argc, char *argv[]) {
+    int globalCnt = argc > 1 ? atoi(argv[1]) : 4000;
+    int localCnt = argc > 2 ? atoi(argv[2]) : 4000;
+    int lookupCnt = argc > 3 ? atoi(argv[3]) : 2000000;
+    int n = globalCnt + localCnt;
+    char (*names)[NAME_LEN] = malloc(sizeof(*names) * n);
+    Symbol *syms = (Symbol*)calloc(n, sizeof(Symbol));
+    int *picks = (int*)malloc(sizeof(int) * lookupCnt);
+    AtomTable *atoms = newAtomTable();
+    SymTable *table = newSymTable();
+    RB_Tree *tree = createRB_Tree(symbolCmp);
+    for(int i = 0; i < n; i++) {
+        snprintf(names[i], NAME_LEN, i < globalCnt ? "g%d" : "l%d", i);
+        syms[i].kind = SYM_VAR;
+        syms[i].name = AT_internStr(atoms, names[i]);
+        RB_insert(tree, syms + i);
+        if(i == globalCnt) {
+            ST_pushScope(table);
+        }
+        ST_insert(table, syms + i, i < globalCnt);
+    }
+    unsigned seed = 12345;
+    for(int k = 0; k < lookupCnt; k++) {
+        seed = seed * 1103515245u + 12345u;
+        picks[k] = (seed >> 8) % n;
+    }
+
+    // the tree compares the text of the names, as the old table did
+    long found = 0;
+    double t = now();
+    for(int k = 0; k < lookupCnt; k++) {
+        Symbol key = { SYM_VAR, names[picks[k]] };
+        found += RB_find(tree, &key) != NULL;
+    }
+    double rbTime = now() - t;
+    // the table takes atoms, which the scanner interns once per token
+    t = now();
+    for(int k = 0; k < lookupCnt; k++) {
+        found += ST_find(table, syms[picks[k]].name, SYM_VAR) != NULL;
+    }
+    double stTime = now() - t;
+    t = now();
+    for(int k = 0; k < lookupCnt; k++) {
+        found += ST_find(table, AT_internStr(atoms, names[picks[k]]), SYM_VAR) != NULL;
+    }
+    double internTime = now() - t;
+
+    printf("%d globals, %d locals, %d lookups, %ld found\n", globalCnt, localCnt, lookupCnt, found);
+    printf("RB_find:              %7.1f ns/op\n", rbTime * 1e9 / lookupCnt);
+    printf("ST_find:              %7.1f ns/op\n", stTime * 1e9 / lookupCnt);
+    printf("AT_internStr+ST_find: %7.1f ns/op\n", internTime * 1e9 / lookupCnt);
+    clearRB_Tree(tree, keepSymbol);
+    free(tree);
+    ST_clear(table, keepSymbol);
+    AT_clear(atoms);
+    free(names);
+    free(syms);
+    free(picks);
+    return 0;
+}
+
+static int symbolCmp(Symbol *symbol1, Symbol *symbol2) {
+    int r = strcmp(symbol1->name, symbol2->name);
+    if(r == 0) {
+        r = symbol1->kind - symbol2->kind;
+    }
+    return r;
+}
+
+// the symbols are in one array, freed at once
+static void keepSymbol(Symbol *sym) {
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
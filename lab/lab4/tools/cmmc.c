@@ -0,0 +1,113 @@
+#define _DEFAULT_SOURCE
+// compiles C-- files through libcmm, one thread per file, and writes the
+// assembly of a/b.cmm to outdir/b.s. make test checks it against parser.
+// build with make cmmc in ../Code, then run ./cmmc outdir file.cmm...
+#include "libcmm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct Job Job;
+
+struct Job {
+    const char *src;
+    char *dst;
+    int err;        // errors of cmm_compile, -1 if a file can't be used
+    bool threaded;  // else it was compiled on the main thread
+};
+
+static char* readAll(const char *path, size_t *len);
+static char* outputPath(const char *src, const char *outdir);
+static void* compileJob(void *arg);
+
+int main(int argc, char *argv[]) {
+    if(argc < 3) {
+        fprintf(stderr, "usage: %s outdir file.cmm...\n", argv[0]);
+        return 1;
+    }
+    int cnt = argc - 2;
+    Job *jobs = (Job*)calloc(cnt, sizeof(Job));
+    pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t) * cnt);
+    for(int i = 0; i < cnt; i++) {
+        jobs[i].src = argv[i + 2];
+        jobs[i].dst = outputPath(argv[i + 2], argv[1]);
+        jobs[i].threaded = pthread_create(threads + i, NULL, compileJob, jobs + i) == 0;
+        if(!jobs[i].threaded) {
+            compileJob(jobs + i);
+        }
+    }
+    int failed = 0;
+    for(int i = 0; i < cnt; i++) {
+        if(jobs[i].threaded) pthread_join(threads[i], NULL);
+        failed += jobs[i].err != 0;
+        free(jobs[i].dst);
+    }
+    free(threads);
+    free(jobs);
+    return failed ? 1 : 0;
+}
+
+// the whole file, NULL if it can't be read
+static char* readAll(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if(!fp) return NULL;
+    size_t cap = 4096;
+    char *buf = (char*)malloc(cap);
+    *len = 0;
+    size_t n;
+    while((n = fread(buf + *len, 1, cap - *len, fp)) > 0) {
+        *len += n;
+        if(*len == cap) {
+            cap *= 2;
+            buf = (char*)realloc(buf, cap);
+        }
+    }
+    fclose(fp);
+    return buf;
+}
+
+// outdir/ and the last part of src with .s in place of .cmm
+static char* outputPath(const char *src, const char *outdir) {
+    const char *base = strrchr(src, '/');
+    base = base ? base + 1 : src;
+    size_t len = strlen(base);
+    if(len > 4 && strcmp(base + len - 4, ".cmm") == 0) {
+        len -= 4;
+    }
+    char *dst = (char*)malloc(strlen(outdir) + len + 4);
+    sprintf(dst, "%s/%.*s.s", outdir, (int)len, base);
+    return dst;
+}
+
+static void* compileJob(void *arg) {
+    Job *job = (Job*)arg;
+    size_t len;
+    char *src = readAll(job->src, &len);
+    if(!src) {
+        perror(job->src);
+        job->err = -1;
+        return NULL;
+    }
+    CmmOptions options = {CMM_ASM, job->src};
+    CmmResult result;
+    job->err = cmm_compile(src, len, &options, &result);
+    free(src);
+    for(int i = 0; i < result.diagCnt; i++) {
+        CmmDiagnostic *diag = result.diags + i;
+        fprintf(stderr, "%s:%d: %s\n", job->src, diag->line, diag->message);
+    }
+    if(result.output) {
+        FILE *fp = fopen(job->dst, "w");
+        if(fp) {
+            fwrite(result.output, 1, result.outputLen, fp);
+            fclose(fp);
+        } else {
+            perror(job->dst);
+            job->err = -1;
+        }
+    }
+    cmm_free_result(&result);
+    return NULL;
+}
@@ -0,0 +1,354 @@
+// runs the MIPS32 assembly the compiler writes, as SPIM would: the program
+// reads its integers from stdin and prints to stdout, prompts included.
+// only the instructions oc.c emits are known. build with make mipsim in
+// ../Code, then run ./mipsim file.s < input
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#define STACK_TOP 0x7ffffffc
+#define STACK_WORDS (1 << 22)   // 16M of stack
+#define DATA_BASE 0x10010000
+#define STEP_MAX 1000000000LL   // taken as a program which never stops
+#define LINE_LEN 512
+#define NAME_LEN 64
+
+typedef enum {
+    OP_LI, OP_LA, OP_MOVE, OP_ADD, OP_ADDI, OP_SUB, OP_MUL, OP_DIV, OP_MFLO,
+    OP_LW, OP_SW, OP_J, OP_JAL, OP_JR, OP_BEQ, OP_BNE, OP_BLT, OP_BGT, OP_BLE,
+    OP_BGE, OP_SYSCALL
+} OpKind;
+
+typedef struct Inst Inst;
+typedef struct Label Label;
+
+// operands in the order they are written. an address off(reg) takes rs and
+// imm, a label is looked up once all of them are known
+struct Inst {
+    OpKind kind;
+    int rd, rs, rt;
+    int imm;
+    char label[NAME_LEN];
+    int target;     // instruction of label, or address of a string
+    int line;
+};
+
+struct Label {
+    char name[NAME_LEN];
+    int value;      // instruction index in .text, address in .data
+};
+
+static const char *opNames[] = {
+    "li", "la", "move", "add", "addi", "sub", "mul", "div", "mflo",
+    "lw", "sw", "j", "jal", "jr", "beq", "bne", "blt", "bgt", "ble",
+    "bge", "syscall"
+};
+static const char *regNames[] = {
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"
+};
+
+static Inst *insts;
+static int instCnt, instCap;
+static Label *labels;
+static int labelCnt, labelCap;
+static char data[1 << 16];
+static int dataLen;
+static const char *path;
+
+static void fail(int line, const char *msg, const char *what);
+static void addLabel(const char *name, int value);
+static int findLabel(const char *name);
+static int parseReg(char **s, int line);
+static int parseInt(char **s, int line);
+static void parseComma(char **s, int line);
+static void parseLine(char *s, int line, bool text);
+static void parseInst(char *s, int line);
+static void parseString(char *s, int line);
+static int* word(int *stack, unsigned addr, int line);
+static long long run(int *stack);
+
+int main(int argc, char *argv[]) {
+    if(argc != 2) {
+        fprintf(stderr, "Usage: %s file.s < input\n", argv[0]);
+        return 2;
+    }
+    path = argv[1];
+    FILE *in = fopen(path, "r");
+    if(!in) {
+        perror(path);
+        return 2;
+    }
+    char buf[LINE_LEN];
+    bool text = false;
+    for(int line = 1; fgets(buf, sizeof(buf), in); line++) {
+        char *s = buf;
+        while(isspace((unsigned char)*s)) s++;
+        if(strncmp(s, ".data", 5) == 0) {
+            text = false;
+        } else if(strncmp(s, ".text", 5) == 0) {
+            text = true;
+        } else if(*s != '.' && *s != '#') {
+            parseLine(s, line, text);
+        }
+    }
+    fclose(in);
+    for(int i = 0; i < instCnt; i++) {
+        if(insts[i].label[0]) {
+            insts[i].target = findLabel(insts[i].label);
+            if(insts[i].target < 0) fail(insts[i].line, "undefined label", insts[i].label);
+        }
+    }
+    int *stack = (int*)calloc(STACK_WORDS, sizeof(int));
+    long long steps = run(stack);
+    fflush(stdout);
+    fprintf(stderr, "%lld instructions\n", steps);
+    free(stack);
+    free(insts);
+    free(labels);
+    return 0;
+}
+
+static void fail(int line, const char *msg, const char *what) {
+    fflush(stdout);
+    fprintf(stderr, "%s:%d: %s%s%s\n", path, line, msg, what ? ": " : "", what ? what : "");
+    exit(1);
+}
+
+static void addLabel(const char *name, int value) {
+    if(labelCnt == labelCap) {
+        labelCap = labelCap ? 2 * labelCap : 64;
+        labels = (Label*)realloc(labels, sizeof(Label) * labelCap);
+    }
+    if(strlen(name) >= NAME_LEN) fail(0, "label too long", name);
+    strcpy(labels[labelCnt].name, name);
+    labels[labelCnt++].value = value;
+}
+
+// linear, a program has few labels and each is looked up once
+static int findLabel(const char *name) {
+    for(int i = 0; i < labelCnt; i++) {
+        if(strcmp(labels[i].name, name) == 0) return labels[i].value;
+    }
+    return -1;
+}
+
+static int parseReg(char **s, int line) {
+    while(isspace((unsigned char)**s)) (*s)++;
+    if(**s != '$') fail(line, "register expected", *s);
+    char *p = ++*s;
+    while(isalnum((unsigned char)**s)) (*s)++;
+    int len = *s - p;
+    if(len == 1 && *p == '0') return 0;
+    for(int r = 0; r < 32; r++) {
+        if((int)strlen(regNames[r]) == len && strncmp(regNames[r], p, len) == 0) return r;
+    }
+    fail(line, "unknown register", p);
+    return -1;
+}
+
+static int parseInt(char **s, int line) {
+    char *end;
+    long v = strtol(*s, &end, 10);
+    if(end == *s) fail(line, "number expected", *s);
+    *s = end;
+    return (int)v;
+}
+
+static void parseComma(char **s, int line) {
+    while(isspace((unsigned char)**s)) (*s)++;
+    if(**s != ',') fail(line, "',' expected", *s);
+    (*s)++;
+}
+
+// labels first, then an instruction or a string
+static void parseLine(char *s, int line, bool text) {
+    for(;;) {
+        char *p = s;
+        while(isalnum((unsigned char)*p) || *p == '_') p++;
+        if(p == s || *p != ':') break;
+        *p = '\0';
+        addLabel(s, text ? instCnt : DATA_BASE + dataLen);
+        s = p + 1;
+        while(isspace((unsigned char)*s)) s++;
+    }
+    if(!*s || *s == '#') return;
+    if(text) {
+        parseInst(s, line);
+    } else {
+        parseString(s, line);
+    }
+}
+
+static void parseInst(char *s, int line) {
+    if(instCnt == instCap) {
+        instCap = instCap ? 2 * instCap : 256;
+        insts = (Inst*)realloc(insts, sizeof(Inst) * instCap);
+    }
+    Inst *inst = insts + instCnt++;
+    memset(inst, 0, sizeof(Inst));
+    inst->line = line;
+    char *p = s;
+    while(isalpha((unsigned char)*p)) p++;
+    int len = p - s, kind = -1;
+    for(int k = 0; k <= OP_SYSCALL; k++) {
+        if((int)strlen(opNames[k]) == len && strncmp(opNames[k], s, len) == 0) kind = k;
+    }
+    if(kind < 0) fail(line, "unknown instruction", s);
+    inst->kind = (OpKind)kind;
+    s = p;
+    switch(inst->kind) {
+        case OP_LI:
+            inst->rd = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->imm = parseInt(&s, line);
+            break;
+        case OP_LA:
+        case OP_LW:
+        case OP_SW:
+            inst->rd = parseReg(&s, line);
+            parseComma(&s, line);
+            while(isspace((unsigned char)*s)) s++;
+            if(inst->kind == OP_LA && (isalpha((unsigned char)*s) || *s == '_')) {
+                sscanf(s, "%63[A-Za-z0-9_]", inst->label);
+                break;
+            }
+            inst->imm = parseInt(&s, line);
+            if(*s++ != '(') fail(line, "'(' expected", s - 1);
+            inst->rs = parseReg(&s, line);
+            break;
+        case OP_MOVE:
+        case OP_DIV:
+            inst->rd = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->rs = parseReg(&s, line);
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+            inst->rd = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->rs = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->rt = parseReg(&s, line);
+            break;
+        case OP_ADDI:
+            inst->rd = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->rs = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->imm = parseInt(&s, line);
+            break;
+        case OP_MFLO:
+        case OP_JR:
+            inst->rd = parseReg(&s, line);
+            break;
+        case OP_J:
+        case OP_JAL:
+            sscanf(s, " %63[A-Za-z0-9_]", inst->label);
+            break;
+        case OP_SYSCALL:
+            break;
+        default:    // branches
+            inst->rs = parseReg(&s, line);
+            parseComma(&s, line);
+            inst->rt = parseReg(&s, line);
+            parseComma(&s, line);
+            sscanf(s, " %63[A-Za-z0-9_]", inst->label);
+            break;
+    }
+}
+
+// .asciiz "..." with the escapes \n, \t, \" and \\, kept '\0' terminated
+static void parseString(char *s, int line) {
+    if(strncmp(s, ".asciiz", 7) != 0) fail(line, "only .asciiz is known", s);
+    s = strchr(s, '"');
+    if(!s) fail(line, "string expected", NULL);
+    for(s++; *s && *s != '"'; s++) {
+        char c = *s;
+        if(c == '\\') {
+            c = *++s;
+            c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+        }
+        if(dataLen + 2 >= (int)sizeof(data)) fail(line, "too much data", NULL);
+        data[dataLen++] = c;
+    }
+    data[dataLen++] = '\0';
+}
+
+// words below STACK_TOP, the stack and the arrays on it
+static int* word(int *stack, unsigned addr, int line) {
+    if(addr & 3 || addr > STACK_TOP || STACK_TOP - addr >= 4u * STACK_WORDS) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "0x%08x", addr);
+        fail(line, "bad address", buf);
+    }
+    return stack + (STACK_TOP - addr) / 4;
+}
+
+// main returns to a $ra of -1. arithmetic wraps as on the target
+static long long run(int *stack) {
+    int reg[32] = { 0 }, lo = 0;
+    reg[29] = reg[30] = STACK_TOP;
+    reg[31] = -1;
+    int pc = findLabel("main");
+    if(pc < 0) fail(0, "no main", NULL);
+    long long steps = 0;
+    while(pc != -1) {
+        if(pc < 0 || pc >= instCnt) fail(0, "jump out of the program", NULL);
+        if(++steps > STEP_MAX) fail(insts[pc].line, "too many instructions", NULL);
+        Inst *p = insts + pc++;
+        unsigned a = reg[p->rs], b = reg[p->rt];
+        switch(p->kind) {
+            case OP_LI: reg[p->rd] = p->imm; break;
+            case OP_LA: reg[p->rd] = p->label[0] ? p->target : (int)(a + p->imm); break;
+            case OP_MOVE: reg[p->rd] = reg[p->rs]; break;
+            case OP_ADD: reg[p->rd] = (int)(a + b); break;
+            case OP_ADDI: reg[p->rd] = (int)(a + (unsigned)p->imm); break;
+            case OP_SUB: reg[p->rd] = (int)(a - b); break;
+            case OP_MUL: reg[p->rd] = (int)(a * b); break;
+            case OP_DIV: {
+                int x = reg[p->rd], y = reg[p->rs];
+                if(y == 0) fail(p->line, "division by zero", NULL);
+                lo = y == -1 ? (int)(0u - (unsigned)x) : x / y;
+                break;
+            }
+            case OP_MFLO: reg[p->rd] = lo; break;
+            case OP_LW: reg[p->rd] = *word(stack, a + p->imm, p->line); break;
+            case OP_SW: *word(stack, a + p->imm, p->line) = reg[p->rd]; break;
+            case OP_J: pc = p->target; break;
+            case OP_JAL: reg[31] = pc; pc = p->target; break;
+            case OP_JR: pc = reg[p->rd]; break;
+            case OP_BEQ: if((int)a == (int)b) pc = p->target; break;
+            case OP_BNE: if((int)a != (int)b) pc = p->target; break;
+            case OP_BLT: if((int)a < (int)b) pc = p->target; break;
+            case OP_BGT: if((int)a > (int)b) pc = p->target; break;
+            case OP_BLE: if((int)a <= (int)b) pc = p->target; break;
+            case OP_BGE: if((int)a >= (int)b) pc = p->target; break;
+            case OP_SYSCALL:
+                switch(reg[2]) {
+                    case 1:
+                        printf("%d", reg[4]);
+                        break;
+                    case 4:
+                        if(reg[4] < DATA_BASE || reg[4] >= DATA_BASE + dataLen) fail(p->line, "bad string", NULL);
+                        fputs(data + (reg[4] - DATA_BASE), stdout);
+                        break;
+                    case 5:
+                        if(scanf("%d", &reg[2]) != 1) fail(p->line, "no integer to read", NULL);
+                        break;
+                    case 10:
+                        return steps;
+                    default:
+                        fail(p->line, "unknown syscall", NULL);
+                }
+                break;
+        }
+        reg[0] = 0;
+    }
+    return steps;
+}